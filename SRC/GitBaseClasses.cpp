@@ -4,7 +4,10 @@
 #include <boost/date_time/posix_time/posix_time.hpp>
 
 #include "GitBaseClasses.h"
-#include "GitItem.cpp"
+#include "details/Executor.h"
+#include "details/WorkerPool.h"
+#include "details/CommitHeaderParser.h"
+#include "details/RemoteCallbacksChain.h"
 
 namespace git_handler
 {
@@ -16,359 +19,1731 @@ namespace base
 ///////////////                 Commit                  //////////////////////
 //////////////////////////////////////////////////////////////////////////////
 
-commit_wrapper::commit_wrapper( std::unique_ptr< git_item_commit >&& commit ) : m_commit( std::move( commit ) )
+commit_wrapper::view_scope::view_scope( const commit_wrapper& commit ) noexcept :
+    m_commit( commit ),
+    m_was_pinned( commit.is_pinned() )
 {
 
 }
 
-git_oid commit_wrapper::id() const noexcept
+commit_wrapper::view_scope::~view_scope()
+{
+    if( !m_was_pinned )
+    {
+        m_commit.unpin();
+    }
+}
+
+commit_wrapper::commit_wrapper( std::unique_ptr< git_item_commit >&& commit ) :
+    commit_wrapper( git_item_commit{ commit ? commit->release() : nullptr } )
 {
-    git_oid id;
 
+}
+
+commit_wrapper::commit_wrapper( git_item_commit&& commit ) : m_commit( std::move( commit ) )
+{
     if( isValid() )
     {
-        const git_oid* cId = git_commit_id( m_commit->get() );
-        id = *cId;
+        m_id = *git_commit_id( m_commit.get() );
+        m_time = git_commit_author( m_commit.get() )->when;
     }
+}
+
+commit_wrapper::commit_wrapper( const git_oid& id, const git_time& time, std::shared_ptr< commit_cache > cache ) :
+    m_id( id ),
+    m_time( time ),
+    m_cache( std::move( cache ) )
+{
+
+}
+
+commit_wrapper::commit_wrapper( std::shared_ptr< const commit_metadata > metadata,
+                                const uint64_t index,
+                                std::shared_ptr< commit_cache > cache ) :
+    m_id( metadata->commit( index ).id ),
+    m_time( metadata->time( index ) ),
+    m_cache( std::move( cache ) ),
+    m_metadata( std::move( metadata ) ),
+    m_metadata_index( index )
+{
 
-    return id;
+}
+
+git_oid commit_wrapper::id() const noexcept
+{
+    return m_id;
 }
 
 git_time commit_wrapper::time() const noexcept
 {
-    git_time time;
+    return m_time;
+}
+
+std::string commit_wrapper::author() const noexcept
+{
+    std::string author;
+
+    if( m_metadata )
+    {
+        return m_metadata->author( m_metadata_index ).to_string();
+    }
+
+    auto commit = handle();
+    if( commit )
+    {
+        author = git_commit_author( commit->get() )->name;
+	}
+
+	return author;
+}
+
+std::string commit_wrapper::message() const noexcept
+{
+    std::string message;
+
+    if( m_metadata )
+    {
+        return m_metadata->message( m_metadata_index ).to_string();
+    }
+
+    auto commit = handle();
+    if( commit )
+    {
+        message = git_commit_message( commit->get() );
+	}
+
+	return message;
+}
+
+std::vector< git_oid > commit_wrapper::parents() const
+{
+    if( m_metadata )
+    {
+        return m_metadata->parents( m_metadata_index );
+    }
+
+    std::vector< git_oid > parents;
+
+    auto commit = handle();
+    if( commit )
+    {
+        const unsigned int count{ git_commit_parentcount( commit->get() ) };
+        parents.reserve( count );
+
+        for( unsigned int parent_num = 0; parent_num < count; ++parent_num )
+        {
+            parents.push_back( *git_commit_parent_id( commit->get(), parent_num ) );
+        }
+    }
+
+    return parents;
+}
+
+identity_table::identity_id commit_wrapper::author_id() const noexcept
+{
+    return m_author_id;
+}
+
+boost::string_view commit_wrapper::message_view() const noexcept
+{
+    if( m_metadata )
+    {
+        return m_metadata->message( m_metadata_index );
+    }
+
+    const git_commit* commit{ pinned_commit() };
+    return commit ? git_commit_message( commit ) : boost::string_view{};
+}
+
+boost::string_view commit_wrapper::summary_view() const noexcept
+{
+    auto message = message_view();
+
+    const auto first = message.find_first_not_of( " \t\r\n" );
+    if( first == boost::string_view::npos )
+    {
+        return {};
+    }
+
+    message.remove_prefix( first );
+
+    const auto line_end = message.find( '\n' );
+    if( line_end != boost::string_view::npos )
+    {
+        message = message.substr( 0, line_end );
+    }
+
+    // CRLF line endings
+    if( !message.empty() && message.back() == '\r' )
+    {
+        message.remove_suffix( 1 );
+    }
+
+    return message;
+}
+
+boost::string_view commit_wrapper::author_view() const noexcept
+{
+    if( m_metadata )
+    {
+        return m_metadata->author( m_metadata_index );
+    }
+
+    const git_commit* commit{ pinned_commit() };
+    return commit ? git_commit_author( commit )->name : boost::string_view{};
+}
+
+boost::string_view commit_wrapper::author_email_view() const noexcept
+{
+    if( m_metadata )
+    {
+        return m_metadata->email( m_metadata_index );
+    }
+
+    const git_commit* commit{ pinned_commit() };
+    return commit ? git_commit_author( commit )->email : boost::string_view{};
+}
+
+boost::string_view commit_wrapper::committer_view() const noexcept
+{
+    const git_commit* commit{ pinned_commit() };
+    return commit ? git_commit_committer( commit )->name : boost::string_view{};
+}
+
+boost::string_view commit_wrapper::committer_email_view() const noexcept
+{
+    const git_commit* commit{ pinned_commit() };
+    return commit ? git_commit_committer( commit )->email : boost::string_view{};
+}
+
+boost::string_view commit_wrapper::raw_header_view() const noexcept
+{
+    const git_commit* commit{ pinned_commit() };
+    return commit ? git_commit_raw_header( commit ) : boost::string_view{};
+}
+
+bool commit_wrapper::isValid() const noexcept
+{
+    return m_commit.get() != nullptr || m_cache != nullptr;
+}
+
+void commit_wrapper::unpin() const noexcept
+{
+    std::atomic_store( &m_pinned, commit_cache::commit_handle{} );
+}
+
+bool commit_wrapper::is_pinned() const noexcept
+{
+    return std::atomic_load( &m_pinned ) != nullptr;
+}
+
+bool commit_wrapper::is_lazy() const noexcept
+{
+    return m_cache != nullptr;
+}
+
+const git_commit* commit_wrapper::pinned_commit() const noexcept
+{
+    if( m_commit.get() )
+    {
+        return m_commit.get();
+    }
+
+    auto pinned = std::atomic_load( &m_pinned );
+    if( !pinned )
+    {
+        auto loaded = handle();
+        if( !loaded )
+        {
+            return nullptr;
+        }
+
+        // concurrent first views may load it twice, the first pinned one is kept
+        if( std::atomic_compare_exchange_strong( &m_pinned, &pinned, loaded ) )
+        {
+            pinned = std::move( loaded );
+        }
+    }
+
+    return pinned->get();
+}
+
+auto commit_wrapper::handle() const noexcept -> commit_cache::commit_handle
+{
+    if( m_commit.get() )
+    {
+        // non-owning handle to the commit kept by the wrapper itself
+        return commit_cache::commit_handle{ commit_cache::commit_handle{}, const_cast< git_item_commit* >( &m_commit ) };
+    }
+
+    if( m_cache )
+    {
+        try
+        {
+            return m_cache->get( m_id );
+        }
+        catch( ... )
+        {
+        }
+    }
+
+    return nullptr;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////               CommitStore               //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+commit_store::commit_store( std::shared_ptr< details::memory_pool > pool ) :
+    m_commits( 0, details::oid_hash{}, details::oid_equal{}, details::pool_allocator< commit_entry >( std::move( pool ) ) )
+{
+
+}
+
+auto commit_store::find( const git_oid& id ) const -> commit_ptr
+{
+    std::lock_guard< std::mutex > l{ m_mutex };
+
+    auto commit = m_commits.find( id );
+    if( commit != m_commits.end() )
+    {
+        return commit->second.lock();
+    }
+
+    return nullptr;
+}
+
+size_t commit_store::size() const noexcept
+{
+    std::lock_guard< std::mutex > l{ m_mutex };
+    return m_commits.size();
+}
+
+void commit_store::clear() noexcept
+{
+    std::lock_guard< std::mutex > l{ m_mutex };
+    m_commits.clear();
+}
+
+void commit_store::prune() noexcept
+{
+    std::lock_guard< std::mutex > l{ m_mutex };
+    prune_expired();
+}
+
+void commit_store::prune_expired() noexcept
+{
+    for( auto commit = m_commits.begin(); commit != m_commits.end(); )
+    {
+        if( commit->second.expired() )
+        {
+            commit = m_commits.erase( commit );
+        }
+        else
+        {
+            ++commit;
+        }
+    }
+
+    // keep the pruning cost amortized over the insertions
+    m_prune_threshold = std::max< size_t >( 1024, m_commits.size() * 2 );
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////                Branch                   //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+branch_wrapper::branch_wrapper( std::unique_ptr< git_item_ref >&& branch_ref,
+                const bool is_remote,
+                const std::shared_ptr< repo_wrapper > parent_repo ) :
+                m_is_remote( is_remote ),
+                m_parent_repo( parent_repo ),
+                m_branch_ref( std::move( branch_ref ) )
+{
+
+}
+
+git_oid branch_wrapper::tip() const noexcept
+{
+    return m_tip;
+}
+
+void branch_wrapper::add_commit( std::shared_ptr< commit_wrapper > commit )
+{
+    if( commit )
+    {
+        m_commits.add( { commit->time().time, commit->id(), std::move( commit ) } );
+    }
+}
+
+void branch_wrapper::add_commits( commit_storage::entries&& commits )
+{
+    m_commits.add( std::move( commits ) );
+}
+
+void branch_wrapper::clear_commits() noexcept
+{
+    m_commits.clear();
+    m_tip = git_oid{};
+    m_has_tip = false;
+    m_partial = false;
+}
+
+std::string branch_wrapper::name() const noexcept
+{
+    std::string name;
+
+    if( is_valid() )
+    {
+        const char* c_name{ nullptr };
+        if ( git_branch_name( &c_name, m_branch_ref->get() ) == 0 )
+        {
+            name = c_name;
+        }
+    }
+
+    return name;
+}
+
+std::string branch_wrapper::ref_name() const noexcept
+{
+    std::string name;
+
+    if( is_valid() )
+    {
+        name = git_reference_name( m_branch_ref->get() );
+    }
+
+    return name;
+}
+
+auto branch_wrapper::commits() const noexcept -> const commit_storage&
+{
+    return m_commits;
+}
+
+bool branch_wrapper::is_partial() const noexcept
+{
+    return m_partial;
+}
+
+bool branch_wrapper::is_remote() const noexcept
+{
+    return m_is_remote;
+}
+
+bool branch_wrapper::is_valid() const noexcept
+{
+    return m_branch_ref && m_branch_ref.get();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/////////////////                   Repo                  //////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+repo_wrapper::repo_wrapper( const std::string& repo_path,
+                            std::unique_ptr< git_item_repo >&& repo ) :
+                            m_pool( std::make_shared< details::memory_pool >() ),
+                            m_commits( m_pool ),
+                            m_commit_cache( std::make_shared< commit_cache >() ),
+                            m_local_path( repo_path),
+                            m_git_repo( std::move( repo ) )
+{
+    if( m_git_repo )
+    {
+        m_commit_cache->attach( m_git_repo->get() );
+    }
+}
+
+void repo_wrapper::open_local( const std::string& path )
+{
+    close();
+		
+    git_repository* r{ nullptr };
+    if( git_repository_open( &r, path.c_str() ) != 0 )
+    {
+        throw std::runtime_error{ "Could not open local repository " + path };
+    }
+
+    m_git_repo = item::make_item< git_item_repo >( r );
+    m_local_path = path;
+    m_commit_cache->attach( r );
+}
+
+void repo_wrapper::update_remotes( const git_fetch_options& fetch_opts )
+{
+    if( !is_valid() )
+    {
+        throw std::logic_error{ "Repository is not valid" };
+    }
+	
+    remotes_set remotes_list;
+    read_remotes_list( remotes_list );
+
+    if( !remotes_list.size() )
+    {
+        return;
+    }
+
+    for ( auto remote = m_remotes.begin(); remote != m_remotes.end(); )
+    {
+        if( !remotes_list.count( remote->first ) )
+        {
+            remote = m_remotes.erase( remote );
+            continue;
+        }
+		
+        remote++;
+    }
+
+    for( auto name : remotes_list )
+    {
+        auto remoteStor = m_remotes.find(name);
+        if ( remoteStor == m_remotes.end() )
+        {
+            git_remote* remote{ nullptr };
+            if( git_remote_lookup( &remote, m_git_repo->get(), name.c_str() ) != 0 )
+            {
+                throw std::logic_error{ "Could not find remote " + name };
+            }
+			
+            auto remotePtr = item::make_item< git_item_remote >( remote );
+
+            m_remotes.emplace( name, std::move( remotePtr ) );
+        }
+    }
+}
+
+void repo_wrapper::fetch( const git_fetch_options& fetch_opts, const cancel_token& cancel )
+{
+    if( !is_valid() )
+    {
+        throw std::logic_error{ "Repository is not valid" };
+    }
+
+    if( cancel.cancelled() )
+    {
+        throw operation_cancelled{ "Fetch cancelled" };
+    }
+
+    using clock = details::remote_callbacks_chain::clock;
+
+    m_fetch_stats = fetch_stats{};
+    m_fetch_stats.started = std::chrono::system_clock::now();
+    const auto start = clock::now();
+
+    update_remotes( fetch_opts );
+    m_fetch_stats.update_remotes = clock::now() - start;
+
+    for( auto& remote : m_remotes )
+    {
+        // the chain records the transfer and forwards the calls to the caller's callbacks
+        details::remote_callbacks_chain chain{ fetch_opts.callbacks, cancel };
+        git_fetch_options opts = fetch_opts;
+        opts.callbacks = chain.callbacks();
+
+        remote_fetch_stats remote_stats;
+        remote_stats.remote = remote.first;
+
+        chain.start();
+
+        if( m_skip_unchanged && remote_unchanged( remote.second->get(), opts ) )
+        {
+            git_remote_disconnect( remote.second->get() );
+
+            chain.fill( remote_stats );
+            remote_stats.skipped = true;
+            m_fetch_stats.remotes.push_back( std::move( remote_stats ) );
+            continue;
+        }
+
+        auto arr = aux::create_str_arr();
+        const int result{ git_remote_fetch( remote.second->get(), arr->get(), &opts, nullptr ) };
+        chain.fill( remote_stats );
+
+        m_fetch_stats.remotes.push_back( std::move( remote_stats ) );
+        m_fetch_stats.duration = clock::now() - start;
+
+        if( result != 0 && chain.cancelled() )
+        {
+            throw operation_cancelled{ "Fetch of remote " + remote.first + " cancelled" };
+        }
+
+        if( result != 0 )
+        {
+            throw std::logic_error{ "Could not fetch remote " + remote.first };
+        }
+    }
+
+    m_fetch_stats.duration = clock::now() - start;
+}
+
+void repo_wrapper::clone( const std::string& url, const std::string& path, const git_clone_options& clone_opts,
+                          const cancel_token& cancel )
+{
+    close();
+
+    if( cancel.cancelled() )
+    {
+        throw operation_cancelled{ "Clone cancelled" };
+    }
+
+    details::remote_callbacks_chain chain{ clone_opts.fetch_opts.callbacks, cancel };
+    git_clone_options opts = clone_opts;
+    opts.fetch_opts.callbacks = chain.callbacks();
+
+    m_fetch_stats = fetch_stats{};
+    m_fetch_stats.started = std::chrono::system_clock::now();
+
+    remote_fetch_stats remote_stats;
+    remote_stats.remote = "origin";
+
+    git_repository* r{ nullptr };
+
+    chain.start();
+    const int result{ git_clone( &r, url.c_str(), path.c_str(), &opts ) };
+    chain.fill( remote_stats );
+
+    m_fetch_stats.duration = remote_stats.duration;
+    m_fetch_stats.remotes.push_back( std::move( remote_stats ) );
+
+    if( result != 0 && chain.cancelled() )
+    {
+        throw operation_cancelled{ "Clone of " + url + " cancelled" };
+    }
+
+    if( result != 0 )
+    {
+        throw std::logic_error{ "Could not clone repository " + url };
+    }
+
+    m_git_repo = item::make_item< git_item_repo >( r );
+    m_local_path = path;
+    m_commit_cache->attach( r );
+}
+
+bool repo_wrapper::remote_unchanged( git_remote* remote, const git_fetch_options& fetch_opts ) const
+{
+    // a pruning fetch deletes the local refs the remote no longer has, which the advertisement doesn't tell
+    if( fetch_opts.prune == GIT_FETCH_PRUNE ||
+        ( fetch_opts.prune == GIT_FETCH_PRUNE_UNSPECIFIED && git_remote_prune_refs( remote ) ) )
+    {
+        return false;
+    }
+
+    const int download_tags{ fetch_opts.download_tags != GIT_REMOTE_DOWNLOAD_TAGS_UNSPECIFIED ?
+                             fetch_opts.download_tags : git_remote_autotag( remote ) };
+
+    // a failed connection is reported by the fetch itself
+    if( git_remote_connect( remote, GIT_DIRECTION_FETCH, &fetch_opts.callbacks,
+                            &fetch_opts.proxy_opts, &fetch_opts.custom_headers ) != 0 )
+    {
+        return false;
+    }
+
+    const git_remote_head** heads{ nullptr };
+    size_t heads_count{ 0 };
+    if( git_remote_ls( &heads, &heads_count, remote ) != 0 )
+    {
+        return false;
+    }
+
+    const size_t refspecs_count{ git_remote_refspec_count( remote ) };
+
+    for( size_t head_num = 0; head_num < heads_count; ++head_num )
+    {
+        const std::string name{ heads[ head_num ]->name };
+        std::string local_name;
+
+        if( name.compare( 0, 10, "refs/tags/" ) == 0 && download_tags != GIT_REMOTE_DOWNLOAD_TAGS_NONE )
+        {
+            // peeled tags only tell what the tag points to
+            if( boost::algorithm::ends_with( name, "^{}" ) )
+            {
+                continue;
+            }
+
+            local_name = name;
+        }
+        else
+        {
+            for( size_t refspec_num = 0; refspec_num < refspecs_count && local_name.empty(); ++refspec_num )
+            {
+                const git_refspec* refspec{ git_remote_get_refspec( remote, refspec_num ) };
+                if( git_refspec_direction( refspec ) != GIT_DIRECTION_FETCH || !git_refspec_src_matches( refspec, name.c_str() ) )
+                {
+                    continue;
+                }
+
+                git_buf buf{};
+                if( git_refspec_transform( &buf, refspec, name.c_str() ) == 0 )
+                {
+                    local_name.assign( buf.ptr, buf.size );
+                }
+
+                git_buf_dispose( &buf );
+            }
+
+            // not fetched at all
+            if( local_name.empty() )
+            {
+                continue;
+            }
+        }
+
+        git_oid local_id;
+        if( git_reference_name_to_id( &local_id, m_git_repo->get(), local_name.c_str() ) != 0 ||
+            !git_oid_equal( &local_id, &heads[ head_num ]->oid ) )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void repo_wrapper::set_skip_unchanged_fetches( const bool skip ) noexcept
+{
+    m_skip_unchanged = skip;
+}
+
+std::future< void > repo_wrapper::fetch_async( const git_fetch_options& fetch_opts, const cancel_token& cancel )
+{
+    completion_handler handler;
+    auto result = make_future( handler );
+
+    fetch_async( std::move( handler ), fetch_opts, cancel );
+    return result;
+}
+
+void repo_wrapper::fetch_async( completion_handler handler, const git_fetch_options& fetch_opts, const cancel_token& cancel )
+{
+    run_async( [ this, fetch_opts, cancel ](){ fetch( fetch_opts, cancel ); }, std::move( handler ) );
+}
+
+std::future< void > repo_wrapper::clone_async( const std::string& url, const std::string& path,
+                                               const git_clone_options& clone_opts, const cancel_token& cancel )
+{
+    completion_handler handler;
+    auto result = make_future( handler );
+
+    clone_async( std::move( handler ), url, path, clone_opts, cancel );
+    return result;
+}
+
+void repo_wrapper::clone_async( completion_handler handler, const std::string& url, const std::string& path,
+                                const git_clone_options& clone_opts, const cancel_token& cancel )
+{
+    run_async( [ this, url, path, clone_opts, cancel ](){ clone( url, path, clone_opts, cancel ); }, std::move( handler ) );
+}
+
+void repo_wrapper::run_async( std::function< void() > operation, completion_handler handler )
+{
+    details::executor::shared().post( [ operation, handler ]()
+                                      {
+                                          std::exception_ptr error;
+
+                                          try
+                                          {
+                                              operation();
+                                          }
+                                          catch( ... )
+                                          {
+                                              error = std::current_exception();
+                                          }
+
+                                          // the executor threads must not see the handler's exceptions
+                                          try
+                                          {
+                                              if( handler )
+                                              {
+                                                  handler( error );
+                                              }
+                                          }
+                                          catch( ... )
+                                          {
+                                          }
+                                      } );
+}
+
+std::future< void > repo_wrapper::make_future( completion_handler& handler )
+{
+    auto promise = std::make_shared< std::promise< void > >();
+
+    handler = [ promise ]( std::exception_ptr error )
+              {
+                  if( error )
+                  {
+                      promise->set_exception( error );
+                  }
+                  else
+                  {
+                      promise->set_value();
+                  }
+              };
+
+    return promise->get_future();
+}
+
+void repo_wrapper::close() noexcept
+{
+    m_worker_repos.clear();
+    m_commit_cache->attach( nullptr );
+    m_commits.clear();
+    m_metadata.reset();
+    m_metadata_path.clear();
+    m_diff_stats->clear();
+
+    if( m_reachability )
+    {
+        m_reachability->clear();
+    }
+    m_git_repo.reset();
+    m_local_path.clear();
+    m_remotes.clear();
+}
+
+std::map< std::string, std::string > repo_wrapper::remote_urls() const
+{
+    if( !is_valid() )
+    {
+        throw std::logic_error{ "Repository is not valid" };
+    }
+
+    auto remote_list = aux::create_str_arr();
+    if( git_remote_list( remote_list->get(), m_git_repo->get() ) != 0 )
+    {
+        throw std::logic_error{ "Could not get remotes list" };
+    }
+
+    std::map< std::string, std::string > urls;
+    for( size_t str_num = 0; str_num < remote_list->get()->count; ++str_num )
+    {
+        const char* name{ remote_list->get()->strings[ str_num ] };
+
+        git_remote* r{ nullptr };
+        if( git_remote_lookup( &r, m_git_repo->get(), name ) != 0 )
+        {
+            throw std::logic_error{ std::string{ "Could not find remote " } + name };
+        }
+
+        auto remote = item::make_item< git_item_remote >( r );
+        const char* url{ git_remote_url( r ) };
+        urls.emplace( name, url ? url : "" );
+    }
+
+    return urls;
+}
+
+void repo_wrapper::read_remotes_list( remotes_set& remotes_list )
+{
+    if( !is_valid() )
+    {
+        throw std::logic_error{ "Repository is not valid" };
+    }
+
+    auto remote_list = aux::create_str_arr();
+    if( git_remote_list( remote_list->get(), m_git_repo->get() ) != 0 )
+    {
+        throw std::logic_error{ "Could not get remotes list" };
+    }
+
+    for( size_t str_num = 0; str_num < remote_list->get()->count; ++str_num )
+    {
+        remotes_list.insert( remote_list->get()->strings[ str_num ] );
+    }				
+}
+
+void repo_wrapper::open_worker_repos( const size_t count )
+{
+    while( m_worker_repos.size() < count )
+    {
+        git_repository* r{ nullptr };
+        if( git_repository_open( &r, m_local_path.c_str() ) != 0 )
+        {
+            throw std::runtime_error{ "Could not open local repository " + m_local_path };
+        }
+
+        m_worker_repos.push_back( item::make_item< git_item_repo >( r ) );
+    }
+}
+
+bool repo_wrapper::is_valid() const noexcept
+{
+    return m_git_repo != nullptr &&
+           m_git_repo->get() != nullptr &&
+           m_local_path.length();
+}
+
+std::string repo_wrapper::path() const noexcept
+{
+    return m_local_path;
+}
+
+auto repo_wrapper::last_fetch_stats() const noexcept -> const fetch_stats&
+{
+    return m_fetch_stats;
+}
+
+
+void repo_wrapper::read_branch_commits( branch_wrapper* branch, const git_item_repo* repo )
+{
+    if( !is_valid() )
+    {
+        throw std::logic_error{ "Repository is not valid" };
+    }
+
+    if( !repo )
+    {
+        repo = m_git_repo.get();
+    }
+	
+    auto target = git_reference_target( branch->m_branch_ref->get() );
+    if( !target )
+    {
+        throw std::runtime_error{ "Could not get branch ref" };
+    }
+
+    git_oid tip = *target;
+
+    // first parent histories are partial, they neither take the saved commits nor feed the index
+    const bool full_history{ m_walk_strategy != walk_strategy::first_parent };
+    auto reachability = full_history ? m_reachability.get() : nullptr;
+
+    // a partial history can't be extended into a full one nor the other way round
+    if( branch->m_has_tip && branch->m_partial == full_history )
+    {
+        branch->clear_commits();
+    }
+
+    // commits saved by an earlier run are taken as if they had been read at the saved tip
+    if( !branch->m_has_tip && m_metadata && full_history )
+    {
+        read_saved_commits( branch );
+    }
+
+    // the old tip is only hidden if the history has been extended, force-pushes and rewrites are re-read entirely
+    bool incremental{ false };
+    if( branch->m_has_tip )
+    {
+        if( git_oid_equal( &tip, &branch->m_tip ) )
+        {
+            return;
+        }
+
+        // the index only takes complete histories, so a tip it doesn't know means a full read
+        incremental = git_graph_descendant_of( repo->get(), &tip, &branch->m_tip ) == 1 &&
+                      ( !reachability || reachability->contains( branch->m_tip ) );
+    }
+
+    if( !incremental )
+    {
+        branch->clear_commits();
+    }
+	   
+    git_revwalk* git_walker{ nullptr };
+
+    if( git_revwalk_new( &git_walker, repo->get() ) != 0 )
+    {
+        throw std::runtime_error{ "Could not create revwalk" };
+    }
+	
+    git_item_rev_walk walker{ git_walker };
+
+    // the storage sorts the commits by itself, so time ordered reads are left unsorted,
+    // which spares libgit2 sorting the graph
+    if( m_walk_strategy != walk_strategy::time )
+    {
+        commit_walk::set_sorting( walker.get(), m_walk_strategy );
+    }
+    git_revwalk_push( walker.get(), &tip );
+
+    if( incremental )
+    {
+        git_revwalk_hide( walker.get(), &branch->m_tip );
+    }
+
+    commit_storage::entries commits;
+    reachability_index::batch graph;
+
+    git_oid oid;
+    while ( git_revwalk_next( &oid, walker.get() ) == 0 )
+    {
+        auto commit = get_commit( oid, repo );
+        if( !commit )
+        {
+            branch->clear_commits();
+            throw std::logic_error{ "Could not read branch commits" };
+        }
+
+        if( reachability && !reachability->contains( oid ) )
+        {
+            graph.add( oid, commit->parents() );
+        }
+
+        commits.push_back( { commit->time().time, oid, std::move( commit ) } );
+    }
+
+    branch->add_commits( std::move( commits ) );
+
+    if( reachability )
+    {
+        reachability->add( graph );
+        reachability->set_tip( branch->ref_name(), tip );
+    }
+
+    branch->m_tip = tip;
+    branch->m_has_tip = true;
+    branch->m_partial = !full_history;
+}
+
+void repo_wrapper::read_saved_commits( branch_wrapper* branch )
+{
+    commit_metadata::ref_view ref;
+    if( !m_metadata->find_ref( branch->ref_name(), ref ) )
+    {
+        return;
+    }
+
+    commit_storage::entries commits;
+    commits.reserve( ref.last - ref.first );
+
+    reachability_index::batch graph;
+
+    for( auto index = ref.first; index != ref.last; ++index )
+    {
+        const auto& record = m_metadata->commit( *index );
+        auto commit = m_commits.get( record.id, [ & ]()
+                                     {
+                                         auto wrapper = make_commit( m_metadata, *index, m_commit_cache );
+                                         intern_author( *wrapper, m_metadata->author( *index ), m_metadata->email( *index ) );
+                                         return wrapper;
+                                     } );
+
+        if( m_reachability && !m_reachability->contains( record.id ) )
+        {
+            graph.add( record.id, m_metadata->parents( *index ) );
+        }
+
+        commits.push_back( { record.time, record.id, std::move( commit ) } );
+    }
+
+    branch->add_commits( std::move( commits ) );
+
+    if( m_reachability )
+    {
+        m_reachability->add( graph );
+        m_reachability->set_tip( branch->ref_name(), ref.tip );
+    }
+
+    branch->m_tip = ref.tip;
+    branch->m_has_tip = true;
+}
+
+void repo_wrapper::release_memory() noexcept
+{
+    m_commits.prune();
+    m_pool->trim();
+}
+
+void repo_wrapper::use_commit_metadata( const std::string& file_path )
+{
+    m_metadata_path = file_path;
+    m_metadata = commit_metadata::open( file_path );
+}
+
+void repo_wrapper::save_commit_metadata( const branches& storage ) const
+{
+    if( !is_valid() )
+    {
+        throw std::logic_error{ "Repository is not valid" };
+    }
+
+    if( m_metadata_path.empty() )
+    {
+        throw std::logic_error{ "No commit metadata file set" };
+    }
+
+    std::vector< commit_metadata::ref_source > refs;
+    refs.reserve( storage.size() );
+
+    for( const auto& branch : storage )
+    {
+        // branches that haven't been read have nothing to save, partial ones would be taken as full later
+        if( !branch.second->m_has_tip || branch.second->m_partial )
+        {
+            continue;
+        }
+
+        commit_metadata::ref_source ref;
+        ref.name = branch.second->ref_name();
+        ref.tip = branch.second->m_tip;
+        ref.commits.reserve( branch.second->commits().size() );
+
+        for( const auto& commit : branch.second->commits() )
+        {
+            ref.commits.push_back( commit.commit.get() );
+        }
+
+        refs.push_back( std::move( ref ) );
+    }
+
+    commit_metadata::write( m_metadata_path, refs );
+}
+
+void repo_wrapper::set_reachability_index( const bool enabled )
+{
+    if( !enabled )
+    {
+        m_reachability.reset();
+    }
+    else if( !m_reachability )
+    {
+        m_reachability = std::make_unique< reachability_index >();
+    }
+}
+
+void repo_wrapper::set_walk_strategy( const walk_strategy strategy ) noexcept
+{
+    m_walk_strategy = strategy;
+}
+
+walk_strategy repo_wrapper::get_walk_strategy() const noexcept
+{
+    return m_walk_strategy;
+}
+
+void repo_wrapper::set_identities( std::shared_ptr< identity_table > identities )
+{
+    m_identities = identities ? std::move( identities ) : std::make_shared< identity_table >();
+}
+
+auto repo_wrapper::identities() const noexcept -> const std::shared_ptr< identity_table >&
+{
+    return m_identities;
+}
+
+auto repo_wrapper::reachability() const noexcept -> const reachability_index*
+{
+    return m_reachability.get();
+}
+
+auto repo_wrapper::get_commit( const git_oid& id, const git_item_repo* repo ) -> commit_store::commit_ptr
+{
+    if( !repo )
+    {
+        repo = m_git_repo.get();
+    }
+
+    return m_commits.get( id, [ & ]() -> commit_store::commit_ptr
+                              {
+                                  if( m_lazy_commits && repo != m_git_repo.get() )
+                                  {
+                                      // the cache works with the main handle, a worker only needs the time
+                                      auto commit = aux::read_commit( repo, &id );
+                                      if( !commit )
+                                      {
+                                          return nullptr;
+                                      }
+
+                                      const git_signature* author{ git_commit_author( commit.get() ) };
+                                      auto wrapper = make_commit( id, author->when, m_commit_cache );
+                                      intern_author( *wrapper, author->name, author->email );
+                                      return wrapper;
+                                  }
+
+                                  if( m_lazy_commits )
+                                  {
+                                      // the lookup result stays in the cache, the wrapper only keeps what's cheap
+                                      auto commit = m_commit_cache->get( id );
+                                      if( !commit )
+                                      {
+                                          return nullptr;
+                                      }
+
+                                      const git_signature* author{ git_commit_author( commit->get() ) };
+                                      auto wrapper = make_commit( id, author->when, m_commit_cache );
+                                      intern_author( *wrapper, author->name, author->email );
+                                      return wrapper;
+                                  }
+
+                                  git_commit* commit{ nullptr };
+                                  if( git_commit_lookup( &commit, repo->get(), &id ) != 0 )
+                                  {
+                                      return nullptr;
+                                  }
+
+                                  auto wrapper = make_commit( git_item_commit{ commit } );
+                                  intern_author( *wrapper, wrapper->author_view(), wrapper->author_email_view() );
+                                  return wrapper;
+                              } );
+}
+
+template< typename... Args >
+std::shared_ptr< commit_wrapper > repo_wrapper::make_commit( Args&&... args )
+{
+    // the wrapper and its control block take one pooled block
+    return std::allocate_shared< commit_wrapper >( details::pool_allocator< commit_wrapper >( m_pool ),
+                                                   std::forward< Args >( args )... );
+}
+
+void repo_wrapper::intern_author( commit_wrapper& commit, const boost::string_view name, const boost::string_view email )
+{
+    commit.m_author_id = m_identities->intern( name, email );
+}
+
+void repo_wrapper::set_lazy_commits( const bool lazy, const size_t max_entries, const size_t max_bytes )
+{
+    m_lazy_commits = lazy;
+    m_commit_cache->set_limits( max_entries, max_bytes );
+}
+
+commit_walk repo_wrapper::walk( const std::string& ref_name, const walk_options& options )
+{
+    if( !is_valid() )
+    {
+        throw std::logic_error{ "Repository is not valid" };
+    }
+
+    git_reference* ref{ nullptr };
+    if( git_reference_dwim( &ref, m_git_repo->get(), ref_name.c_str() ) != 0 )
+    {
+        throw std::logic_error{ "Could not get reference for " + ref_name };
+    }
 
-    if( isValid() )
+    git_item_ref ref_item{ ref };
+
+    git_reference* resolved{ nullptr };
+    if( git_reference_resolve( &resolved, ref_item.get() ) != 0 )
     {
-        time = git_commit_author( m_commit->get() )->when;
+        throw std::logic_error{ "Could not resolve reference " + ref_name };
     }
 
-    return time;
+    ref_item.reset( resolved );
+
+    return walk( *git_reference_target( ref_item.get() ), options );
 }
 
-std::string commit_wrapper::author() const noexcept
+commit_walk repo_wrapper::walk( const git_oid& from, const walk_options& options )
 {
-    std::string author;
-
-    if( isValid() )
+    if( !is_valid() )
     {
-        author = git_commit_author( m_commit->get() )->name;
-	}
+        throw std::logic_error{ "Repository is not valid" };
+    }
 
-	return author;
-}
+    // libgit2 sorts the whole graph before yielding anything from a time sorted revwalk,
+    // hiding commits is the only case that needs it
+    if( options.strategy == walk_strategy::time && options.hide.empty() )
+    {
+        auto commit = get_commit( from );
+        if( !commit )
+        {
+            throw std::logic_error{ "Could not start the walk" };
+        }
 
-std::string commit_wrapper::message() const noexcept
-{
-    std::string message;
+        return commit_walk{ this, std::move( commit ), options };
+    }
 
-    if( isValid() )
+    git_revwalk* git_walker{ nullptr };
+    if( git_revwalk_new( &git_walker, m_git_repo->get() ) != 0 )
     {
-        message = git_commit_message( m_commit->get() );
-	}
+        throw std::runtime_error{ "Could not create revwalk" };
+    }
 
-	return message;
-}
+    git_item_rev_walk walker{ git_walker };
 
-bool commit_wrapper::isValid() const noexcept
-{
-    return m_commit != nullptr && m_commit->get() != nullptr;
-}
+    commit_walk::set_sorting( walker.get(), options.strategy );
 
-//////////////////////////////////////////////////////////////////////////////
-///////////////                Branch                   //////////////////////
-//////////////////////////////////////////////////////////////////////////////
+    if( git_revwalk_push( walker.get(), &from ) != 0 )
+    {
+        throw std::logic_error{ "Could not start the walk" };
+    }
 
-branch_wrapper::branch_wrapper( std::unique_ptr< git_item_ref >&& branch_ref,
-                const bool is_remote,
-                const std::shared_ptr< repo_wrapper > parent_repo ) :
-                m_is_remote( is_remote ),
-                m_parent_repo( parent_repo ),
-                m_branch_ref( std::move( branch_ref ) )
-{
+    for( const auto& hidden : options.hide )
+    {
+        git_revwalk_hide( walker.get(), &hidden );
+    }
 
+    return commit_walk{ this, std::move( walker ), options };
 }
 
-void branch_wrapper::add_commit( std::unique_ptr< commit_wrapper >&& commit )
+commit_headers repo_wrapper::read_commit_headers( const std::vector< git_oid >& ids, const size_t workers_count )
 {
-    commit_id id( commit->time().time, commit->message() );
-
-    if( !m_commits.count( id ) )
-    {
-        m_commits.emplace( id, std::move( commit ) );
-    }
+    return read_raw_commits( ids, workers_count, commit_headers{ m_identities } );
 }
 
-void branch_wrapper::clear_commits() noexcept
+commit_table repo_wrapper::read_commit_table( const std::vector< git_oid >& ids, const size_t workers_count )
 {
-    m_commits.clear();
+    return read_raw_commits( ids, workers_count, commit_table{ m_identities } );
 }
 
-std::string branch_wrapper::name() const noexcept
+commit_table repo_wrapper::read_commit_table( const branches& storage, const size_t workers_count )
 {
-    std::string name;
+    std::vector< git_oid > ids;
+    std::unordered_set< git_oid, details::oid_hash, details::oid_equal > known;
 
-    if( is_valid() )
+    // branches share most of their commits, each one is read once
+    for( const auto& branch : storage )
     {
-        const char* c_name{ nullptr };
-        if ( git_branch_name( &c_name, m_branch_ref->get() ) == 0 )
+        for( const auto& commit : branch.second->commits() )
         {
-            name = c_name;
+            if( known.insert( commit.id ).second )
+            {
+                ids.push_back( commit.id );
+            }
         }
     }
 
-    return name;
+    return read_commit_table( ids, workers_count );
 }
 
-auto branch_wrapper::commits() const noexcept -> const commit_storage&
+template< typename Batch >
+Batch repo_wrapper::read_raw_commits( const std::vector< git_oid >& ids, const size_t workers_count, const Batch& empty )
 {
-    return m_commits;
-}
+    if( !is_valid() )
+    {
+        throw std::logic_error{ "Repository is not valid" };
+    }
 
-bool branch_wrapper::is_remote() const noexcept
-{
-    return m_is_remote;
-}
+    // every chunk is parsed into its own batch, the batches are joined in order afterwards
+    const size_t chunk_size{ 1024 };
+    const size_t chunks_count{ ( ids.size() + chunk_size - 1 ) / chunk_size };
+    const size_t workers{ std::max< size_t >( 1, std::min( workers_count, chunks_count ) ) };
+    open_worker_repos( workers - 1 );
 
-bool branch_wrapper::is_valid() const noexcept
-{
-    return m_branch_ref && m_branch_ref.get();
-}
+    std::vector< git_item_odb > odbs;
+    odbs.reserve( workers );
+    for( size_t worker_num = 0; worker_num < workers; ++worker_num )
+    {
+        const git_item_repo* repo = worker_num ? m_worker_repos[ worker_num - 1 ].get() : m_git_repo.get();
 
-////////////////////////////////////////////////////////////////////////////////
-/////////////////                   Repo                  //////////////////////
-////////////////////////////////////////////////////////////////////////////////
+        git_odb* odb{ nullptr };
+        if( git_repository_odb( &odb, repo->get() ) != 0 )
+        {
+            throw std::runtime_error{ "Could not open the object database" };
+        }
 
-repo_wrapper::repo_wrapper( const std::string& repo_path,
-                            std::unique_ptr< git_item_repo >&& repo ) :
-                            m_local_path( repo_path),
-                            m_git_repo( std::move( repo ) )
-{
+        odbs.emplace_back( odb );
+    }
 
-}
+    std::vector< Batch > chunks( chunks_count, empty );
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    details::parallel_for( chunks_count, workers,
+                           [ & ]( const size_t chunk_num, const size_t worker_num )
+                           {
+                               try
+                               {
+                                   auto& chunk = chunks[ chunk_num ];
+                                   const size_t first{ chunk_num * chunk_size };
+                                   const size_t last{ std::min( first + chunk_size, ids.size() ) };
+                                   chunk.reserve( last - first );
+
+                                   for( size_t id_num = first; id_num < last; ++id_num )
+                                   {
+                                       read_raw_commit( &odbs[ worker_num ], ids[ id_num ], chunk );
+                                   }
+                               }
+                               catch( ... )
+                               {
+                                   std::lock_guard< std::mutex > l{ error_mutex };
+                                   if( !error )
+                                   {
+                                       error = std::current_exception();
+                                   }
+                               }
+                           } );
+
+    if( error )
+    {
+        std::rethrow_exception( error );
+    }
 
-void repo_wrapper::open_local( const std::string& path )
-{
-    close();
-		
-    git_repository* r{ nullptr };
-    if( git_repository_open( &r, path.c_str() ) != 0 )
+    Batch batch{ empty };
+    batch.reserve( ids.size() );
+
+    for( const auto& chunk : chunks )
     {
-        throw std::runtime_error{ "Could not open local repository " + path };
+        batch.append( chunk );
     }
 
-    m_git_repo = factory::git_item_creator::get().create< git_item_repo >( item::type::GIT_REPO, r );
-    m_local_path = path;
+    return batch;
 }
 
-void repo_wrapper::update_remotes( const git_fetch_options& fetch_opts )
+commit_headers repo_wrapper::read_history_headers( const git_oid& from )
 {
     if( !is_valid() )
     {
         throw std::logic_error{ "Repository is not valid" };
     }
-	
-    remotes_set remotes_list;
-    read_remotes_list( remotes_list );
 
-    if( !remotes_list.size() )
+    git_odb* odb{ nullptr };
+    if( git_repository_odb( &odb, m_git_repo->get() ) != 0 )
     {
-        return;
+        throw std::runtime_error{ "Could not open the object database" };
     }
 
-    for ( auto remote = m_remotes.begin(); remote != m_remotes.end(); )
+    git_item_odb odb_item{ odb };
+
+    // the parents come from the parsed headers, so every object is read only once
+    std::unordered_set< git_oid, details::oid_hash, details::oid_equal > queued{ from };
+    std::vector< git_oid > pending{ from };
+    commit_headers headers{ m_identities };
+
+    while( !pending.empty() )
     {
-        if( !remotes_list.count( remote->first ) )
+        const git_oid id = pending.back();
+        pending.pop_back();
+
+        if( !read_raw_commit( &odb_item, id, headers ) )
         {
-            m_remotes.erase(remote);
+            continue;
         }
-		
-        remote++;
-    }
 
-    for( auto name : remotes_list )
-    {
-        auto remoteStor = m_remotes.find(name);
-        if ( remoteStor == m_remotes.end() )
+        const auto& header = headers[ headers.size() - 1 ];
+        for( auto parent = headers.parents_begin( header ); parent != headers.parents_end( header ); ++parent )
         {
-            git_remote* remote{ nullptr };
-            if( git_remote_lookup( &remote, m_git_repo->get(), name.c_str() ) != 0 )
+            if( queued.insert( *parent ).second )
             {
-                throw std::logic_error{ "Could not find remote " + name };
+                pending.push_back( *parent );
             }
-			
-            std::string url{ git_remote_url( remote ) };
-            std::string name{ git_remote_name( remote ) };
+        }
+    }
 
-            printf( "Fetching from %s: %s\n", name.c_str(), url.c_str() );
+    return headers;
+}
 
-            auto remotePtr = factory::git_item_creator::get().create< git_item_remote >( item::type::GIT_REMOTE, remote );
+template< typename Batch >
+bool repo_wrapper::read_raw_commit( const git_item_odb* odb, const git_oid& id, Batch& batch )
+{
+    git_odb_object* raw{ nullptr };
+    if( git_odb_read( &raw, odb->get(), &id ) != 0 )
+    {
+        batch.add_missing( id );
+        return false;
+    }
 
-            m_remotes.emplace( name, std::move( remotePtr ) );
-        }
+    git_item_odb_object object{ raw };
+
+    details::commit_header_fields fields;
+    if( git_odb_object_type( object.get() ) != GIT_OBJECT_COMMIT ||
+        !details::parse_commit_header( static_cast< const char* >( git_odb_object_data( object.get() ) ),
+                                       git_odb_object_size( object.get() ), fields ) )
+    {
+        batch.add_missing( id );
+        return false;
     }
+
+    batch.add( id, fields );
+    return true;
 }
 
-void repo_wrapper::fetch( const git_fetch_options& fetch_opts )
+std::vector< diff_stats > repo_wrapper::read_diff_stats( const std::vector< git_oid >& ids, const size_t workers_count )
 {
     if( !is_valid() )
     {
         throw std::logic_error{ "Repository is not valid" };
     }
 
-    update_remotes( fetch_opts );
-
-    for( auto& remote : m_remotes )
+    // every commit is diffed once, however many times it is asked for
+    std::vector< git_oid > pending;
+    std::unordered_set< git_oid, details::oid_hash, details::oid_equal > queued;
+    for( const auto& id : m_diff_stats->missing( ids ) )
     {
-        auto arr = aux::create_str_arr();
-        if( git_remote_fetch( remote.second->get(), arr->get(), &fetch_opts, nullptr) != 0 )
+        if( queued.insert( id ).second )
         {
-            throw std::logic_error{ "Could not fetch remote " + remote.first };
+            pending.push_back( id );
         }
     }
-}
 
-void repo_wrapper::clone( const std::string& url, const std::string& path, const git_clone_options& clone_opts )
-{
-    close();
+    // a diff costs far more than scheduling it, so the commits are handed out one by one
+    const size_t workers{ std::max< size_t >( 1, std::min( workers_count, pending.size() ) ) };
+    open_worker_repos( workers - 1 );
+
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    details::parallel_for( pending.size(), workers,
+                           [ & ]( const size_t id_num, const size_t worker_num )
+                           {
+                               try
+                               {
+                                   const git_item_repo* repo = worker_num ? m_worker_repos[ worker_num - 1 ].get() : m_git_repo.get();
+                                   m_diff_stats->insert( pending[ id_num ], compute_diff_stats( repo, pending[ id_num ] ) );
+                               }
+                               catch( ... )
+                               {
+                                   std::lock_guard< std::mutex > l{ error_mutex };
+                                   if( !error )
+                                   {
+                                       error = std::current_exception();
+                                   }
+                               }
+                           } );
+
+    if( error )
+    {
+        std::rethrow_exception( error );
+    }
 
-    git_repository* r{ nullptr };
-    if( git_clone( &r, url.c_str(), path.c_str(), &clone_opts ) != 0 )
+    std::vector< diff_stats > result( ids.size() );
+    for( size_t id_num = 0; id_num < ids.size(); ++id_num )
     {
-        throw std::logic_error{ "Could not clone repository " + url };
+        m_diff_stats->find( ids[ id_num ], result[ id_num ] );
     }
 
-    m_git_repo = factory::git_item_creator::get().create< git_item_repo >( item::type::GIT_REPO, r );
+    return result;
 }
 
-void repo_wrapper::close() noexcept
+auto repo_wrapper::diff_cache() const noexcept -> const diff_stats_cache&
 {
-    m_git_repo.reset();
-    m_local_path.clear();
-    m_remotes.clear();
+    return *m_diff_stats;
 }
 
-void repo_wrapper::read_remotes_list( remotes_set& remotes_list )
+diff_stats repo_wrapper::compute_diff_stats( const git_item_repo* repo, const git_oid& id )
 {
-    if( !is_valid() )
+    auto commit = aux::read_commit( repo, &id );
+    if( !commit )
     {
-        throw std::logic_error{ "Repository is not valid" };
+        throw std::runtime_error{ "Could not read commit" };
     }
 
-    auto remote_list = aux::create_str_arr();
-    if( git_remote_list( remote_list->get(), m_git_repo->get() ) != 0 )
+    git_tree* tree{ nullptr };
+    if( git_commit_tree( &tree, commit.get() ) != 0 )
     {
-        throw std::logic_error{ "Could not get remotes list" };
+        throw std::runtime_error{ "Could not read the tree of a commit" };
     }
 
-    for( size_t str_num = 0; str_num < remote_list->get()->count; ++str_num )
+    git_item_tree tree_item{ tree };
+
+    // a root commit is diffed against the empty tree
+    git_item_tree parent_tree_item;
+    if( git_commit_parentcount( commit.get() ) > 0 )
     {
-        remotes_list.insert( remote_list->get()->strings[ str_num ] );
-    }				
-}
+        git_commit* parent{ nullptr };
+        if( git_commit_parent( &parent, commit.get(), 0 ) != 0 )
+        {
+            throw std::runtime_error{ "Could not read the parent of a commit" };
+        }
 
-bool repo_wrapper::is_valid() const noexcept
-{
-    return m_git_repo != nullptr &&
-           m_git_repo->get() != nullptr &&
-           m_local_path.length();
-}
+        git_item_commit parent_item{ parent };
 
-std::string repo_wrapper::path() const noexcept
-{
-    return m_local_path;
-}
+        git_tree* parent_tree{ nullptr };
+        if( git_commit_tree( &parent_tree, parent_item.get() ) != 0 )
+        {
+            throw std::runtime_error{ "Could not read the parent tree of a commit" };
+        }
 
+        parent_tree_item.reset( parent_tree );
+    }
+
+    git_diff* diff{ nullptr };
+    if( git_diff_tree_to_tree( &diff, repo->get(), parent_tree_item.get(),
+                               tree_item.get(), nullptr ) != 0 )
+    {
+        throw std::runtime_error{ "Could not diff commit" };
+    }
+
+    git_item_diff diff_item{ diff };
+
+    git_diff_stats* stats{ nullptr };
+    if( git_diff_get_stats( &stats, diff_item.get() ) != 0 )
+    {
+        throw std::runtime_error{ "Could not count the changes of a commit" };
+    }
 
-void repo_wrapper::read_branch_commits( branch_wrapper* branch )
+    git_item_diff_stats stats_item{ stats };
+
+    diff_stats result;
+    result.files_changed = static_cast< uint32_t >( git_diff_stats_files_changed( stats_item.get() ) );
+    result.insertions = git_diff_stats_insertions( stats_item.get() );
+    result.deletions = git_diff_stats_deletions( stats_item.get() );
+
+    return result;
+}
+
+bool repo_wrapper::refresh_branch( branch_wrapper* branch )
 {
-    if( !is_valid() )
+    if( !branch || !branch->is_valid() )
     {
-        throw std::logic_error{ "Repository is not valid" };
+        return false;
     }
-	
-    auto oid = const_cast< git_oid* >( git_reference_target( branch->m_branch_ref->get() ) );
-    if( !oid )
+
+    auto ref_ptr = aux::get_reference( branch->ref_name(), m_git_repo.get() );
+    if( !ref_ptr )
     {
-        throw std::runtime_error{ "Could not get branch ref" };
+        return false;
     }
-	   
-    git_revwalk* git_walker{ nullptr };
 
-    if( git_revwalk_new( &git_walker, m_git_repo->get() ) != 0 )
+    branch->m_branch_ref = std::move( ref_ptr );
+    read_branch_commits( branch );
+
+    return true;
+}
+
+template< typename Func >
+void repo_wrapper::for_each_branch( const bool remotes, Func&& func ) const
+{
+    // git_branch_iterator filters an iterator over every ref, while a glob iterator
+    // only reads the loose refs under the glob's directory
+    git_reference_iterator* it{ nullptr };
+    if( git_reference_iterator_glob_new( &it, m_git_repo->get(), remotes ? "refs/remotes/*" : "refs/heads/*" ) != 0 )
     {
-        throw std::runtime_error{ "Could not create revwalk" };
+        throw std::logic_error{ "Failed to get repo's refs list" };
     }
-	
-    auto walker = factory::git_item_creator::get().create< git_item_rev_walk >( item::type::GIT_REV_WALK, git_walker );
 
-    git_revwalk_sorting( walker->get(), GIT_SORT_TOPOLOGICAL );
-    git_revwalk_push( walker->get(), oid );
-			   
-    while ( git_revwalk_next( oid, walker->get() ) == 0 )
+    git_item_ref_iter iter{ it };
+
+    git_reference* ref{ nullptr };
+    int result{ 0 };
+
+    while( ( result = git_reference_next( &ref, iter.get() ) ) == 0 )
     {
-        git_commit* commit{ nullptr };
-        if( git_commit_lookup( &commit, m_git_repo->get(), oid ) != 0 )
+        auto ref_ptr = item::make_item< git_item_ref >( ref );
+
+        // symbolic refs like origin/HEAD only alias another branch
+        if( git_reference_type( ref ) == GIT_REFERENCE_DIRECT )
         {
-            branch->clear_commits();
-            throw std::logic_error{ "Could not read branch commits" };
+            func( std::move( ref_ptr ) );
         }
+    }
 
-        auto commit_ptr = factory::git_item_creator::get().create< git_item_commit >( item::type::GIT_COMMIT, commit );
-        auto ptr = std::make_unique< commit_wrapper >( std::move( commit_ptr ) );
-
-        branch->add_commit( std::move( ptr ) );
+    if( result != GIT_ITEROVER )
+    {
+        throw std::logic_error{ "Could not read the repo's branches" };
     }
 }
 
-bool repo_wrapper::get_branches( branches& branchStorage, const bool getRemotes )
+bool repo_wrapper::get_branches( branches& branchStorage, const bool getRemotes, const size_t workers_count )
 {
     if( !is_valid() )
     {
         throw std::logic_error{ "Repository is not valid" };
     }
 
-    auto arr = aux::get_repo_ref_list( m_git_repo.get() );
-    if( !arr )
+    std::set< std::string > found_branches;
+
+    // only the requested namespace is read, tags and other refs are never even looked up
+    for_each_branch( getRemotes,
+                     [ & ]( std::unique_ptr< git_item_ref >&& ref_ptr )
+                     {
+                         auto branch = std::make_unique< branch_wrapper >( std::move( ref_ptr ), getRemotes );
+                         // keyed by the full ref name, a local "origin/x" and the remote "origin/x" are different branches
+                         auto name = branch->ref_name();
+
+                         // branches already in the storage keep their commits and are only refreshed from their last tip
+                         auto stored_branch = branchStorage.find( name );
+                         if( stored_branch != branchStorage.end() )
+                         {
+                             stored_branch->second->m_branch_ref = std::move( branch->m_branch_ref );
+                         }
+                         else
+                         {
+                             branchStorage.emplace( name, std::move( branch ) );
+                         }
+
+                         found_branches.insert( name );
+                     } );
+
+    // branches of the other kind stored by an earlier call are kept as they are
+    bool dropped{ false };
+    for( auto branch = branchStorage.begin(); branch != branchStorage.end(); )
     {
-        throw std::logic_error{ "Failed to get repo's refs list" };
+        if( branch->second->is_remote() == getRemotes && !found_branches.count( branch->first ) )
+        {
+            if( m_reachability )
+            {
+                m_reachability->remove_tip( branch->second->ref_name() );
+            }
+
+            branch = branchStorage.erase( branch );
+            dropped = true;
+        }
+        else
+        {
+            ++branch;
+        }
     }
 
-    for( size_t ref_num = 0; ref_num < arr->get()->count; ++ref_num )
-    {
-        std::string ref_name = arr->get()->strings[ ref_num ];
+    std::vector< branch_wrapper* > branches_list;
+    branches_list.reserve( branchStorage.size() );
 
-        auto ref_ptr = aux::get_reference( ref_name, m_git_repo.get() );
-        if ( !ref_ptr)
+    for( const auto& branch : branchStorage )
+    {
+        if( branch.second->is_remote() == getRemotes )
         {
-            branchStorage.clear();
-            throw std::logic_error{ "Could not get reference for " + ref_name };
+            branches_list.push_back( branch.second.get() );
         }
+    }
 
-        using check_func = int (*)( const git_reference* );
-
-        check_func checkFunc = getRemotes?
-                              git_reference_is_remote : git_reference_is_branch;
+    if( dropped )
+    {
+        release_memory();
+    }
 
-        if( checkFunc( ref_ptr->get() ) )
+    const size_t workers{ std::max< size_t >( 1, std::min( workers_count, branches_list.size() ) ) };
+    open_worker_repos( workers - 1 );
+    // an arena per worker, a single threaded load keeps using a single one
+    m_pool->reserve_arenas( workers );
+
+    // every worker fills its own branches, the first error is rethrown once all of them are done
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    details::parallel_for( branches_list.size(), workers,
+                           [ & ]( const size_t branch_num, const size_t worker_num )
+                           {
+                               try
+                               {
+                                   const git_item_repo* repo = worker_num ? m_worker_repos[ worker_num - 1 ].get() : nullptr;
+                                   read_branch_commits( branches_list[ branch_num ], repo );
+                               }
+                               catch( ... )
+                               {
+                                   std::lock_guard< std::mutex > l{ error_mutex };
+                                   if( !error )
+                                   {
+                                       error = std::current_exception();
+                                   }
+                               }
+                           } );
+
+    if( error )
+    {
+        // the branches of the requested kind may be half read, the other ones weren't touched
+        for( auto branch = branchStorage.begin(); branch != branchStorage.end(); )
         {
-            auto branch = std::make_unique< branch_wrapper >( std::move( ref_ptr ), true );
-            branchStorage.emplace( branch->name(), std::move( branch ) );
+            branch = branch->second->is_remote() == getRemotes ? branchStorage.erase( branch ) : std::next( branch );
         }
+
+        release_memory();
+
+        std::rethrow_exception( error );
     }
 
-    for( const auto& branch : branchStorage )
+    return true;
+}
+
+ref_snapshot repo_wrapper::snapshot_refs( const bool remotes ) const
+{
+    if( !is_valid() )
     {
-        //printf( "Reading branch commits for branch: %s\r", branch.first.c_str() );
-        read_branch_commits( branch.second.get() );
+        throw std::logic_error{ "Repository is not valid" };
     }
 
-    printf("\n");
+    ref_snapshot::refs refs;
 
-    return true;
+    for_each_branch( remotes,
+                     [ & ]( std::unique_ptr< git_item_ref >&& ref_ptr )
+                     {
+                         refs.push_back( { git_reference_name( ref_ptr->get() ), *git_reference_target( ref_ptr->get() ) } );
+                     } );
+
+    return ref_snapshot{ std::move( refs ) };
 }
 
-std::unique_ptr< branch_wrapper > repo_wrapper::get_branch( const std::string& ref_name )
+std::unique_ptr< branch_wrapper > repo_wrapper::get_branch( const std::string& ref_name, const bool read_commits )
 {
     auto ref_ptr = aux::get_reference( ref_name, m_git_repo.get() );
     if ( ref_ptr )
@@ -385,7 +1760,11 @@ std::unique_ptr< branch_wrapper > repo_wrapper::get_branch( const std::string& r
         {
             auto branch = std::make_unique< branch_wrapper >( std::move( ref_ptr ), is_remote );
 
-            read_branch_commits( branch.get() );
+            if( read_commits )
+            {
+                read_branch_commits( branch.get() );
+            }
+
             return branch;
         }
     }
@@ -399,9 +1778,8 @@ std::unique_ptr< branch_wrapper > repo_wrapper::get_branch( const std::string& r
 
 std::unique_ptr< git_item_str_arr > aux::create_str_arr()
 {
-    auto remoteList = factory::git_item_creator::get().create< git_item_str_arr >( item::type::GIT_STR_ARR );
-    remoteList->get()->count = 0;
-    return remoteList;
+    // libgit2 fills the array, the item only owns the struct itself
+    return item::make_item< git_item_str_arr >( new git_strarray{ nullptr, 0 } );
 }
 
 std::string aux::get_commit_message_str( const commit_wrapper* commit )
@@ -411,15 +1789,33 @@ std::string aux::get_commit_message_str( const commit_wrapper* commit )
         return std::string{};
     }
 
-    std::string raw_message{ commit->message() };
-    std::vector< std::string > parts;
+    const commit_wrapper::view_scope scope{ *commit };
+
+    // the empty lines are dropped, the message is only copied line by line
+    const auto raw_message = commit->message_view();
+    std::string message_lines;
+    message_lines.reserve( raw_message.size() );
+
+    for( size_t line_start = 0; line_start < raw_message.size(); )
+    {
+        size_t line_end{ raw_message.find( '\n', line_start ) };
+        if( line_end == boost::string_view::npos )
+        {
+            line_end = raw_message.size();
+        }
+
+        if( line_end != line_start )
+        {
+            if( !message_lines.empty() )
+            {
+                message_lines += '\n';
+            }
 
-    boost::split( parts, raw_message, boost::is_any_of( "\n" ) );
-    raw_message = boost::join_if( parts,
-                                 "\n",
-                                 []( const std::string& str ) -> bool
-                                 { return !str.empty(); } );
+            message_lines.append( raw_message.data() + line_start, line_end - line_start );
+        }
 
+        line_start = line_end + 1;
+    }
 
     auto commit_time = commit->time();
 
@@ -430,8 +1826,8 @@ std::string aux::get_commit_message_str( const commit_wrapper* commit )
 
     std::string message{ ( boost::format( "[%s]\n%s\n%s\n\n" )
                            % dtime
-                           % raw_message
-                           % commit->author() ).str() };
+                           % message_lines
+                           % commit->author_view() ).str() };
 
     return message;
 }
@@ -441,25 +1837,24 @@ std::unique_ptr< git_item_ref > aux::get_reference( const std::string& ref_name,
     git_reference* ref{ nullptr };
     if( git_reference_lookup( &ref, repo->get(), ref_name.c_str() ) == 0 )
     {
-        auto ref_ptr = factory::git_item_creator::get().create< git_item_ref >( item::type::GIT_REF, ref );
+        auto ref_ptr = item::make_item< git_item_ref >( ref );
         return ref_ptr;
     }
 
     return nullptr;
 }
 
-std::unique_ptr< git_item_commit > aux::read_commit( const git_item_repo* repo, const git_oid* head )
+git_item_commit aux::read_commit( const git_item_repo* repo, const git_oid* head )
 {
     git_commit* commit{ nullptr };
 
     if ( repo && head &&
          git_commit_lookup( &commit, repo->get(), head ) == 0 )
     {
-        auto commit_ptr = factory::git_item_creator::get().create< git_item_commit >( item::type::GIT_COMMIT, commit );
-        return commit_ptr;
+        return git_item_commit{ commit };
     }
 
-    return nullptr;
+    return git_item_commit{};
 }
 
 std::unique_ptr< git_item_str_arr > aux::get_repo_ref_list( const git_item_repo* repo )
@@ -514,7 +1909,7 @@ void aux::print_branch_commits( const branch_wrapper* branch )
         auto& commits = branch->commits();
         for( const auto& commit : commits )
         {
-            print_commits( commit.second.get() );
+            print_commits( commit.commit.get() );
         }
     }
 }
@@ -1,10 +1,32 @@
 #ifndef GITBASECLASSES_H
 #define GITBASECLASSES_H
 
+#include <map>
 #include <set>
+#include <mutex>
+#include <future>
 #include <string>
+#include <functional>
 
-#include "GitItemFactory.h"
+#include <boost/utility/string_view.hpp>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "GitItem.h"
+#include "GitCancel.h"
+#include "GitCommitCache.h"
+#include "GitCommitWalk.h"
+#include "GitCommitHeaders.h"
+#include "GitCommitTable.h"
+#include "GitIdentityTable.h"
+#include "GitDiffStats.h"
+#include "GitCommitStorage.h"
+#include "GitFetchStats.h"
+#include "GitRefSnapshot.h"
+#include "GitCommitMetadata.h"
+#include "GitReachabilityIndex.h"
+#include "details/OidHash.h"
+#include "details/MemoryPool.h"
 
 namespace git_handler
 {
@@ -19,6 +41,12 @@ using git_item_remote = item::git_item< git_remote >;
 using git_item_commit = item::git_item< git_commit >;
 using git_item_str_arr = item::git_item< git_strarray >;
 using git_item_rev_walk = item::git_item< git_revwalk >;
+using git_item_ref_iter = item::git_item< git_reference_iterator >;
+using git_item_odb = item::git_item< git_odb >;
+using git_item_odb_object = item::git_item< git_odb_object >;
+using git_item_tree = item::git_item< git_tree >;
+using git_item_diff = item::git_item< git_diff >;
+using git_item_diff_stats = item::git_item< git_diff_stats >;
 
 class repo_wrapper;
 
@@ -29,16 +57,154 @@ class repo_wrapper;
 class commit_wrapper : public std::enable_shared_from_this< commit_wrapper >
 {
 public:
+    // For code reading the views of many commits once: unpins the commit on destruction unless
+    // it was already pinned when the scope was made, so that the commits stay within the cache budget
+    class view_scope
+    {
+    public:
+        explicit view_scope( const commit_wrapper& commit ) noexcept;
+        ~view_scope();
+        view_scope( const view_scope& ) = delete;
+        view_scope& operator=( const view_scope& ) = delete;
+
+    private:
+        const commit_wrapper& m_commit;
+        const bool m_was_pinned;
+    };
+
+public:
+    // eager commit, keeps the libgit2 commit for its whole lifetime
     explicit commit_wrapper( std::unique_ptr< git_item_commit >&& commit = nullptr );
+    explicit commit_wrapper( git_item_commit&& commit );
+    // lazy commit, keeps only the id and the time and loads the rest through the cache when needed
+    commit_wrapper( const git_oid& id, const git_time& time, std::shared_ptr< commit_cache > cache );
+    // lazy commit whose author and message are read from saved metadata
+    commit_wrapper( std::shared_ptr< const commit_metadata > metadata, const uint64_t index, std::shared_ptr< commit_cache > cache );
 
     git_oid id() const noexcept;
     git_time time() const noexcept;
     std::string author() const noexcept;
     std::string message() const noexcept;
+    std::vector< git_oid > parents() const;
+    // Id of the author in the identities() of the repo that read the commit, interned when
+    // the commit was read, so grouping by author compares ids without loading the commit.
+    // no_identity for commits not read by a repo
+    identity_table::identity_id author_id() const noexcept;
+
+    // Non-owning views valid as long as the wrapper or until unpin(). Empty for invalid commits.
+    // A lazy commit keeps its libgit2 commit pinned from the first view on, outside the budget
+    // of the commit cache, except for the author, email and message of the commits read from
+    // saved metadata, which point into the mapped file
+    boost::string_view message_view() const noexcept;
+    // the first line of the message
+    boost::string_view summary_view() const noexcept;
+    boost::string_view author_view() const noexcept;
+    boost::string_view author_email_view() const noexcept;
+    boost::string_view committer_view() const noexcept;
+    boost::string_view committer_email_view() const noexcept;
+    boost::string_view raw_header_view() const noexcept;
+
+    // Releases the libgit2 commit pinned by the views of a lazy commit, so that it only stays
+    // loaded as long as the commit cache keeps it. Views taken before become invalid, later ones
+    // pin it again. Not to be called while other threads take views of the commit
+    void unpin() const noexcept;
+    bool is_pinned() const noexcept;
+
     bool isValid() const noexcept;
+    bool is_lazy() const noexcept;
+
+private:
+    friend class repo_wrapper;
+
+private:
+    commit_cache::commit_handle handle() const noexcept;
+    // the libgit2 commit kept for the wrapper's lifetime, loaded and pinned on first use
+    const git_commit* pinned_commit() const noexcept;
 
 private:	
-    std::unique_ptr< git_item_commit > m_commit;
+    git_oid m_id{};
+    git_time m_time{};
+    git_item_commit m_commit;
+    std::shared_ptr< commit_cache > m_cache;
+    // set by pinned_commit(), reset by unpin(), accessed atomically
+    mutable commit_cache::commit_handle m_pinned;
+    std::shared_ptr< const commit_metadata > m_metadata;
+    uint64_t m_metadata_index{ 0 };
+    identity_table::identity_id m_author_id{ identity_table::no_identity };
+};
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////               CommitStore               //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+// Per-repo storage deduplicating commits by id, branches share the commits it hands out.
+// The store doesn't own the commits, they live as long as some branch references them
+class commit_store
+{
+public:
+    using commit_ptr = std::shared_ptr< commit_wrapper >;
+
+public:
+    explicit commit_store( std::shared_ptr< details::memory_pool > pool = nullptr );
+    commit_store( const commit_store& ) = delete;
+    commit_store& operator=( const commit_store& ) = delete;
+
+    // returns the stored commit with the given id or the one made by create() if there's none,
+    // create() is called without holding the lock and may return nullptr on failure
+    template< typename Creator >
+    commit_ptr get( const git_oid& id, Creator&& create )
+    {
+        auto commit = find( id );
+        if( commit )
+        {
+            return commit;
+        }
+
+        commit = create();
+        if( !commit )
+        {
+            return nullptr;
+        }
+
+        std::lock_guard< std::mutex > l{ m_mutex };
+
+        auto& stored_commit = m_commits[ id ];
+        auto existing_commit = stored_commit.lock();
+        if( existing_commit )
+        {
+            return existing_commit;
+        }
+
+        stored_commit = commit;
+
+        if( m_commits.size() >= m_prune_threshold )
+        {
+            prune_expired();
+        }
+
+        return commit;
+    }
+
+    commit_ptr find( const git_oid& id ) const;
+    size_t size() const noexcept;
+    void clear() noexcept;
+    // drops the entries of the commits no branch references anymore
+    void prune() noexcept;
+
+private:
+    void prune_expired() noexcept;
+
+private:
+    using commit_entry = std::pair< const git_oid, std::weak_ptr< commit_wrapper > >;
+    using commits = std::unordered_map< git_oid,
+                                        std::weak_ptr< commit_wrapper >,
+                                        details::oid_hash,
+                                        details::oid_equal,
+                                        details::pool_allocator< commit_entry > >;
+
+    commits m_commits;
+    size_t m_prune_threshold{ 1024 };
+    mutable std::mutex m_mutex;
 };
 
 //////////////////////////////////////////////////////////////////////////////
@@ -49,26 +215,32 @@ class branch_wrapper : public std::enable_shared_from_this< branch_wrapper >
 {
     friend class repo_wrapper;
 
-public:
-    using commit_id = std::pair< git_time_t, std::string >;
-    using commit_storage = std::map< commit_id, std::unique_ptr< commit_wrapper > >;
-
 public:
     branch_wrapper( std::unique_ptr< git_item_ref >&& branch_ref = nullptr,
             const bool is_remote = false,
             const std::shared_ptr< repo_wrapper > parent_repo = nullptr );
 
-    void add_commit( std::unique_ptr< commit_wrapper >&& commit_wrapper );
+    void add_commit( std::shared_ptr< commit_wrapper > commit_wrapper );
+    void add_commits( commit_storage::entries&& commits );
     void clear_commits() noexcept;
 	
     std::string name() const noexcept;
+    std::string ref_name() const noexcept;
     const commit_storage& commits() const noexcept;
 
+    // the tip the commits were last read at, zero if they haven't been read yet
+    git_oid tip() const noexcept;
+
+    // whether the commits are only the first parent chain, read under walk_strategy::first_parent
+    bool is_partial() const noexcept;
     bool is_remote() const noexcept;
     bool is_valid() const noexcept;
 	
 private:
     bool m_is_remote;
+    bool m_has_tip{ false };
+    bool m_partial{ false };
+    git_oid m_tip{};
     commit_storage m_commits;
     std::weak_ptr< repo_wrapper > m_parent_repo;
     std::unique_ptr< git_item_ref > m_branch_ref;
@@ -81,9 +253,14 @@ private:
 
 class repo_wrapper : public std::enable_shared_from_this< repo_wrapper >
 {
+    friend class commit_walk;
+
 public:
+    // by full ref name, e.g. "refs/heads/master" or "refs/remotes/origin/master"
     using branches = std::map< std::string, std::unique_ptr< branch_wrapper > >;
     using remotes = std::map< std::string, std::unique_ptr< git_item_remote > >;
+    // gets the exception the operation failed with, nullptr on success
+    using completion_handler = std::function< void( std::exception_ptr ) >;
 
 private:
     using remotes_set = std::set< std::string >;
@@ -94,25 +271,160 @@ public:
 	
     // repo operations
     void open_local( const std::string& path );
-    void fetch( const git_fetch_options& fetch_opts = GIT_FETCH_OPTIONS_INIT );
-    void clone( const std::string& url, const std::string& path, const git_clone_options& cloneOpts = GIT_CLONE_OPTIONS_INIT );
+    // a cancelled fetch or clone throws operation_cancelled
+    void fetch( const git_fetch_options& fetch_opts = GIT_FETCH_OPTIONS_INIT, const cancel_token& cancel = cancel_token{} );
+    void clone( const std::string& url, const std::string& path, const git_clone_options& cloneOpts = GIT_CLONE_OPTIONS_INIT,
+                const cancel_token& cancel = cancel_token{} );
     void close() noexcept;
 
+    // With the check on, fetch() first reads the refs advertised by every remote and skips the remotes
+    // whose refs match the local remote-tracking ones, FETCH_HEAD being left as it was. Pruning fetches
+    // are never skipped. The connection made for the check is reused by the fetch
+    void set_skip_unchanged_fetches( const bool skip ) noexcept;
+
+    // Run fetch() and clone() on the library executor. The options are copied, but the strings
+    // and payloads they point to must outlive the operation, as must the repo itself. The repo
+    // must not be used until the operation completes, the handler is called on the executor
+    std::future< void > fetch_async( const git_fetch_options& fetch_opts = GIT_FETCH_OPTIONS_INIT,
+                                     const cancel_token& cancel = cancel_token{} );
+    void fetch_async( completion_handler handler, const git_fetch_options& fetch_opts = GIT_FETCH_OPTIONS_INIT,
+                      const cancel_token& cancel = cancel_token{} );
+    std::future< void > clone_async( const std::string& url, const std::string& path,
+                                     const git_clone_options& clone_opts = GIT_CLONE_OPTIONS_INIT,
+                                     const cancel_token& cancel = cancel_token{} );
+    void clone_async( completion_handler handler, const std::string& url, const std::string& path,
+                      const git_clone_options& clone_opts = GIT_CLONE_OPTIONS_INIT,
+                      const cancel_token& cancel = cancel_token{} );
+
     // getters
     bool is_valid() const noexcept;
     std::string path() const noexcept;
-    std::unique_ptr< branch_wrapper > get_branch( const std::string& ref_name );
-    bool get_branches( branches& branchStor, const bool get_remotes = false );
+    // urls of the configured remotes by remote name
+    std::map< std::string, std::string > remote_urls() const;
+    // timings and transfer counters of the last fetch() or clone(), even a failed one
+    const fetch_stats& last_fetch_stats() const noexcept;
+    // without read_commits the branch is returned empty, refresh_branch() reads it later
+    std::unique_ptr< branch_wrapper > get_branch( const std::string& ref_name, const bool read_commits = true );
+    // with several workers the branches are read in parallel, each worker using its own repo handle.
+    // Stored branches of the requested kind that are gone from the repo are dropped, branches of the
+    // other kind are left untouched, so that one storage can hold both local and remote branches.
+    // On an error the branches of the requested kind are dropped and the error is rethrown
+    bool get_branches( branches& branchStor, const bool get_remotes = false, const size_t workers_count = 1 );
+
+    // tips of the local or remote-tracking branches, read in a single pass over their namespace
+    ref_snapshot snapshot_refs( const bool remotes = false ) const;
+
+    // streams the history of the given ref ( full or short name ) in the order of options.strategy
+    commit_walk walk( const std::string& ref_name, const walk_options& options = {} );
+    commit_walk walk( const git_oid& from, const walk_options& options = {} );
+
+    // Order of the walks reading branch histories, time by default. Branches sort their commits
+    // anyway, so time reads are unsorted and the other orders only add the cost of sorting,
+    // except for first_parent whose branches hold just their first parent chains. Such partial
+    // histories don't feed the reachability index, don't take saved commit metadata and aren't
+    // saved. Branches read under another kind of strategy are read again in full
+    void set_walk_strategy( const walk_strategy strategy ) noexcept;
+    walk_strategy get_walk_strategy() const noexcept;
+
+    // Light history mode: ids, parents, times and authors parsed straight from the raw objects,
+    // without libgit2 commits or commit wrappers. The ids are read in chunks, in parallel with
+    // several workers, and the headers come in the order of the ids. Ids that aren't commits
+    // end up in commit_headers::missing()
+    commit_headers read_commit_headers( const std::vector< git_oid >& ids, const size_t workers_count = 1 );
+    // headers of the whole history of the commit, in no particular order. The history is followed
+    // through the parsed parents, reading every object once, without a revwalk
+    commit_headers read_history_headers( const git_oid& from );
+
+    // Columnar table of the commits, read from their raw objects like read_commit_headers().
+    // The branches variant reads every commit stored by the given branches once
+    commit_table read_commit_table( const std::vector< git_oid >& ids, const size_t workers_count = 1 );
+    commit_table read_commit_table( const branches& storage, const size_t workers_count = 1 );
+
+    // Files changed, insertions and deletions of every commit against its first parent, in the
+    // order of the ids. Commits missing from the repo's diff stats cache are diffed tree to tree,
+    // in parallel with several workers, each through its own repo handle, and then cached.
+    // Throws std::runtime_error if a commit can't be read or diffed
+    std::vector< diff_stats > read_diff_stats( const std::vector< git_oid >& ids, const size_t workers_count = 1 );
+    const diff_stats_cache& diff_cache() const noexcept;
+
+    // re-reads the branch ref and appends the commits added since its last known tip
+    bool refresh_branch( branch_wrapper* branch );
+
+    // Lazy commits keep only their id and time, the rest is loaded on demand through a repo-wide
+    // LRU of libgit2 commits limited to max_entries commits and max_bytes approximate bytes,
+    // 0 meaning no limit. Only affects commits read afterwards
+    void set_lazy_commits( const bool lazy, const size_t max_entries = 1024, const size_t max_bytes = 0 );
+
+    // Returns the memory of the commits no branch holds anymore to the system. Call it after dropping
+    // branch storages, get_branches() does so itself for the branches gone from the repo
+    void release_memory() noexcept;
+
+    // Maps the commit metadata saved to the file, branches read afterwards take their commits
+    // from it and walk only what has been added since it was saved. A missing or invalid file
+    // is ignored. Branches rewritten since then are read in full
+    void use_commit_metadata( const std::string& file_path );
+    // saves the tips and commits of the given branches to the file set by use_commit_metadata(),
+    // partial branches read under walk_strategy::first_parent are left out
+    void save_commit_metadata( const branches& storage ) const;
+
+    // With the index on, every history read also feeds the repo's reachability index, which then
+    // answers ancestry queries for the read branches. Turning it on re-reads the stored branches
+    // in full on their next refresh, turning it off drops the index
+    void set_reachability_index( const bool enabled );
+    // nullptr while the index is off
+    const reachability_index* reachability() const noexcept;
+
+    // Authors of the commits, commit headers and tables read by the repo are interned in this table.
+    // Every repo has its own one unless it is given a shared one, nullptr gives it a new one.
+    // The author ids of the commits read before a change refer to the previous table
+    void set_identities( std::shared_ptr< identity_table > identities );
+    const std::shared_ptr< identity_table >& identities() const noexcept;
 
 private:
+    static void run_async( std::function< void() > operation, completion_handler handler );
+    static std::future< void > make_future( completion_handler& handler );
+    // calls func( std::unique_ptr< git_item_ref >&& ) for every direct local or remote-tracking branch
+    template< typename Func >
+    void for_each_branch( const bool remotes, Func&& func ) const;
     void read_remotes_list( remotes_set& remotesList );
-    void read_branch_commits( branch_wrapper* branch_wrapper);
+    void read_branch_commits( branch_wrapper* branch_wrapper, const git_item_repo* repo = nullptr );
+    void read_saved_commits( branch_wrapper* branch );
+    // parses the raw commits into a batch ( commit_headers or commit_table ) chunk by chunk
+    // every chunk starts as a copy of empty, so that they all share its identities
+    template< typename Batch >
+    Batch read_raw_commits( const std::vector< git_oid >& ids, const size_t workers_count, const Batch& empty );
+    // false if the object is missing or not a commit, it is then added to the missing ones
+    template< typename Batch >
+    static bool read_raw_commit( const git_item_odb* odb, const git_oid& id, Batch& batch );
+    static diff_stats compute_diff_stats( const git_item_repo* repo, const git_oid& id );
+    void open_worker_repos( const size_t count );
+    template< typename... Args >
+    std::shared_ptr< commit_wrapper > make_commit( Args&&... args );
+    void intern_author( commit_wrapper& commit, const boost::string_view name, const boost::string_view email );
     void update_remotes(const git_fetch_options& fetch_opts);
+    // connects the remote and compares its advertised refs with the local ones
+    bool remote_unchanged( git_remote* remote, const git_fetch_options& fetch_opts ) const;
+    commit_store::commit_ptr get_commit( const git_oid& id, const git_item_repo* repo = nullptr );
 
 private:
     remotes m_remotes;
+    // commit wrappers and the store entries of a repo are carved from one pool
+    std::shared_ptr< details::memory_pool > m_pool;
+    commit_store m_commits;
+    bool m_lazy_commits{ false };
+    bool m_skip_unchanged{ false };
+    walk_strategy m_walk_strategy{ walk_strategy::time };
+    std::shared_ptr< commit_cache > m_commit_cache;
+    std::string m_metadata_path;
+    std::shared_ptr< const commit_metadata > m_metadata;
+    std::unique_ptr< reachability_index > m_reachability;
+    std::shared_ptr< identity_table > m_identities{ std::make_shared< identity_table >() };
+    std::shared_ptr< diff_stats_cache > m_diff_stats{ std::make_shared< diff_stats_cache >() };
     std::string m_local_path;
+    fetch_stats m_fetch_stats;
     std::unique_ptr< git_item_repo > m_git_repo;
+    // libgit2 objects can't be shared between threads, so every extra worker gets its own handle
+    std::vector< std::unique_ptr< git_item_repo > > m_worker_repos;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -124,7 +436,8 @@ namespace aux
     std::unique_ptr< git_item_str_arr > create_str_arr();
     std::string get_commit_message_str( const commit_wrapper* commit_wrapper );
     std::unique_ptr< git_item_ref > get_reference( const std::string& ref_name, const git_item_repo* repo_wrapper );
-    std::unique_ptr< git_item_commit > read_commit(const git_item_repo* repo_wrapper, const git_oid* head );
+    // an empty item when the commit can't be read
+    git_item_commit read_commit( const git_item_repo* repo_wrapper, const git_oid* head );
     std::unique_ptr< git_item_str_arr > get_repo_ref_list( const git_item_repo* repo_wrapper );
     std::string get_branch_name( const std::string& full_branch_name );
 
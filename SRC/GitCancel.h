@@ -0,0 +1,50 @@
+#ifndef GITCANCEL_H
+#define GITCANCEL_H
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+
+namespace git_handler
+{
+
+namespace base
+{
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////                 Cancel                  //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+// Cancellation flag shared by all the copies of a token. Network operations check it
+// from the libgit2 callbacks, so a cancelled operation stops at the next callback
+class cancel_token
+{
+public:
+    cancel_token() : m_cancelled( std::make_shared< std::atomic< bool > >( false ) ){}
+
+    void cancel() noexcept
+    {
+        *m_cancelled = true;
+    }
+
+    bool cancelled() const noexcept
+    {
+        return *m_cancelled;
+    }
+
+private:
+    std::shared_ptr< std::atomic< bool > > m_cancelled;
+};
+
+// thrown by the operations stopped through their cancel_token
+class operation_cancelled : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+}//base
+
+}//git_handler
+
+#endif // GITCANCEL_H
@@ -0,0 +1,150 @@
+#include <cstring>
+
+#include "GitCommitCache.h"
+
+namespace git_handler
+{
+
+namespace base
+{
+
+namespace
+{
+
+// what a parsed commit roughly costs, libgit2 keeps both the raw header and the message
+size_t commit_bytes( const git_commit* commit ) noexcept
+{
+    const char* header{ git_commit_raw_header( commit ) };
+    const char* message{ git_commit_message_raw( commit ) };
+
+    return sizeof( git_oid ) * 4 +
+           ( header ? std::strlen( header ) : 0 ) +
+           ( message ? std::strlen( message ) : 0 );
+}
+
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////               CommitCache               //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+commit_cache::commit_cache( const size_t max_entries, const size_t max_bytes ) :
+    m_max_entries( max_entries ),
+    m_max_bytes( max_bytes )
+{
+
+}
+
+void commit_cache::set_limits( const size_t max_entries, const size_t max_bytes )
+{
+    std::lock_guard< std::mutex > l{ m_mutex };
+
+    m_max_entries = max_entries;
+    m_max_bytes = max_bytes;
+    evict();
+}
+
+void commit_cache::attach( git_repository* repo ) noexcept
+{
+    std::lock_guard< std::mutex > l{ m_mutex };
+
+    m_commits.clear();
+    m_index.clear();
+    m_bytes = 0;
+    m_repo = repo;
+}
+
+auto commit_cache::get( const git_oid& id ) -> commit_handle
+{
+    std::lock_guard< std::mutex > l{ m_mutex };
+
+    auto cached = m_index.find( id );
+    if( cached != m_index.end() )
+    {
+        m_commits.splice( m_commits.begin(), m_commits, cached->second );
+        return cached->second->commit;
+    }
+
+    if( !m_repo )
+    {
+        return nullptr;
+    }
+
+    git_commit* commit{ nullptr };
+    if( git_commit_lookup( &commit, m_repo, &id ) != 0 )
+    {
+        return nullptr;
+    }
+
+    // the item and its control block take one allocation
+    auto handle = std::make_shared< item::git_item< git_commit > >( commit );
+    insert( id, handle );
+
+    return handle;
+}
+
+void commit_cache::put( const git_oid& id, const commit_handle& commit )
+{
+    if( !commit || !commit->get() )
+    {
+        return;
+    }
+
+    std::lock_guard< std::mutex > l{ m_mutex };
+
+    if( !m_index.count( id ) )
+    {
+        insert( id, commit );
+    }
+}
+
+void commit_cache::clear() noexcept
+{
+    std::lock_guard< std::mutex > l{ m_mutex };
+
+    m_commits.clear();
+    m_index.clear();
+    m_bytes = 0;
+}
+
+size_t commit_cache::size() const noexcept
+{
+    std::lock_guard< std::mutex > l{ m_mutex };
+    return m_commits.size();
+}
+
+size_t commit_cache::bytes() const noexcept
+{
+    std::lock_guard< std::mutex > l{ m_mutex };
+    return m_bytes;
+}
+
+void commit_cache::insert( const git_oid& id, const commit_handle& commit )
+{
+    const size_t bytes{ commit_bytes( commit->get() ) };
+
+    m_commits.push_front( { id, commit, bytes } );
+    m_index.emplace( id, m_commits.begin() );
+    m_bytes += bytes;
+
+    evict();
+}
+
+void commit_cache::evict() noexcept
+{
+    // the most recently used commit always stays, even if it alone exceeds the budget
+    while( m_commits.size() > 1 &&
+           ( ( m_max_entries && m_commits.size() > m_max_entries ) ||
+             ( m_max_bytes && m_bytes > m_max_bytes ) ) )
+    {
+        const auto& oldest = m_commits.back();
+
+        m_bytes -= oldest.bytes;
+        m_index.erase( oldest.id );
+        m_commits.pop_back();
+    }
+}
+
+}//base
+
+}//git_handler
@@ -0,0 +1,74 @@
+#ifndef GITCOMMITCACHE_H
+#define GITCOMMITCACHE_H
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "GitItem.h"
+#include "details/OidHash.h"
+
+namespace git_handler
+{
+
+namespace base
+{
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////               CommitCache               //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+// Per-repo LRU of libgit2 commit handles used by lazily materialized commits.
+// The budget is set in entries and/or in approximate bytes, 0 meaning no limit
+class commit_cache
+{
+public:
+    using commit_handle = std::shared_ptr< item::git_item< git_commit > >;
+
+public:
+    commit_cache( const size_t max_entries = 0, const size_t max_bytes = 0 );
+    commit_cache( const commit_cache& ) = delete;
+    commit_cache& operator=( const commit_cache& ) = delete;
+
+    void set_limits( const size_t max_entries, const size_t max_bytes );
+    // sets the repo commits are looked up in, nullptr makes further lookups fail
+    void attach( git_repository* repo ) noexcept;
+
+    // returns the cached commit or looks it up, nullptr if there's no such commit
+    commit_handle get( const git_oid& id );
+    void put( const git_oid& id, const commit_handle& commit );
+    void clear() noexcept;
+
+    size_t size() const noexcept;
+    size_t bytes() const noexcept;
+
+private:
+    struct cached_commit
+    {
+        git_oid id;
+        commit_handle commit;
+        size_t bytes;
+    };
+
+    using lru_list = std::list< cached_commit >;
+    using lru_index = std::unordered_map< git_oid, lru_list::iterator, details::oid_hash, details::oid_equal >;
+
+private:
+    void insert( const git_oid& id, const commit_handle& commit );
+    void evict() noexcept;
+
+private:
+    lru_list m_commits;
+    lru_index m_index;
+    size_t m_bytes{ 0 };
+    size_t m_max_entries;
+    size_t m_max_bytes;
+    git_repository* m_repo{ nullptr };
+    mutable std::mutex m_mutex;
+};
+
+}//base
+
+}//git_handler
+
+#endif // GITCOMMITCACHE_H
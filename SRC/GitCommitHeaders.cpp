@@ -0,0 +1,161 @@
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "GitCommitHeaders.h"
+#include "details/CommitHeaderParser.h"
+
+namespace git_handler
+{
+
+namespace base
+{
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////              CommitHeaders              //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+commit_headers::commit_headers( std::shared_ptr< identity_table > identities ) :
+    m_identities( identities ? std::move( identities ) : std::make_shared< identity_table >() )
+{
+
+}
+
+void commit_headers::add( const git_oid& id, const details::commit_header_fields& fields )
+{
+    if( m_parents.size() + fields.parents_count > std::numeric_limits< uint32_t >::max() )
+    {
+        throw std::logic_error{ "Too many commit parents in one batch" };
+    }
+
+    header record;
+    record.id = id;
+    record.time.time = fields.committer.time;
+    record.time.offset = fields.committer.offset;
+    record.time.sign = fields.committer.offset < 0 ? '-' : '+';
+    record.author_time = fields.author.time;
+    record.first_parent = static_cast< uint32_t >( m_parents.size() );
+    record.parents_count = static_cast< uint32_t >( fields.parents_count );
+
+    for( size_t parent_num = 0; parent_num < fields.parents_count; ++parent_num )
+    {
+        git_oid parent;
+        if( !details::parse_parent( fields, parent_num, parent ) )
+        {
+            m_parents.resize( record.first_parent );
+            add_missing( id );
+            return;
+        }
+
+        m_parents.push_back( parent );
+    }
+
+    record.author = m_identities->intern( fields.author.name, fields.author.email );
+    m_headers.push_back( record );
+}
+
+void commit_headers::append( const commit_headers& other )
+{
+    if( m_parents.size() + other.m_parents.size() > std::numeric_limits< uint32_t >::max() )
+    {
+        throw std::logic_error{ "Too many commit headers in one batch" };
+    }
+
+    const auto parents_shift = static_cast< uint32_t >( m_parents.size() );
+
+    // authors of a batch with other identities are interned again
+    std::unordered_map< identity_table::identity_id, identity_table::identity_id > authors;
+
+    m_headers.reserve( m_headers.size() + other.m_headers.size() );
+    for( auto record : other.m_headers )
+    {
+        record.first_parent += parents_shift;
+
+        if( other.m_identities != m_identities )
+        {
+            auto known = authors.find( record.author );
+            if( known == authors.end() )
+            {
+                known = authors.emplace( record.author, m_identities->intern( other.m_identities->name( record.author ),
+                                                                              other.m_identities->email( record.author ) ) ).first;
+            }
+
+            record.author = known->second;
+        }
+
+        m_headers.push_back( record );
+    }
+
+    m_parents.insert( m_parents.end(), other.m_parents.begin(), other.m_parents.end() );
+    m_missing.insert( m_missing.end(), other.m_missing.begin(), other.m_missing.end() );
+}
+
+void commit_headers::add_missing( const git_oid& id )
+{
+    m_missing.push_back( id );
+}
+
+void commit_headers::reserve( const size_t count )
+{
+    m_headers.reserve( count );
+    m_parents.reserve( count );
+}
+
+size_t commit_headers::size() const noexcept
+{
+    return m_headers.size();
+}
+
+bool commit_headers::empty() const noexcept
+{
+    return m_headers.empty();
+}
+
+auto commit_headers::operator[]( const size_t index ) const noexcept -> const header&
+{
+    return m_headers[ index ];
+}
+
+auto commit_headers::begin() const noexcept -> const_iterator
+{
+    return m_headers.begin();
+}
+
+auto commit_headers::end() const noexcept -> const_iterator
+{
+    return m_headers.end();
+}
+
+const git_oid* commit_headers::parents_begin( const header& record ) const noexcept
+{
+    return m_parents.data() + record.first_parent;
+}
+
+const git_oid* commit_headers::parents_end( const header& record ) const noexcept
+{
+    return m_parents.data() + record.first_parent + record.parents_count;
+}
+
+boost::string_view commit_headers::author_name( const header& record ) const noexcept
+{
+    return m_identities->name( record.author );
+}
+
+boost::string_view commit_headers::author_email( const header& record ) const noexcept
+{
+    return m_identities->email( record.author );
+}
+
+auto commit_headers::identities() const noexcept -> const std::shared_ptr< identity_table >&
+{
+    return m_identities;
+}
+
+auto commit_headers::missing() const noexcept -> const std::vector< git_oid >&
+{
+    return m_missing;
+}
+
+}//base
+
+}//git_handler
@@ -0,0 +1,89 @@
+#ifndef GITCOMMITHEADERS_H
+#define GITCOMMITHEADERS_H
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include <boost/utility/string_view.hpp>
+
+#include <git2.h>
+
+#include "GitIdentityTable.h"
+
+namespace details
+{
+
+struct commit_header_fields;
+
+}
+
+namespace git_handler
+{
+
+namespace base
+{
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////              CommitHeaders              //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+// Compact records of commits parsed straight from their raw objects, for code that needs
+// the ids, parents, times and authors of many commits but none of the rest. The parents of all
+// the records are kept in one array, authors are ids of an identity table
+class commit_headers
+{
+public:
+    struct header
+    {
+        git_oid id;
+        // committer time, what git_commit_time() returns
+        git_time time;
+        git_time_t author_time;
+        uint32_t first_parent;
+        uint32_t parents_count;
+        identity_table::identity_id author;
+    };
+
+    using const_iterator = std::vector< header >::const_iterator;
+
+public:
+    // without an identity table the batch gets its own one
+    explicit commit_headers( std::shared_ptr< identity_table > identities = nullptr );
+
+    // throws std::logic_error if the batch outgrows the 32 bit offsets,
+    // a commit with a malformed parent id is added as missing
+    void add( const git_oid& id, const details::commit_header_fields& fields );
+    // appends the records of the other batch, keeping their order
+    void append( const commit_headers& other );
+    void add_missing( const git_oid& id );
+    void reserve( const size_t count );
+
+    size_t size() const noexcept;
+    bool empty() const noexcept;
+    const header& operator[]( const size_t index ) const noexcept;
+    const_iterator begin() const noexcept;
+    const_iterator end() const noexcept;
+
+    // parents are valid as long as the batch isn't changed, authors as long as its identity table
+    const git_oid* parents_begin( const header& record ) const noexcept;
+    const git_oid* parents_end( const header& record ) const noexcept;
+    boost::string_view author_name( const header& record ) const noexcept;
+    boost::string_view author_email( const header& record ) const noexcept;
+    const std::shared_ptr< identity_table >& identities() const noexcept;
+
+    // ids that were not found or not commits
+    const std::vector< git_oid >& missing() const noexcept;
+
+private:
+    std::vector< header > m_headers;
+    std::vector< git_oid > m_parents;
+    std::shared_ptr< identity_table > m_identities;
+    std::vector< git_oid > m_missing;
+};
+
+}//base
+
+}//git_handler
+
+#endif // GITCOMMITHEADERS_H
@@ -0,0 +1,455 @@
+#include <memory>
+#include <cstdio>
+#include <numeric>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <boost/filesystem.hpp>
+
+#include "GitCommitMetadata.h"
+#include "GitBaseClasses.h"
+#include "details/OidHash.h"
+
+namespace git_handler
+{
+
+namespace base
+{
+
+namespace
+{
+
+const char metadata_magic[ 8 ]{ 'G', 'H', 'C', 'M', 'E', 'T', 'A', '\0' };
+// version 2 sorts the refs by name
+const uint32_t metadata_version{ 2 };
+
+uint64_t align( const uint64_t offset ) noexcept
+{
+    return ( offset + 7 ) & ~uint64_t{ 7 };
+}
+
+// offsets of the sections following the header, the last one is the file size
+struct sections
+{
+    uint64_t refs;
+    uint64_t commits;
+    uint64_t parents;
+    uint64_t ref_commits;
+    uint64_t strings;
+    uint64_t end;
+};
+
+sections layout( const commit_metadata::file_header& header ) noexcept
+{
+    sections result;
+    result.refs = align( sizeof( commit_metadata::file_header ) );
+    result.commits = align( result.refs + header.refs_count * sizeof( commit_metadata::ref_record ) );
+    result.parents = align( result.commits + header.commits_count * sizeof( commit_metadata::commit_record ) );
+    result.ref_commits = align( result.parents + header.parents_count * sizeof( git_oid ) );
+    result.strings = align( result.ref_commits + header.ref_commits_count * sizeof( uint64_t ) );
+    result.end = result.strings + header.strings_size;
+
+    return result;
+}
+
+bool fits( const uint64_t offset, const uint64_t size, const uint64_t total ) noexcept
+{
+    return offset <= total && size <= total - offset;
+}
+
+// the data reaches the disk before the file is renamed into place, so a crash can't leave a truncated file
+void write_synced( const std::string& path, const std::vector< char >& data )
+{
+    std::unique_ptr< FILE, int(*)( FILE* ) > file{ std::fopen( path.c_str(), "wb" ), &std::fclose };
+    if( !file )
+    {
+        throw std::runtime_error{ "Could not create commit metadata file " + path };
+    }
+
+    bool written{ std::fwrite( data.data(), 1, data.size(), file.get() ) == data.size() && std::fflush( file.get() ) == 0 };
+#ifdef _WIN32
+    written = written && _commit( _fileno( file.get() ) ) == 0;
+#else
+    written = written && fsync( fileno( file.get() ) ) == 0;
+#endif
+
+    if( !written )
+    {
+        throw std::runtime_error{ "Could not write commit metadata to " + path };
+    }
+}
+
+#ifdef _WIN32
+// old files moved aside by replace_file() that were still mapped then
+void remove_stale( const boost::filesystem::path& path ) noexcept
+{
+    boost::system::error_code error;
+    const auto prefix = path.filename().string() + ".";
+
+    for( boost::filesystem::directory_iterator entry{ path.parent_path(), error }, end; !error && entry != end; entry.increment( error ) )
+    {
+        const auto name = entry->path().filename().string();
+        if( name.size() > prefix.size() && name.compare( 0, prefix.size(), prefix ) == 0 && entry->path().extension() == ".old" )
+        {
+            boost::system::error_code remove_error;
+            boost::filesystem::remove( entry->path(), remove_error );
+        }
+    }
+}
+#endif
+
+void replace_file( const boost::filesystem::path& from, const boost::filesystem::path& to )
+{
+    boost::system::error_code error;
+
+#ifdef _WIN32
+    // a mapped file can't be replaced on Windows, but it can be renamed, as the mapping shares it for deletion.
+    // So the old file is moved aside first and removed once nothing maps it anymore
+    remove_stale( to );
+    if( boost::filesystem::exists( to, error ) )
+    {
+        const auto aside = boost::filesystem::unique_path( to.string() + ".%%%%-%%%%-%%%%.old" );
+        boost::filesystem::rename( to, aside, error );
+        if( !error )
+        {
+            boost::filesystem::remove( aside, error );
+        }
+    }
+#endif
+
+    boost::filesystem::rename( from, to, error );
+    if( error )
+    {
+        boost::filesystem::remove( from, error );
+        throw std::runtime_error{ "Could not replace commit metadata " + to.string() };
+    }
+
+#ifndef _WIN32
+    // the rename itself is durable once the directory is synced
+    const auto dir = to.has_parent_path() ? to.parent_path().string() : std::string{ "." };
+    const int dir_fd{ ::open( dir.c_str(), O_RDONLY ) };
+    if( dir_fd >= 0 )
+    {
+        fsync( dir_fd );
+        ::close( dir_fd );
+    }
+#endif
+}
+
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////             CommitMetadata              //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr< const commit_metadata > commit_metadata::open( const std::string& path )
+{
+    boost::system::error_code error;
+    if( !boost::filesystem::is_regular_file( path, error ) )
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr< commit_metadata > metadata{ new commit_metadata{} };
+
+    try
+    {
+        if( !metadata->map( path ) )
+        {
+            return nullptr;
+        }
+    }
+    catch( const boost::interprocess::interprocess_exception& )
+    {
+        return nullptr;
+    }
+
+    return metadata;
+}
+
+bool commit_metadata::map( const std::string& path )
+{
+    using namespace boost::interprocess;
+
+    m_file = file_mapping{ path.c_str(), read_only };
+    m_region = mapped_region{ m_file, read_only };
+
+    const auto data = static_cast< const char* >( m_region.get_address() );
+    const uint64_t size{ m_region.get_size() };
+
+    if( size < sizeof( file_header ) )
+    {
+        return false;
+    }
+
+    m_header = reinterpret_cast< const file_header* >( data );
+    if( std::memcmp( m_header->magic, metadata_magic, sizeof( metadata_magic ) ) != 0 ||
+        m_header->version != metadata_version )
+    {
+        return false;
+    }
+
+    // the counts are checked against the size first, so the section offsets can't overflow
+    if( m_header->refs_count > size / sizeof( ref_record ) ||
+        m_header->commits_count > size / sizeof( commit_record ) ||
+        m_header->parents_count > size / sizeof( git_oid ) ||
+        m_header->ref_commits_count > size / sizeof( uint64_t ) ||
+        m_header->strings_size > size )
+    {
+        return false;
+    }
+
+    const auto offsets = layout( *m_header );
+    if( offsets.end > size )
+    {
+        return false;
+    }
+
+    m_refs = reinterpret_cast< const ref_record* >( data + offsets.refs );
+    m_commits = reinterpret_cast< const commit_record* >( data + offsets.commits );
+    m_parents = reinterpret_cast< const git_oid* >( data + offsets.parents );
+    m_ref_commits = reinterpret_cast< const uint64_t* >( data + offsets.ref_commits );
+    m_strings = data + offsets.strings;
+
+    // a truncated or corrupted file must not lead to reads outside of the mapping. Only the refs are
+    // checked here, the commit records of a ref are checked by find_ref(), so opening doesn't touch them
+    for( uint32_t ref_num = 0; ref_num < m_header->refs_count; ++ref_num )
+    {
+        const auto& ref = m_refs[ ref_num ];
+        if( !fits( ref.name_offset, ref.name_size, m_header->strings_size ) ||
+            !fits( ref.first_commit, ref.commits_count, m_header->ref_commits_count ) )
+        {
+            return false;
+        }
+
+        // find_ref() relies on the order
+        if( ref_num && !( str( m_refs[ ref_num - 1 ].name_offset, m_refs[ ref_num - 1 ].name_size ) < str( ref.name_offset, ref.name_size ) ) )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool commit_metadata::valid_commits( const ref_record& ref ) const noexcept
+{
+    const uint64_t strings_size{ m_header->strings_size };
+
+    for( auto index = m_ref_commits + ref.first_commit; index != m_ref_commits + ref.first_commit + ref.commits_count; ++index )
+    {
+        if( *index >= m_header->commits_count )
+        {
+            return false;
+        }
+
+        const auto& commit = m_commits[ *index ];
+        if( !fits( commit.first_parent, commit.parents_count, m_header->parents_count ) ||
+            !fits( commit.author_offset, commit.author_size, strings_size ) ||
+            !fits( commit.email_offset, commit.email_size, strings_size ) ||
+            !fits( commit.message_offset, commit.message_size, strings_size ) )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void commit_metadata::write( const std::string& path, const std::vector< ref_source >& refs )
+{
+    std::vector< ref_record > ref_records;
+    std::vector< commit_record > commit_records;
+    std::vector< git_oid > parents;
+    std::vector< uint64_t > ref_commits;
+    std::string strings;
+
+    std::unordered_map< git_oid, uint64_t, details::oid_hash, details::oid_equal > commit_indices;
+
+    auto add_string = [ & ]( const boost::string_view str, uint64_t& offset, uint32_t& size )
+                      {
+                          offset = strings.size();
+                          size = static_cast< uint32_t >( str.size() );
+                          strings.append( str.data(), str.size() );
+                      };
+
+    // the records are written in name order, so that find_ref() can search them
+    std::vector< size_t > order( refs.size() );
+    std::iota( order.begin(), order.end(), size_t{ 0 } );
+    std::sort( order.begin(), order.end(), [ & ]( const size_t left, const size_t right ){ return refs[ left ].name < refs[ right ].name; } );
+
+    for( const auto ref_num : order )
+    {
+        const auto& ref = refs[ ref_num ];
+
+        ref_record ref_rec{};
+        ref_rec.tip = ref.tip;
+        ref_rec.first_commit = ref_commits.size();
+        ref_rec.commits_count = ref.commits.size();
+        add_string( ref.name, ref_rec.name_offset, ref_rec.name_size );
+
+        for( const auto commit : ref.commits )
+        {
+            if( !commit || !commit->isValid() )
+            {
+                throw std::runtime_error{ "Could not read commit metadata" };
+            }
+
+            const git_oid id{ commit->id() };
+
+            auto stored = commit_indices.find( id );
+            if( stored != commit_indices.end() )
+            {
+                ref_commits.push_back( stored->second );
+                continue;
+            }
+
+            // the commits are already read, lazy ones are loaded only for the time of their record
+            const commit_wrapper::view_scope scope{ *commit };
+            const auto time = commit->time();
+
+            commit_record record{};
+            record.id = id;
+            record.time = time.time;
+            record.time_offset = time.offset;
+            record.first_parent = parents.size();
+
+            const auto commit_parents = commit->parents();
+            record.parents_count = static_cast< uint32_t >( commit_parents.size() );
+            parents.insert( parents.end(), commit_parents.begin(), commit_parents.end() );
+
+            add_string( commit->author_view(), record.author_offset, record.author_size );
+            add_string( commit->author_email_view(), record.email_offset, record.email_size );
+            add_string( commit->message_view(), record.message_offset, record.message_size );
+
+            commit_indices.emplace( id, commit_records.size() );
+            ref_commits.push_back( commit_records.size() );
+            commit_records.push_back( record );
+        }
+
+        ref_records.push_back( ref_rec );
+    }
+
+    file_header header{};
+    std::memcpy( header.magic, metadata_magic, sizeof( metadata_magic ) );
+    header.version = metadata_version;
+    header.refs_count = static_cast< uint32_t >( ref_records.size() );
+    header.commits_count = commit_records.size();
+    header.parents_count = parents.size();
+    header.ref_commits_count = ref_commits.size();
+    header.strings_size = strings.size();
+
+    const auto offsets = layout( header );
+
+    std::vector< char > buffer( offsets.end, 0 );
+    std::memcpy( buffer.data(), &header, sizeof( header ) );
+    std::memcpy( buffer.data() + offsets.refs, ref_records.data(), ref_records.size() * sizeof( ref_record ) );
+    std::memcpy( buffer.data() + offsets.commits, commit_records.data(), commit_records.size() * sizeof( commit_record ) );
+    std::memcpy( buffer.data() + offsets.parents, parents.data(), parents.size() * sizeof( git_oid ) );
+    std::memcpy( buffer.data() + offsets.ref_commits, ref_commits.data(), ref_commits.size() * sizeof( uint64_t ) );
+    std::memcpy( buffer.data() + offsets.strings, strings.data(), strings.size() );
+
+    // the old file may still be mapped, so the new one is written aside and renamed over it.
+    // The temporary name is unique, other processes may be saving the same file
+    const auto temp_path = boost::filesystem::unique_path( path + ".%%%%-%%%%-%%%%.tmp" );
+
+    try
+    {
+        write_synced( temp_path.string(), buffer );
+    }
+    catch( ... )
+    {
+        boost::system::error_code error;
+        boost::filesystem::remove( temp_path, error );
+        throw;
+    }
+
+    replace_file( temp_path, path );
+}
+
+size_t commit_metadata::refs_count() const noexcept
+{
+    return m_header->refs_count;
+}
+
+size_t commit_metadata::commits_count() const noexcept
+{
+    return m_header->commits_count;
+}
+
+bool commit_metadata::find_ref( const std::string& ref_name, ref_view& ref ) const noexcept
+{
+    const auto refs_end = m_refs + m_header->refs_count;
+    const auto record = std::lower_bound( m_refs, refs_end, ref_name,
+                                          [ this ]( const ref_record& left, const std::string& name )
+                                          {
+                                              return str( left.name_offset, left.name_size ) < boost::string_view{ name };
+                                          } );
+
+    if( record == refs_end || str( record->name_offset, record->name_size ) != boost::string_view{ ref_name } ||
+        !valid_commits( *record ) )
+    {
+        return false;
+    }
+
+    ref.tip = record->tip;
+    ref.first = m_ref_commits + record->first_commit;
+    ref.last = ref.first + record->commits_count;
+    return true;
+}
+
+auto commit_metadata::commit( const uint64_t index ) const noexcept -> const commit_record&
+{
+    return m_commits[ index ];
+}
+
+git_time commit_metadata::time( const uint64_t index ) const noexcept
+{
+    const auto& record = m_commits[ index ];
+
+    git_time time{};
+    time.time = record.time;
+    time.offset = record.time_offset;
+    time.sign = record.time_offset < 0 ? '-' : '+';
+
+    return time;
+}
+
+boost::string_view commit_metadata::author( const uint64_t index ) const noexcept
+{
+    return str( m_commits[ index ].author_offset, m_commits[ index ].author_size );
+}
+
+boost::string_view commit_metadata::email( const uint64_t index ) const noexcept
+{
+    return str( m_commits[ index ].email_offset, m_commits[ index ].email_size );
+}
+
+boost::string_view commit_metadata::message( const uint64_t index ) const noexcept
+{
+    return str( m_commits[ index ].message_offset, m_commits[ index ].message_size );
+}
+
+std::vector< git_oid > commit_metadata::parents( const uint64_t index ) const
+{
+    const auto& record = m_commits[ index ];
+    return { m_parents + record.first_parent, m_parents + record.first_parent + record.parents_count };
+}
+
+boost::string_view commit_metadata::str( const uint64_t offset, const uint32_t size ) const noexcept
+{
+    return { m_strings + offset, size };
+}
+
+}//base
+
+}//git_handler
@@ -0,0 +1,135 @@
+#ifndef GITCOMMITMETADATA_H
+#define GITCOMMITMETADATA_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <boost/utility/string_view.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <git2.h>
+
+namespace git_handler
+{
+
+namespace base
+{
+
+class commit_wrapper;
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////             CommitMetadata              //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+// Commit metadata of a repo saved to a file and memory-mapped back on the next start.
+// Stores the tips of the saved branches, their commits and for every commit its id, time,
+// parents, author and message. Records are in the native byte order, the file is meant
+// for the machine that has written it. The refs are sorted by name. Opening maps the file and
+// checks its header and refs only, the commit records of a ref are checked when the ref is looked up
+class commit_metadata
+{
+public:
+    // on-disk layout
+    struct file_header
+    {
+        char magic[ 8 ];
+        uint32_t version;
+        uint32_t refs_count;
+        uint64_t commits_count;
+        uint64_t parents_count;
+        uint64_t ref_commits_count;
+        uint64_t strings_size;
+    };
+
+    struct ref_record
+    {
+        git_oid tip;
+        uint32_t name_size;
+        uint64_t name_offset;
+        // the ref's commits are ref_commits_count record indices starting at first_commit
+        uint64_t first_commit;
+        uint64_t commits_count;
+    };
+
+    struct commit_record
+    {
+        git_oid id;
+        int32_t time_offset;
+        int64_t time;
+        uint64_t first_parent;
+        uint32_t parents_count;
+        uint32_t author_size;
+        uint64_t author_offset;
+        uint32_t email_size;
+        uint32_t message_size;
+        uint64_t email_offset;
+        uint64_t message_offset;
+    };
+
+    // a saved branch, its commits in the order they are stored in the branch
+    struct ref_view
+    {
+        git_oid tip;
+        const uint64_t* first;
+        const uint64_t* last;
+    };
+
+    // what write() saves of a branch, the commits must outlive the call
+    struct ref_source
+    {
+        std::string name;
+        git_oid tip;
+        std::vector< const commit_wrapper* > commits;
+    };
+
+public:
+    // nullptr if there's no such file or it isn't a valid metadata file
+    static std::shared_ptr< const commit_metadata > open( const std::string& path );
+    // saves the refs along with their already read commits, the file is replaced atomically,
+    // also while it is mapped by open()
+    static void write( const std::string& path, const std::vector< ref_source >& refs );
+
+    commit_metadata( const commit_metadata& ) = delete;
+    commit_metadata& operator=( const commit_metadata& ) = delete;
+
+    size_t refs_count() const noexcept;
+    size_t commits_count() const noexcept;
+
+    // binary search by name, false if there's no such ref or its commit records are corrupted
+    bool find_ref( const std::string& ref_name, ref_view& ref ) const noexcept;
+
+    const commit_record& commit( const uint64_t index ) const noexcept;
+    git_time time( const uint64_t index ) const noexcept;
+    // views into the mapped file, valid as long as the metadata
+    boost::string_view author( const uint64_t index ) const noexcept;
+    boost::string_view email( const uint64_t index ) const noexcept;
+    boost::string_view message( const uint64_t index ) const noexcept;
+    std::vector< git_oid > parents( const uint64_t index ) const;
+
+private:
+    commit_metadata() = default;
+
+    bool map( const std::string& path );
+    bool valid_commits( const ref_record& ref ) const noexcept;
+    boost::string_view str( const uint64_t offset, const uint32_t size ) const noexcept;
+
+private:
+    boost::interprocess::file_mapping m_file;
+    boost::interprocess::mapped_region m_region;
+
+    const file_header* m_header{ nullptr };
+    const ref_record* m_refs{ nullptr };
+    const commit_record* m_commits{ nullptr };
+    const git_oid* m_parents{ nullptr };
+    const uint64_t* m_ref_commits{ nullptr };
+    const char* m_strings{ nullptr };
+};
+
+}//base
+
+}//git_handler
+
+#endif // GITCOMMITMETADATA_H
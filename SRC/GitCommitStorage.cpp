@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <iterator>
+#include <cstring>
+
+#include "GitCommitStorage.h"
+#include "details/OidHash.h"
+
+namespace git_handler
+{
+
+namespace base
+{
+
+namespace
+{
+
+bool is_zero( const git_oid& id ) noexcept
+{
+    static const git_oid zero_id{};
+    return std::memcmp( id.id, zero_id.id, sizeof( id.id ) ) == 0;
+}
+
+bool entry_less( const commit_storage::entry& left, const commit_storage::entry& right ) noexcept
+{
+    if( left.time != right.time )
+    {
+        return left.time < right.time;
+    }
+
+    return std::memcmp( left.id.id, right.id.id, sizeof( left.id.id ) ) < 0;
+}
+
+bool entry_time_less( const commit_storage::entry& left, const git_time_t time ) noexcept
+{
+    return left.time < time;
+}
+
+bool time_entry_less( const git_time_t time, const commit_storage::entry& right ) noexcept
+{
+    return time < right.time;
+}
+
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////              CommitStorage              //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+bool commit_storage::add( entry commit )
+{
+    entries batch;
+    batch.push_back( std::move( commit ) );
+
+    return add( std::move( batch ) ) != 0;
+}
+
+size_t commit_storage::add( entries&& batch )
+{
+    // time sorted revwalks produce the commits newest first
+    if( std::is_sorted( batch.rbegin(), batch.rend(), entry_less ) )
+    {
+        std::reverse( batch.begin(), batch.end() );
+    }
+    else
+    {
+        std::sort( batch.begin(), batch.end(), entry_less );
+    }
+
+    // a commit's time is part of its content, so duplicates in the batch end up next to each other
+    details::oid_equal equal;
+    git_oid previous_id{};
+
+    auto new_end = std::remove_if( batch.begin(), batch.end(),
+                                   [ & ]( const entry& commit )
+                                   {
+                                       bool duplicate = equal( previous_id, commit.id ) || contains( commit.id );
+                                       previous_id = commit.id;
+                                       return duplicate;
+                                   } );
+
+    batch.erase( new_end, batch.end() );
+
+    if( batch.empty() )
+    {
+        return 0;
+    }
+
+    const size_t added{ batch.size() };
+    const size_t old_size{ m_entries.size() };
+
+    if( m_entries.empty() )
+    {
+        m_entries.swap( batch );
+    }
+    else
+    {
+        m_entries.insert( m_entries.end(),
+                          std::make_move_iterator( batch.begin() ),
+                          std::make_move_iterator( batch.end() ) );
+    }
+
+    // new commits are usually newer than the stored ones, in which case the stored
+    // positions stay valid and only the new ones have to be indexed
+    auto middle = m_entries.begin() + old_size;
+    if( old_size && entry_less( *middle, *std::prev( middle ) ) )
+    {
+        std::inplace_merge( m_entries.begin(), middle, m_entries.end(), entry_less );
+        index_rebuild( m_entries.size() );
+    }
+    else if( m_index.size() < m_entries.size() * 2 )
+    {
+        index_rebuild( m_entries.size() );
+    }
+    else
+    {
+        for( size_t position = old_size; position < m_entries.size(); ++position )
+        {
+            index_insert( m_entries[ position ].id, static_cast< uint32_t >( position ) );
+        }
+    }
+
+    return added;
+}
+
+void commit_storage::reserve( const size_t count )
+{
+    m_entries.reserve( count );
+}
+
+void commit_storage::clear() noexcept
+{
+    m_entries.clear();
+    m_index.clear();
+}
+
+auto commit_storage::begin() const noexcept -> const_iterator
+{
+    return m_entries.begin();
+}
+
+auto commit_storage::end() const noexcept -> const_iterator
+{
+    return m_entries.end();
+}
+
+size_t commit_storage::size() const noexcept
+{
+    return m_entries.size();
+}
+
+bool commit_storage::empty() const noexcept
+{
+    return m_entries.empty();
+}
+
+auto commit_storage::find( const git_oid& id ) const noexcept -> const entry*
+{
+    auto slot = find_slot( id );
+    return slot ? &m_entries[ slot->position ] : nullptr;
+}
+
+bool commit_storage::contains( const git_oid& id ) const noexcept
+{
+    return find_slot( id ) != nullptr;
+}
+
+auto commit_storage::time_range( const git_time_t from, const git_time_t to ) const noexcept -> range
+{
+    auto first = std::lower_bound( m_entries.begin(), m_entries.end(), from, entry_time_less );
+    auto last = std::upper_bound( first, m_entries.end(), to, time_entry_less );
+
+    return { first, std::max( first, last ) };
+}
+
+auto commit_storage::find_slot( const git_oid& id ) const noexcept -> const index_slot*
+{
+    if( m_index.empty() || is_zero( id ) )
+    {
+        return nullptr;
+    }
+
+    const size_t mask{ m_index.size() - 1 };
+    details::oid_equal equal;
+
+    for( size_t slot = details::oid_hash{}( id ) & mask; ; slot = ( slot + 1 ) & mask )
+    {
+        const auto& current = m_index[ slot ];
+        if( is_zero( current.id ) )
+        {
+            return nullptr;
+        }
+
+        if( equal( current.id, id ) )
+        {
+            return &current;
+        }
+    }
+}
+
+void commit_storage::index_insert( const git_oid& id, const uint32_t position ) noexcept
+{
+    const size_t mask{ m_index.size() - 1 };
+
+    size_t slot = details::oid_hash{}( id ) & mask;
+    while( !is_zero( m_index[ slot ].id ) )
+    {
+        slot = ( slot + 1 ) & mask;
+    }
+
+    m_index[ slot ] = { id, position };
+}
+
+void commit_storage::index_rebuild( const size_t count )
+{
+    // keep the load factor under 1/2 so that probe sequences stay short
+    size_t capacity{ std::max< size_t >( m_index.size(), 16 ) };
+    while( capacity < count * 2 )
+    {
+        capacity *= 2;
+    }
+
+    m_index.assign( capacity, index_slot{} );
+
+    for( size_t position = 0; position < m_entries.size(); ++position )
+    {
+        index_insert( m_entries[ position ].id, static_cast< uint32_t >( position ) );
+    }
+}
+
+}//base
+
+}//git_handler
@@ -0,0 +1,83 @@
+#ifndef GITCOMMITSTORAGE_H
+#define GITCOMMITSTORAGE_H
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include <git2.h>
+
+namespace git_handler
+{
+
+namespace base
+{
+
+class commit_wrapper;
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////              CommitStorage              //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+// Branch commits kept in a contiguous vector sorted by ( time, id ), plus an open addressing
+// oid -> position index used for lookups and deduplication. Commits are added in batches,
+// so a whole revwalk costs one sort, and adding commits newer than the stored ones doesn't
+// touch the existing entries at all
+class commit_storage
+{
+public:
+    struct entry
+    {
+        git_time_t time;
+        git_oid id;
+        std::shared_ptr< commit_wrapper > commit;
+    };
+
+    using entries = std::vector< entry >;
+    using const_iterator = entries::const_iterator;
+    using range = std::pair< const_iterator, const_iterator >;
+
+public:
+    // returns false if a commit with the same id is already stored
+    bool add( entry commit );
+    // adds the commits not stored yet, returns the number of added ones
+    size_t add( entries&& batch );
+    void reserve( const size_t count );
+    void clear() noexcept;
+
+    const_iterator begin() const noexcept;
+    const_iterator end() const noexcept;
+    size_t size() const noexcept;
+    bool empty() const noexcept;
+
+    // nullptr if there's no such commit
+    const entry* find( const git_oid& id ) const noexcept;
+    bool contains( const git_oid& id ) const noexcept;
+
+    // commits with time in [ from, to ]
+    range time_range( const git_time_t from, const git_time_t to ) const noexcept;
+
+private:
+    struct index_slot
+    {
+        git_oid id;
+        uint32_t position;
+    };
+
+    using index = std::vector< index_slot >;
+
+private:
+    const index_slot* find_slot( const git_oid& id ) const noexcept;
+    void index_insert( const git_oid& id, const uint32_t position ) noexcept;
+    void index_rebuild( const size_t count );
+
+private:
+    entries m_entries;
+    index m_index;
+};
+
+}//base
+
+}//git_handler
+
+#endif // GITCOMMITSTORAGE_H
@@ -0,0 +1,304 @@
+#include <limits>
+#include <stdexcept>
+
+#include "GitCommitTable.h"
+#include "GitBaseClasses.h"
+#include "details/CommitHeaderParser.h"
+
+namespace git_handler
+{
+
+namespace base
+{
+
+namespace
+{
+
+const git_time_t seconds_per_day{ 86400 };
+
+// days since the epoch, rounding down for times before it
+git_time_t utc_day( const git_time_t time ) noexcept
+{
+    return time >= 0 ? time / seconds_per_day : ( time - seconds_per_day + 1 ) / seconds_per_day;
+}
+
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////               CommitTable               //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+const commit_table::author_id commit_table::any_author;
+const commit_table::author_id commit_table::no_author;
+
+commit_table::commit_table( std::shared_ptr< identity_table > identities ) :
+    m_identities( identities ? std::move( identities ) : std::make_shared< identity_table >() )
+{
+
+}
+
+void commit_table::add( const git_oid& id, const details::commit_header_fields& fields )
+{
+    // commits rarely have more than two parents, those get a vector
+    git_oid few_parents[ 2 ];
+    std::vector< git_oid > many_parents( fields.parents_count > 2 ? fields.parents_count : 0 );
+    git_oid* parents = many_parents.empty() ? few_parents : many_parents.data();
+
+    for( size_t parent_num = 0; parent_num < fields.parents_count; ++parent_num )
+    {
+        if( !details::parse_parent( fields, parent_num, parents[ parent_num ] ) )
+        {
+            add_missing( id );
+            return;
+        }
+    }
+
+    add_row( id, fields.author.time, m_identities->intern( fields.author.name, fields.author.email ),
+             parents, parents + fields.parents_count, fields.message );
+}
+
+void commit_table::add( const commit_wrapper& commit )
+{
+    if( !commit.isValid() )
+    {
+        return;
+    }
+
+    const commit_wrapper::view_scope scope{ commit };
+    const auto parents = commit.parents();
+    add_row( commit.id(), commit.time().time, m_identities->intern( commit.author_view(), commit.author_email_view() ),
+             parents.data(), parents.data() + parents.size(), commit.message_view() );
+}
+
+void commit_table::add( const commit_storage& commits )
+{
+    for( const auto& entry : commits )
+    {
+        if( entry.commit && find( entry.id ) == size() )
+        {
+            add( *entry.commit );
+        }
+    }
+}
+
+void commit_table::append( const commit_table& other )
+{
+    // authors of a table with other identities are interned again
+    std::unordered_map< author_id, author_id > authors;
+    auto author = [ & ]( const author_id other_author )
+                  {
+                      if( other.m_identities == m_identities )
+                      {
+                          return other_author;
+                      }
+
+                      auto known = authors.find( other_author );
+                      if( known == authors.end() )
+                      {
+                          known = authors.emplace( other_author, m_identities->intern( other.author_name( other_author ),
+                                                                                       other.author_email( other_author ) ) ).first;
+                      }
+
+                      return known->second;
+                  };
+
+    reserve( size() + other.size() );
+
+    for( row commit = 0; commit < other.size(); ++commit )
+    {
+        add_row( other.id( commit ), other.time( commit ), author( other.author( commit ) ),
+                 other.parents_begin( commit ), other.parents_end( commit ), other.message( commit ) );
+    }
+
+    m_missing.insert( m_missing.end(), other.m_missing.begin(), other.m_missing.end() );
+}
+
+void commit_table::add_missing( const git_oid& id )
+{
+    m_missing.push_back( id );
+}
+
+void commit_table::reserve( const size_t count )
+{
+    m_ids.reserve( count );
+    m_times.reserve( count );
+    m_authors.reserve( count );
+    m_parent_offsets.reserve( count + 1 );
+    m_parents.reserve( count );
+    m_message_offsets.reserve( count + 1 );
+    m_rows.reserve( count );
+}
+
+size_t commit_table::size() const noexcept
+{
+    return m_ids.size();
+}
+
+bool commit_table::empty() const noexcept
+{
+    return m_ids.empty();
+}
+
+auto commit_table::missing() const noexcept -> const std::vector< git_oid >&
+{
+    return m_missing;
+}
+
+auto commit_table::find( const git_oid& id ) const noexcept -> row
+{
+    auto found = m_rows.find( id );
+    return found != m_rows.end() ? found->second : static_cast< row >( size() );
+}
+
+const git_oid& commit_table::id( const row commit ) const noexcept
+{
+    return m_ids[ commit ];
+}
+
+git_time_t commit_table::time( const row commit ) const noexcept
+{
+    return m_times[ commit ];
+}
+
+auto commit_table::author( const row commit ) const noexcept -> author_id
+{
+    return m_authors[ commit ];
+}
+
+boost::string_view commit_table::message( const row commit ) const noexcept
+{
+    return boost::string_view{ m_messages.data() + m_message_offsets[ commit ],
+                               static_cast< size_t >( m_message_offsets[ commit + 1 ] - m_message_offsets[ commit ] ) };
+}
+
+const git_oid* commit_table::parents_begin( const row commit ) const noexcept
+{
+    return m_parents.data() + m_parent_offsets[ commit ];
+}
+
+const git_oid* commit_table::parents_end( const row commit ) const noexcept
+{
+    return m_parents.data() + m_parent_offsets[ commit + 1 ];
+}
+
+auto commit_table::identities() const noexcept -> const std::shared_ptr< identity_table >&
+{
+    return m_identities;
+}
+
+auto commit_table::find_author( const boost::string_view name, const boost::string_view email ) const noexcept -> author_id
+{
+    return m_identities->find( name, email );
+}
+
+boost::string_view commit_table::author_name( const author_id author ) const noexcept
+{
+    return m_identities->name( author );
+}
+
+boost::string_view commit_table::author_email( const author_id author ) const noexcept
+{
+    return m_identities->email( author );
+}
+
+auto commit_table::filter( const author_id author, const git_time_t from, const git_time_t to ) const -> std::vector< row >
+{
+    // every row is written, only the matching ones move the end forward
+    std::vector< row > rows( size() + 1 );
+    size_t matched{ 0 };
+
+    const bool any{ author == any_author };
+    for( size_t commit = 0; commit < size(); ++commit )
+    {
+        rows[ matched ] = static_cast< row >( commit );
+        matched += ( any | ( m_authors[ commit ] == author ) ) & ( m_times[ commit ] >= from ) & ( m_times[ commit ] <= to );
+    }
+
+    rows.resize( matched );
+    return rows;
+}
+
+size_t commit_table::count( const author_id author, const git_time_t from, const git_time_t to ) const noexcept
+{
+    size_t matched{ 0 };
+
+    const bool any{ author == any_author };
+    for( size_t commit = 0; commit < size(); ++commit )
+    {
+        matched += ( any | ( m_authors[ commit ] == author ) ) & ( m_times[ commit ] >= from ) & ( m_times[ commit ] <= to );
+    }
+
+    return matched;
+}
+
+std::vector< uint32_t > commit_table::daily_counts( const author_id author, const git_time_t from, const git_time_t to ) const
+{
+    if( to < from )
+    {
+        return {};
+    }
+
+    const git_time_t first_day{ utc_day( from ) };
+    // one more day collects the commits out of the range, so that the loop has no branch
+    std::vector< uint32_t > counts( static_cast< size_t >( utc_day( to ) - first_day + 2 ), 0 );
+    const size_t outside{ counts.size() - 1 };
+
+    const bool any{ author == any_author };
+    for( size_t commit = 0; commit < size(); ++commit )
+    {
+        const git_time_t time{ m_times[ commit ] };
+        const bool matches( ( any | ( m_authors[ commit ] == author ) ) & ( time >= from ) & ( time <= to ) );
+        const size_t day{ static_cast< size_t >( utc_day( time ) - first_day ) };
+        ++counts[ matches ? day : outside ];
+    }
+
+    counts.pop_back();
+    return counts;
+}
+
+std::vector< uint32_t > commit_table::author_counts( const git_time_t from, const git_time_t to ) const
+{
+    // the last entry collects the commits out of the range
+    std::vector< uint32_t > counts( m_identities->size() + 1, 0 );
+    const size_t outside{ counts.size() - 1 };
+
+    for( size_t commit = 0; commit < size(); ++commit )
+    {
+        const bool matches( ( m_times[ commit ] >= from ) & ( m_times[ commit ] <= to ) );
+        ++counts[ matches ? m_authors[ commit ] : outside ];
+    }
+
+    counts.pop_back();
+    return counts;
+}
+
+bool commit_table::add_row( const git_oid& id, const git_time_t time, const author_id author,
+                            const git_oid* parents_begin, const git_oid* parents_end, const boost::string_view message )
+{
+    if( m_ids.size() >= std::numeric_limits< row >::max() - 1 ||
+        m_parents.size() + ( parents_end - parents_begin ) > std::numeric_limits< uint32_t >::max() )
+    {
+        throw std::logic_error{ "Too many commits in the table" };
+    }
+
+    if( !m_rows.emplace( id, static_cast< row >( m_ids.size() ) ).second )
+    {
+        return false;
+    }
+
+    m_ids.push_back( id );
+    m_times.push_back( time );
+    m_authors.push_back( author );
+
+    m_parents.insert( m_parents.end(), parents_begin, parents_end );
+    m_parent_offsets.push_back( static_cast< uint32_t >( m_parents.size() ) );
+
+    m_messages.append( message.data(), message.size() );
+    m_message_offsets.push_back( m_messages.size() );
+
+    return true;
+}
+
+}//base
+
+}//git_handler
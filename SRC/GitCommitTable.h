@@ -0,0 +1,124 @@
+#ifndef GITCOMMITTABLE_H
+#define GITCOMMITTABLE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+#include <boost/utility/string_view.hpp>
+
+#include <git2.h>
+
+#include "GitIdentityTable.h"
+#include "details/OidHash.h"
+
+namespace details
+{
+
+struct commit_header_fields;
+
+}
+
+namespace git_handler
+{
+
+namespace base
+{
+
+class commit_wrapper;
+class commit_storage;
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////               CommitTable               //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+// Commits stored column by column for analytics: ids, times, author ids, parents and messages
+// each live in their own array, parents and messages being offsets into one array and one string.
+// Authors are ids of an identity table, which may be shared with other tables. Times are author
+// times, like commit_wrapper::time(), whether the commits come from raw objects or from wrappers.
+// Scans only touch the columns they need and are written without branches, so that compilers
+// can vectorize them.
+// A commit is stored once, whatever the number of times it is added
+class commit_table
+{
+public:
+    using row = uint32_t;
+    using author_id = identity_table::identity_id;
+
+    // matches every author in scans
+    static const author_id any_author{ identity_table::no_identity };
+    static const author_id no_author{ identity_table::no_identity };
+
+public:
+    // without an identity table the table gets its own one
+    explicit commit_table( std::shared_ptr< identity_table > identities = nullptr );
+
+    // from a raw commit parsed by details::parse_commit_header(), one with a malformed parent id is added as missing
+    void add( const git_oid& id, const details::commit_header_fields& fields );
+    // from a commit read through libgit2 or saved metadata
+    void add( const commit_wrapper& commit );
+    void add( const commit_storage& commits );
+    // adds the commits of the other table not stored yet, in its order
+    void append( const commit_table& other );
+    void add_missing( const git_oid& id );
+    void reserve( const size_t count );
+
+    size_t size() const noexcept;
+    bool empty() const noexcept;
+    // ids that were not found or not commits
+    const std::vector< git_oid >& missing() const noexcept;
+
+    // row of the commit, size() if it isn't stored
+    row find( const git_oid& id ) const noexcept;
+    const git_oid& id( const row commit ) const noexcept;
+    git_time_t time( const row commit ) const noexcept;
+    author_id author( const row commit ) const noexcept;
+    boost::string_view message( const row commit ) const noexcept;
+    const git_oid* parents_begin( const row commit ) const noexcept;
+    const git_oid* parents_end( const row commit ) const noexcept;
+
+    const std::shared_ptr< identity_table >& identities() const noexcept;
+    // no_author if there's no such author
+    author_id find_author( const boost::string_view name, const boost::string_view email ) const noexcept;
+    boost::string_view author_name( const author_id author ) const noexcept;
+    boost::string_view author_email( const author_id author ) const noexcept;
+
+    // commits of the author ( any_author for all of them ) with time in [ from, to ], in row order
+    std::vector< row > filter( const author_id author, const git_time_t from, const git_time_t to ) const;
+    size_t count( const author_id author, const git_time_t from, const git_time_t to ) const noexcept;
+    // Commits per utc day, the first entry being the day of from, the last one the day of to.
+    // Empty if to is before from
+    std::vector< uint32_t > daily_counts( const author_id author, const git_time_t from, const git_time_t to ) const;
+    // commits with time in [ from, to ] per author, indexed by author id
+    std::vector< uint32_t > author_counts( const git_time_t from, const git_time_t to ) const;
+
+private:
+    using row_index = std::unordered_map< git_oid, row, details::oid_hash, details::oid_equal >;
+
+private:
+    // false if the commit is already stored
+    bool add_row( const git_oid& id, const git_time_t time, const author_id author,
+                  const git_oid* parents_begin, const git_oid* parents_end, const boost::string_view message );
+
+private:
+    std::vector< git_oid > m_ids;
+    std::vector< git_time_t > m_times;
+    std::vector< author_id > m_authors;
+    // commit parents are [ m_parent_offsets[ row ], m_parent_offsets[ row + 1 ] ) of m_parents
+    std::vector< uint32_t > m_parent_offsets{ 0 };
+    std::vector< git_oid > m_parents;
+    // the same for messages in m_messages
+    std::vector< uint64_t > m_message_offsets{ 0 };
+    std::string m_messages;
+    row_index m_rows;
+    std::shared_ptr< identity_table > m_identities;
+    std::vector< git_oid > m_missing;
+};
+
+}//base
+
+}//git_handler
+
+#endif // GITCOMMITTABLE_H
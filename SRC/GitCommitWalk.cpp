@@ -0,0 +1,218 @@
+#include <algorithm>
+
+#include "GitBaseClasses.h"
+
+namespace git_handler
+{
+
+namespace base
+{
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////                CommitWalk               //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+commit_walk::iterator::iterator( commit_walk* walk ) : m_walk( walk )
+{
+    ++( *this );
+}
+
+auto commit_walk::iterator::operator*() const noexcept -> reference
+{
+    return m_current;
+}
+
+auto commit_walk::iterator::operator->() const noexcept -> pointer
+{
+    return &m_current;
+}
+
+auto commit_walk::iterator::operator++() -> iterator&
+{
+    if( m_walk )
+    {
+        m_current = m_walk->next();
+        if( !m_current )
+        {
+            m_walk = nullptr;
+        }
+    }
+
+    return *this;
+}
+
+bool commit_walk::iterator::operator==( const iterator& other ) const noexcept
+{
+    return m_walk == other.m_walk && m_current == other.m_current;
+}
+
+bool commit_walk::iterator::operator!=( const iterator& other ) const noexcept
+{
+    return !( *this == other );
+}
+
+commit_walk::commit_walk( repo_wrapper* repo,
+                          item::git_item< git_revwalk >&& walker,
+                          const walk_options& options ) :
+    m_repo( repo ),
+    m_walker( std::move( walker ) ),
+    m_options( options )
+{
+
+}
+
+commit_walk::commit_walk( repo_wrapper* repo, commit_ptr from, const walk_options& options ) :
+    m_repo( repo ),
+    m_options( options )
+{
+    m_queued.insert( from->id() );
+    m_frontier.push_back( std::move( from ) );
+}
+
+auto commit_walk::begin() -> iterator
+{
+    return iterator{ this };
+}
+
+auto commit_walk::end() noexcept -> iterator
+{
+    return iterator{};
+}
+
+auto commit_walk::next() -> commit_ptr
+{
+    if( m_options.limit && m_yielded >= m_options.limit )
+    {
+        stop();
+        return nullptr;
+    }
+
+    size_t old_in_a_row{ 0 };
+    while( auto commit = m_walker ? next_walked() : next_streamed() )
+    {
+        if( m_options.since && commit->time().time < m_options.since )
+        {
+            // newer commits may still follow a few skewed ones
+            if( is_time_ordered( m_options.strategy ) && ++old_in_a_row >= m_options.since_slop && !newer_queued() )
+            {
+                break;
+            }
+
+            continue;
+        }
+
+        ++m_yielded;
+        return commit;
+    }
+
+    stop();
+    return nullptr;
+}
+
+void commit_walk::stop() noexcept
+{
+    m_walker.reset();
+    m_frontier.clear();
+    m_queued.clear();
+}
+
+size_t commit_walk::yielded() const noexcept
+{
+    return m_yielded;
+}
+
+void commit_walk::set_sorting( git_revwalk* walker, const walk_strategy strategy )
+{
+    switch( strategy )
+    {
+    case walk_strategy::time:
+        git_revwalk_sorting( walker, GIT_SORT_TIME );
+        break;
+    case walk_strategy::topological:
+        git_revwalk_sorting( walker, GIT_SORT_TOPOLOGICAL | GIT_SORT_TIME );
+        break;
+    case walk_strategy::first_parent:
+        // a single chain is newest first as it is, sorting it would only load it up front
+        git_revwalk_sorting( walker, GIT_SORT_NONE );
+        git_revwalk_simplify_first_parent( walker );
+        break;
+    case walk_strategy::reverse:
+        git_revwalk_sorting( walker, GIT_SORT_TOPOLOGICAL | GIT_SORT_TIME | GIT_SORT_REVERSE );
+        break;
+    }
+}
+
+auto commit_walk::next_walked() -> commit_ptr
+{
+    git_oid oid;
+    const int result{ git_revwalk_next( &oid, m_walker.get() ) };
+    if( result == GIT_ITEROVER )
+    {
+        return nullptr;
+    }
+
+    if( result != 0 )
+    {
+        stop();
+        throw std::runtime_error{ "Could not walk the history" };
+    }
+
+    auto commit = m_repo->get_commit( oid );
+    if( !commit )
+    {
+        stop();
+        throw std::logic_error{ "Could not read commit" };
+    }
+
+    return commit;
+}
+
+auto commit_walk::next_streamed() -> commit_ptr
+{
+    if( m_frontier.empty() )
+    {
+        return nullptr;
+    }
+
+    auto older = []( const commit_ptr& left, const commit_ptr& right ){ return left->time().time < right->time().time; };
+
+    std::pop_heap( m_frontier.begin(), m_frontier.end(), older );
+    auto commit = std::move( m_frontier.back() );
+    m_frontier.pop_back();
+
+    // parents are read as their children are yielded, so the walk never looks further than the frontier
+    for( const auto& parent : commit->parents() )
+    {
+        if( !m_queued.insert( parent ).second )
+        {
+            continue;
+        }
+
+        auto parent_commit = m_repo->get_commit( parent );
+        if( !parent_commit )
+        {
+            stop();
+            throw std::logic_error{ "Could not read commit" };
+        }
+
+        m_frontier.push_back( std::move( parent_commit ) );
+        std::push_heap( m_frontier.begin(), m_frontier.end(), older );
+    }
+
+    return commit;
+}
+
+bool commit_walk::newer_queued() const noexcept
+{
+    // the top of the heap is the newest queued commit
+    return !m_frontier.empty() && m_frontier.front()->time().time >= m_options.since;
+}
+
+bool commit_walk::is_time_ordered( const walk_strategy strategy ) noexcept
+{
+    return strategy == walk_strategy::time || strategy == walk_strategy::first_parent;
+}
+
+}//base
+
+}//git_handler
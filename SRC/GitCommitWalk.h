@@ -0,0 +1,137 @@
+#ifndef GITCOMMITWALK_H
+#define GITCOMMITWALK_H
+
+#include <vector>
+#include <iterator>
+#include <unordered_set>
+
+#include "GitItem.h"
+#include "details/OidHash.h"
+
+namespace git_handler
+{
+
+namespace base
+{
+
+class repo_wrapper;
+class commit_wrapper;
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////                CommitWalk               //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+// Order of a walk. libgit2 loads and sorts the whole reachable graph before yielding anything
+// from a sorted revwalk, so only the strategies that get around sorting it are streamed
+enum class walk_strategy
+{
+    // newest commits first, streamed through a date ordered frontier of commits: the first commit
+    // costs about one commit read. Walks hiding commits fall back to a sorted revwalk
+    time,
+    // parents never before their children, the first commit costs about as much as the full walk
+    topological,
+    // only the first parent of every commit, newest first, merged-in histories are skipped.
+    // The chain is walked unsorted, so it is streamed unless commits are hidden
+    first_parent,
+    // oldest commits first, the first commit costs about as much as the full walk
+    reverse
+};
+
+struct walk_options
+{
+    walk_strategy strategy{ walk_strategy::time };
+    // max number of commits to yield, 0 - no limit
+    size_t limit{ 0 };
+    // commits whose time() is older than that are not yielded, 0 - no bound
+    git_time_t since{ 0 };
+    // Histories aren't strictly ordered by date: rebased and cherry-picked commits keep their old
+    // author dates. The time ordered walks end after that many old commits in a row, the streamed
+    // one also only once its frontier holds nothing newer, the others skip old commits
+    size_t since_slop{ 5 };
+    // commits reachable from these ones are not yielded
+    std::vector< git_oid > hide;
+};
+
+// Pull-based walk over a history, commits are read one by one as the revwalk produces them
+// in the order of the walk strategy. With the streamed strategies stopping early costs
+// only what has been read so far.
+// The walk must not outlive the repo it has been created by
+class commit_walk
+{
+public:
+    using commit_ptr = std::shared_ptr< commit_wrapper >;
+
+    class iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = commit_ptr;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const commit_ptr*;
+        using reference = const commit_ptr&;
+
+    public:
+        iterator() = default;
+        explicit iterator( commit_walk* walk );
+
+        reference operator*() const noexcept;
+        pointer operator->() const noexcept;
+        iterator& operator++();
+
+        bool operator==( const iterator& other ) const noexcept;
+        bool operator!=( const iterator& other ) const noexcept;
+
+    private:
+        commit_walk* m_walk{ nullptr };
+        commit_ptr m_current;
+    };
+
+public:
+    commit_walk( repo_wrapper* repo,
+                 item::git_item< git_revwalk >&& walker,
+                 const walk_options& options );
+    // streamed time ordered walk from the commit, without a revwalk
+    commit_walk( repo_wrapper* repo, commit_ptr from, const walk_options& options );
+
+    commit_walk( commit_walk&& ) = default;
+    commit_walk& operator=( commit_walk&& ) = default;
+
+    iterator begin();
+    iterator end() noexcept;
+
+    // returns the next commit, nullptr once the walk is over
+    commit_ptr next();
+    // ends the walk and releases the revwalk or the frontier
+    void stop() noexcept;
+
+    size_t yielded() const noexcept;
+
+    // sets up a revwalk for the strategy, before anything is pushed to it
+    static void set_sorting( git_revwalk* walker, const walk_strategy strategy );
+    // whether the strategy yields the newest commits first
+    static bool is_time_ordered( const walk_strategy strategy ) noexcept;
+
+private:
+    using oid_set = std::unordered_set< git_oid, details::oid_hash, details::oid_equal >;
+
+private:
+    commit_ptr next_walked();
+    commit_ptr next_streamed();
+    // whether a commit not older than since is waiting in the frontier
+    bool newer_queued() const noexcept;
+
+private:
+    repo_wrapper* m_repo;
+    item::git_item< git_revwalk > m_walker;
+    // heap of the commits whose children have been yielded, newest on top, and every commit put in it
+    std::vector< commit_ptr > m_frontier;
+    oid_set m_queued;
+    walk_options m_options;
+    size_t m_yielded{ 0 };
+};
+
+}//base
+
+}//git_handler
+
+#endif // GITCOMMITWALK_H
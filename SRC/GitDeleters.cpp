@@ -72,6 +72,66 @@ void delete_item( git_revwalk* rv )
     }
 }
 
+template<>
+void delete_item( git_reference_iterator* iter )
+{
+    if( iter != nullptr )
+    {
+        git_reference_iterator_free( iter );
+        iter = nullptr;
+    }
+}
+
+template<>
+void delete_item( git_odb* odb )
+{
+    if( odb != nullptr )
+    {
+        git_odb_free( odb );
+        odb = nullptr;
+    }
+}
+
+template<>
+void delete_item( git_odb_object* object )
+{
+    if( object != nullptr )
+    {
+        git_odb_object_free( object );
+        object = nullptr;
+    }
+}
+
+template<>
+void delete_item( git_tree* tree )
+{
+    if( tree != nullptr )
+    {
+        git_tree_free( tree );
+        tree = nullptr;
+    }
+}
+
+template<>
+void delete_item( git_diff* diff )
+{
+    if( diff != nullptr )
+    {
+        git_diff_free( diff );
+        diff = nullptr;
+    }
+}
+
+template<>
+void delete_item( git_diff_stats* stats )
+{
+    if( stats != nullptr )
+    {
+        git_diff_stats_free( stats );
+        stats = nullptr;
+    }
+}
+
 }//deleters
 
 }//git_handler
@@ -12,6 +12,30 @@ namespace deleters
 template< class TypeToDelete >
 void delete_item( TypeToDelete* );
 
+template<> void delete_item( git_repository* );
+template<> void delete_item( git_remote* );
+template<> void delete_item( git_commit* );
+template<> void delete_item( git_reference* );
+template<> void delete_item( git_strarray* );
+template<> void delete_item( git_revwalk* );
+template<> void delete_item( git_reference_iterator* );
+template<> void delete_item( git_odb* );
+template<> void delete_item( git_odb_object* );
+template<> void delete_item( git_tree* );
+template<> void delete_item( git_diff* );
+template<> void delete_item( git_diff_stats* );
+
+// Stateless deleter calling delete_item directly, so an owning pointer stays
+// the size of a raw one
+template< class TypeToDelete >
+struct item_deleter
+{
+    void operator()( TypeToDelete* item ) const noexcept
+    {
+        delete_item( item );
+    }
+};
+
 }//deleters
 
 }//git_handler
@@ -21,7 +45,7 @@ namespace details
 
 // helper alias to conveniently determine a deleter type
 template< class TypeToDelete >
-using type_deleter = void( * )( TypeToDelete* );
+using type_deleter = git_handler::deleters::item_deleter< TypeToDelete >;
 
 }
 
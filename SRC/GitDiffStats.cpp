@@ -0,0 +1,65 @@
+#include <mutex>
+
+#include "GitDiffStats.h"
+
+namespace git_handler
+{
+
+namespace base
+{
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////                DiffStats                //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+bool diff_stats_cache::find( const git_oid& id, diff_stats& stats ) const
+{
+    std::shared_lock< std::shared_timed_mutex > l{ m_mutex };
+
+    auto found = m_stats.find( id );
+    if( found == m_stats.end() )
+    {
+        return false;
+    }
+
+    stats = found->second;
+    return true;
+}
+
+void diff_stats_cache::insert( const git_oid& id, const diff_stats& stats )
+{
+    std::unique_lock< std::shared_timed_mutex > l{ m_mutex };
+    m_stats[ id ] = stats;
+}
+
+std::vector< git_oid > diff_stats_cache::missing( const std::vector< git_oid >& ids ) const
+{
+    std::vector< git_oid > result;
+    std::shared_lock< std::shared_timed_mutex > l{ m_mutex };
+
+    for( const auto& id : ids )
+    {
+        if( m_stats.find( id ) == m_stats.end() )
+        {
+            result.push_back( id );
+        }
+    }
+
+    return result;
+}
+
+size_t diff_stats_cache::size() const noexcept
+{
+    std::shared_lock< std::shared_timed_mutex > l{ m_mutex };
+    return m_stats.size();
+}
+
+void diff_stats_cache::clear()
+{
+    std::unique_lock< std::shared_timed_mutex > l{ m_mutex };
+    m_stats.clear();
+}
+
+}//base
+
+}//git_handler
@@ -0,0 +1,61 @@
+#ifndef GITDIFFSTATS_H
+#define GITDIFFSTATS_H
+
+#include <vector>
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include <git2.h>
+
+#include "details/OidHash.h"
+
+namespace git_handler
+{
+
+namespace base
+{
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////                DiffStats                //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+// What a commit changed against its first parent, or against the empty tree for a root commit
+struct diff_stats
+{
+    uint32_t files_changed{ 0 };
+    uint64_t insertions{ 0 };
+    uint64_t deletions{ 0 };
+};
+
+// Diff stats by commit id. Commits never change, so the entries are never invalidated
+// and the cache only grows. Safe to use from several threads
+class diff_stats_cache
+{
+public:
+    diff_stats_cache() = default;
+    diff_stats_cache( const diff_stats_cache& ) = delete;
+    diff_stats_cache& operator=( const diff_stats_cache& ) = delete;
+
+    // false if the commit isn't cached
+    bool find( const git_oid& id, diff_stats& stats ) const;
+    void insert( const git_oid& id, const diff_stats& stats );
+    // ids of the given ones that aren't cached, in their order
+    std::vector< git_oid > missing( const std::vector< git_oid >& ids ) const;
+
+    size_t size() const noexcept;
+    void clear();
+
+private:
+    using stats_map = std::unordered_map< git_oid, diff_stats, details::oid_hash, details::oid_equal >;
+
+private:
+    stats_map m_stats;
+    mutable std::shared_timed_mutex m_mutex;
+};
+
+}//base
+
+}//git_handler
+
+#endif // GITDIFFSTATS_H
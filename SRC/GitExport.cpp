@@ -0,0 +1,332 @@
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "GitExport.h"
+#include "details/TextFormat.h"
+
+namespace git_handler
+{
+
+namespace base
+{
+
+namespace
+{
+
+// room for every fixed size field of a record, the strings are appended on their own
+const size_t min_buffer_size{ 1024 };
+
+char* put_uint( uint64_t value, const size_t size, char* out ) noexcept
+{
+    for( size_t byte_num = 0; byte_num < size; ++byte_num )
+    {
+        *out++ = static_cast< char >( value & 0xff );
+        value >>= 8;
+    }
+
+    return out;
+}
+
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////                 Sinks                   //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+fd_sink::fd_sink( const int fd ) noexcept : m_fd( fd )
+{
+
+}
+
+void fd_sink::write( const char* data, size_t size )
+{
+    while( size )
+    {
+#ifdef _WIN32
+        const auto written = ::_write( m_fd, data, static_cast< unsigned int >( size ) );
+#else
+        const auto written = ::write( m_fd, data, size );
+#endif
+        if( written < 0 )
+        {
+            if( errno == EINTR )
+            {
+                continue;
+            }
+
+            throw std::runtime_error{ std::string{ "Could not write the export: " } + std::strerror( errno ) };
+        }
+
+        data += written;
+        size -= static_cast< size_t >( written );
+    }
+}
+
+buffer_sink::buffer_sink( std::string& buffer ) noexcept : m_buffer( buffer )
+{
+
+}
+
+void buffer_sink::write( const char* data, const size_t size )
+{
+    m_buffer.append( data, size );
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////                Exporter                 //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+const char commit_exporter::binary_magic[ 8 ]{ 'G', 'H', 'E', 'X', 'P', 'R', 'T', '1' };
+
+commit_exporter::commit_exporter( export_sink& sink, const export_format format, const size_t buffer_size ) :
+    m_sink( sink ),
+    m_format( format ),
+    m_buffer( std::max( buffer_size, min_buffer_size ) )
+{
+
+}
+
+commit_exporter::~commit_exporter()
+{
+    try
+    {
+        flush();
+    }
+    catch( ... )
+    {
+    }
+}
+
+void commit_exporter::write( const commit_wrapper& commit, const boost::string_view ref_name )
+{
+    if( !commit.isValid() )
+    {
+        throw std::logic_error{ "Commit is not valid" };
+    }
+
+    // the views are copied right away, exporting doesn't leave the commits pinned
+    const commit_wrapper::view_scope scope{ commit };
+
+    if( m_format == export_format::binary )
+    {
+        write_binary( commit, ref_name );
+    }
+    else
+    {
+        write_json( commit, ref_name );
+    }
+
+    ++m_commits_count;
+}
+
+void commit_exporter::write( const branch_wrapper& branch )
+{
+    const std::string ref_name{ branch.ref_name() };
+    const auto& commits = branch.commits();
+
+    // the storage is sorted oldest first
+    for( auto commit = commits.end(); commit != commits.begin(); )
+    {
+        --commit;
+        write( *commit->commit, ref_name );
+    }
+}
+
+void commit_exporter::write( const repo_wrapper::branches& branches )
+{
+    for( const auto& branch : branches )
+    {
+        write( *branch.second );
+    }
+}
+
+void commit_exporter::write( commit_walk& walk, const boost::string_view ref_name )
+{
+    for( const auto& commit : walk )
+    {
+        write( *commit, ref_name );
+    }
+}
+
+void commit_exporter::flush()
+{
+    if( m_used )
+    {
+        // the buffer is emptied first, so that a failing sink doesn't get the same bytes twice
+        const size_t used{ m_used };
+        m_used = 0;
+        m_sink.write( m_buffer.data(), used );
+    }
+}
+
+size_t commit_exporter::commits_count() const noexcept
+{
+    return m_commits_count;
+}
+
+void commit_exporter::write_json( const commit_wrapper& commit, const boost::string_view ref_name )
+{
+    const git_oid id{ commit.id() };
+    const git_time time{ commit.time() };
+
+    if( !ref_name.empty() )
+    {
+        append( "{\"ref\":\"" );
+        append_json_string( ref_name );
+        append( "\",\"id\":\"" );
+    }
+    else
+    {
+        append( "{\"id\":\"" );
+    }
+
+    char* out{ reserve( details::oid_hex_length + 2 * details::max_int_length + details::iso_time_length + 32 ) };
+    out = details::format_oid( id, out );
+    std::memcpy( out, "\",\"time\":", 9 );
+    out = details::format_int( time.time, out + 9 );
+    std::memcpy( out, ",\"offset\":", 10 );
+    out = details::format_int( time.offset, out + 10 );
+    std::memcpy( out, ",\"date\":\"", 9 );
+    out = details::format_iso_time( time.time, time.offset, out + 9 );
+    commit_reserved( out );
+
+    append( "\",\"author\":\"" );
+    append_json_string( commit.author_view() );
+    append( "\",\"email\":\"" );
+    append_json_string( commit.author_email_view() );
+    append( "\",\"parents\":[" );
+
+    const auto parents = commit.parents();
+    for( size_t parent_num = 0; parent_num < parents.size(); ++parent_num )
+    {
+        out = reserve( details::oid_hex_length + 3 );
+        if( parent_num )
+        {
+            *out++ = ',';
+        }
+
+        *out++ = '"';
+        out = details::format_oid( parents[ parent_num ], out );
+        *out++ = '"';
+        commit_reserved( out );
+    }
+
+    append( "],\"message\":\"" );
+    append_json_string( commit.message_view() );
+    append( "\"}\n" );
+}
+
+void commit_exporter::write_binary( const commit_wrapper& commit, const boost::string_view ref_name )
+{
+    if( !m_started )
+    {
+        append( binary_magic, sizeof( binary_magic ) );
+        m_started = true;
+    }
+
+    const git_oid id{ commit.id() };
+    const git_time time{ commit.time() };
+    const auto parents = commit.parents();
+
+    const auto author = commit.author_view();
+    const auto email = commit.author_email_view();
+    const auto message = commit.message_view();
+
+    const size_t fixed_size{ GIT_OID_RAWSZ + 8 + 2 + 2 };
+    const uint64_t record_size{ fixed_size + parents.size() * GIT_OID_RAWSZ +
+                                4 * 4 + ref_name.size() + author.size() + email.size() + message.size() };
+
+    if( record_size > UINT32_MAX || parents.size() > UINT16_MAX )
+    {
+        throw std::runtime_error{ "Commit is too large for the binary export" };
+    }
+
+    char* out{ reserve( 4 + fixed_size ) };
+    out = put_uint( record_size, 4, out );
+    std::memcpy( out, id.id, GIT_OID_RAWSZ );
+    out = put_uint( static_cast< uint64_t >( time.time ), 8, out + GIT_OID_RAWSZ );
+    out = put_uint( static_cast< uint16_t >( time.offset ), 2, out );
+    out = put_uint( parents.size(), 2, out );
+    commit_reserved( out );
+
+    for( const auto& parent : parents )
+    {
+        append( reinterpret_cast< const char* >( parent.id ), GIT_OID_RAWSZ );
+    }
+
+    append_sized( ref_name );
+    append_sized( author );
+    append_sized( email );
+    append_sized( message );
+}
+
+char* commit_exporter::reserve( const size_t size )
+{
+    if( m_buffer.size() - m_used < size )
+    {
+        flush();
+    }
+
+    return m_buffer.data() + m_used;
+}
+
+void commit_exporter::commit_reserved( char* end ) noexcept
+{
+    m_used = static_cast< size_t >( end - m_buffer.data() );
+}
+
+void commit_exporter::append( const char* data, const size_t size )
+{
+    if( m_buffer.size() - m_used < size )
+    {
+        flush();
+
+        // whatever doesn't fit in the whole buffer goes straight to the sink
+        if( size >= m_buffer.size() )
+        {
+            m_sink.write( data, size );
+            return;
+        }
+    }
+
+    std::memcpy( m_buffer.data() + m_used, data, size );
+    m_used += size;
+}
+
+void commit_exporter::append( const boost::string_view str )
+{
+    append( str.data(), str.size() );
+}
+
+void commit_exporter::append_json_string( const boost::string_view str )
+{
+    const char* in{ str.data() };
+    const char* in_end{ str.data() + str.size() };
+
+    // the text is escaped straight into the buffer, which is flushed whenever it fills up
+    while( in != in_end )
+    {
+        char* out{ reserve( 4 * details::max_json_escape_length ) };
+        const char* out_end{ m_buffer.data() + m_buffer.size() - details::max_json_escape_length };
+
+        commit_reserved( details::escape_json( in, in_end, out, out_end ) );
+    }
+}
+
+void commit_exporter::append_sized( const boost::string_view str )
+{
+    commit_reserved( put_uint( str.size(), 4, reserve( 4 ) ) );
+    append( str.data(), str.size() );
+}
+
+}//base
+
+}//git_handler
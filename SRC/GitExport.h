@@ -0,0 +1,115 @@
+#ifndef GITEXPORT_H
+#define GITEXPORT_H
+
+#include <string>
+#include <vector>
+
+#include <boost/utility/string_view.hpp>
+
+#include "GitBaseClasses.h"
+
+namespace git_handler
+{
+
+namespace base
+{
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////                 Sinks                   //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+// Destination of the exported bytes, errors are reported with exceptions
+class export_sink
+{
+public:
+    virtual ~export_sink() = default;
+    virtual void write( const char* data, const size_t size ) = 0;
+};
+
+// writes to a file descriptor owned by the caller, throws std::runtime_error if a write fails
+class fd_sink : public export_sink
+{
+public:
+    explicit fd_sink( const int fd ) noexcept;
+    void write( const char* data, const size_t size ) override;
+
+private:
+    int m_fd;
+};
+
+// appends to a buffer owned by the caller
+class buffer_sink : public export_sink
+{
+public:
+    explicit buffer_sink( std::string& buffer ) noexcept;
+    void write( const char* data, const size_t size ) override;
+
+private:
+    std::string& m_buffer;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////                Exporter                 //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+enum class export_format
+{
+    // one JSON object per commit and line:
+    // {"ref":...,"id":...,"time":...,"offset":...,"date":...,"author":...,"email":...,"parents":[...],"message":...}
+    // "ref" is only written for commits exported with a ref name, "offset" is in minutes
+    json_lines,
+    // the magic "GHEXPRT1", then one record per commit, integers are little endian:
+    // u32 size of the rest of the record, id[20], i64 time, i16 offset in minutes, u16 parents count,
+    // parent ids[20], then ref, author, email and message, each as u32 size followed by the bytes
+    binary
+};
+
+// Streams commits to a sink through a buffer of the given size. Fields are read through the
+// commit views and formatted straight into the buffer, without any temporary strings
+class commit_exporter
+{
+public:
+    static const char binary_magic[ 8 ];
+
+public:
+    commit_exporter( export_sink& sink, const export_format format, const size_t buffer_size = 1 << 16 );
+    commit_exporter( const commit_exporter& ) = delete;
+    commit_exporter& operator=( const commit_exporter& ) = delete;
+    // flushes what is left, call flush() to see the errors
+    ~commit_exporter();
+
+    void write( const commit_wrapper& commit, const boost::string_view ref_name = {} );
+    // the branch's commits, newest first
+    void write( const branch_wrapper& branch );
+    void write( const repo_wrapper::branches& branches );
+    void write( commit_walk& walk, const boost::string_view ref_name = {} );
+    void flush();
+
+    size_t commits_count() const noexcept;
+
+private:
+    void write_json( const commit_wrapper& commit, const boost::string_view ref_name );
+    void write_binary( const commit_wrapper& commit, const boost::string_view ref_name );
+
+    // room for size more bytes in the buffer, size must not exceed the buffer size
+    char* reserve( const size_t size );
+    void commit_reserved( char* end ) noexcept;
+    void append( const char* data, const size_t size );
+    void append( const boost::string_view str );
+    void append_json_string( const boost::string_view str );
+    void append_sized( const boost::string_view str );
+
+private:
+    export_sink& m_sink;
+    export_format m_format;
+    std::vector< char > m_buffer;
+    size_t m_used{ 0 };
+    size_t m_commits_count{ 0 };
+    bool m_started{ false };
+};
+
+}//base
+
+}//git_handler
+
+#endif // GITEXPORT_H
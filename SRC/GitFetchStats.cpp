@@ -0,0 +1,59 @@
+#include "GitFetchStats.h"
+
+namespace git_handler
+{
+
+namespace base
+{
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////               FetchStats                //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+size_t fetch_stats::received_objects() const noexcept
+{
+    size_t count{ 0 };
+    for( const auto& remote : remotes )
+    {
+        count += remote.received_objects;
+    }
+
+    return count;
+}
+
+size_t fetch_stats::received_bytes() const noexcept
+{
+    size_t count{ 0 };
+    for( const auto& remote : remotes )
+    {
+        count += remote.received_bytes;
+    }
+
+    return count;
+}
+
+size_t fetch_stats::updated_refs() const noexcept
+{
+    size_t count{ 0 };
+    for( const auto& remote : remotes )
+    {
+        count += remote.updated_refs;
+    }
+
+    return count;
+}
+
+size_t fetch_stats::skipped_remotes() const noexcept
+{
+    size_t count{ 0 };
+    for( const auto& remote : remotes )
+    {
+        count += remote.skipped ? 1 : 0;
+    }
+
+    return count;
+}
+
+}//base
+
+}//git_handler
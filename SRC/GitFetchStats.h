@@ -0,0 +1,66 @@
+#ifndef GITFETCHSTATS_H
+#define GITFETCHSTATS_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace git_handler
+{
+
+namespace base
+{
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////               FetchStats                //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+// Fetch of a single remote. The transfer progress callbacks split the download into phases:
+// negotiation lasts until the first pack data arrives, transfer until every object is received
+// and indexing until the last delta is resolved. The phases add up to the duration
+struct remote_fetch_stats
+{
+    std::string remote;
+
+    std::chrono::nanoseconds duration{ 0 };
+    std::chrono::nanoseconds negotiation{ 0 };
+    std::chrono::nanoseconds transfer{ 0 };
+    std::chrono::nanoseconds indexing{ 0 };
+    // whatever follows the download: ref updates for fetches, ref updates and checkout for clones
+    std::chrono::nanoseconds update{ 0 };
+
+    size_t total_objects{ 0 };
+    size_t received_objects{ 0 };
+    size_t local_objects{ 0 };
+    size_t total_deltas{ 0 };
+    size_t received_bytes{ 0 };
+    size_t updated_refs{ 0 };
+
+    // the remote advertised the refs the repo already had, so nothing was fetched
+    // and the whole duration is negotiation
+    bool skipped{ false };
+};
+
+// A whole fetch() or clone() of a repo
+struct fetch_stats
+{
+    std::chrono::system_clock::time_point started;
+
+    std::chrono::nanoseconds duration{ 0 };
+    std::chrono::nanoseconds update_remotes{ 0 };
+    // reading the histories changed by the fetch, filled in by whoever reads them
+    std::chrono::nanoseconds reload{ 0 };
+
+    std::vector< remote_fetch_stats > remotes;
+
+    size_t received_objects() const noexcept;
+    size_t received_bytes() const noexcept;
+    size_t updated_refs() const noexcept;
+    size_t skipped_remotes() const noexcept;
+};
+
+}//base
+
+}//git_handler
+
+#endif // GITFETCHSTATS_H
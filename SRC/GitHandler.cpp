@@ -1,5 +1,8 @@
+#include <iterator>
+#include <algorithm>
+
 #include "GitHandler.h"
-#include "GitItem.cpp"
+#include "details/WorkerPool.h"
 
 namespace git_handler
 {
@@ -8,47 +11,327 @@ namespace git_handler
 /////////////////                GitHandler               //////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 
-base::repo_wrapper* git_handler::mCurrentRepo;
-git_handler::new_braches git_handler::m_new_branches;
-git_handler::new_commits git_handler::m_new_commits;
-git_handler::credentials git_handler::mCredentials;
-
 git_handler::git_handler()
 {
     git_libgit2_init();
-    register_git_items();
 }
 
 bool git_handler::add_repo( std::unique_ptr< base::repo_wrapper >&& repo, const std::string& username, const std::string& pass)
 {
     if ( repo->is_valid() )
     {
-        m_repos.emplace( repo->path(), std::move( repo )  );
-        mCredentials.emplace( repo->path(), std::make_pair( username, pass ) );
+        std::string path{ repo->path() };
+        m_repos.emplace( path, std::move( repo )  );
+        m_credentials.emplace( path, std::make_pair( username, pass ) );
+
+        // local remotes don't count against any host cap
+        std::vector< std::string > hosts;
+        for( const auto& url : m_repos.at( path )->remote_urls() )
+        {
+            auto host = base::fetch_scheduler::remote_host( url.second );
+            if( !host.empty() && std::find( hosts.begin(), hosts.end(), host ) == hosts.end() )
+            {
+                hosts.push_back( std::move( host ) );
+            }
+        }
+
+        m_scheduler.add( path, hosts );
+
+        // authors are the same people across the repos of a handler
+        m_repos.at( path )->set_identities( m_identities );
         return true;
     }
 
     return false;
 }
 
-void git_handler::update() noexcept
+auto git_handler::update( const size_t workers_count ) -> update_results
 {   
+    const git_fetch_options fetch_opts = make_fetch_options();
+
+    std::vector< base::repo_wrapper* > repos_list;
+    repos_list.reserve( m_repos.size() );
+
+    for ( auto& repo : m_repos )
+    {
+        repos_list.push_back( repo.second.get() );
+    }
+
+    // every repo is fetched on its own worker, results are collected per repo
+    std::vector< update_result > results_list( repos_list.size() );
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    details::parallel_for( repos_list.size(), workers_count,
+                           [ & ]( const size_t repo_num, const size_t )
+                           {
+                               try
+                               {
+                                   results_list[ repo_num ] = fetch_repo( repos_list[ repo_num ], fetch_opts );
+                               }
+                               catch( ... )
+                               {
+                                   std::lock_guard< std::mutex > l{ error_mutex };
+                                   if( !error )
+                                   {
+                                       error = std::current_exception();
+                                   }
+                               }
+                           } );
+
+    if( error )
+    {
+        std::rethrow_exception( error );
+    }
+
+    update_results results;
+    for( size_t repo_num = 0; repo_num < repos_list.size(); ++repo_num )
+    {
+        results.emplace( repos_list[ repo_num ]->path(), std::move( results_list[ repo_num ] ) );
+    }
+
+    dump_stats();
+
+    return results;
+}
+
+auto git_handler::update_scheduled( const size_t workers_count ) -> update_results
+{
+    using clock = base::fetch_scheduler::clock;
+
+    const git_fetch_options fetch_opts = make_fetch_options();
+
+    update_results results;
+    std::mutex results_mutex;
+    std::exception_ptr error;
+
+    m_scheduler.start_round( clock::now() );
+
+    // every worker keeps taking the repos the scheduler lets run until the round is over,
+    // no workers means a single one like in update()
+    const size_t workers{ std::max< size_t >( 1, workers_count ) };
+    details::parallel_for( workers, workers,
+                           [ & ]( const size_t, const size_t )
+                           {
+                               std::string path;
+                               while( m_scheduler.acquire( path ) )
+                               {
+                                   auto outcome = base::fetch_outcome::failed;
+
+                                   try
+                                   {
+                                       auto result = fetch_repo( m_repos.at( path ).get(), fetch_opts );
+
+                                       outcome = !result.ok ? base::fetch_outcome::failed :
+                                                 result.changed ? base::fetch_outcome::changed :
+                                                                  base::fetch_outcome::unchanged;
+
+                                       std::lock_guard< std::mutex > l{ results_mutex };
+                                       results.emplace( path, std::move( result ) );
+                                   }
+                                   catch( ... )
+                                   {
+                                       std::lock_guard< std::mutex > l{ results_mutex };
+                                       if( !error )
+                                       {
+                                           error = std::current_exception();
+                                       }
+                                   }
+
+                                   // the repo's slot is released whatever happened
+                                   m_scheduler.complete( path, outcome, clock::now() );
+                               }
+                           } );
+
+    if( error )
+    {
+        std::rethrow_exception( error );
+    }
+
+    dump_stats();
+
+    return results;
+}
+
+git_fetch_options git_handler::make_fetch_options() noexcept
+{
     git_fetch_options fetch_opts = GIT_FETCH_OPTIONS_INIT;
     fetch_opts.callbacks.update_tips = &update_cb;
     fetch_opts.callbacks.sideband_progress = &progress_cb;
     fetch_opts.callbacks.credentials = &cred_acquire_cb;
 
-    for ( auto& repo : m_repos )
+    return fetch_opts;
+}
+
+auto git_handler::fetch_repo( base::repo_wrapper* repo, git_fetch_options fetch_opts ) -> update_result
+{
+    update_result result;
+
+    fetch_payload payload;
+    payload.repo = repo;
+
+    auto credentials = m_credentials.find( repo->path() );
+    if( credentials != m_credentials.end() )
+    {
+        payload.credentials = &credentials->second;
+    }
+
+    fetch_opts.callbacks.payload = &payload;
+
+    std::chrono::nanoseconds reload{ 0 };
+
+    try
+    {
+        repo->fetch( fetch_opts );
+
+        result.ok = true;
+        result.changed = !payload.tip_updates.empty();
+    }
+    catch( const std::exception& e )
+    {
+        result.error = e.what();
+    }
+
+    // the tips a fetch has moved stay moved even if it fails later, so their changes are collected
+    // in any case. If that fails they are kept and collected along with the next update
+    const auto tip_updates = add_pending_updates( repo->path(), payload.tip_updates );
+
+    try
+    {
+        const auto reload_start = std::chrono::steady_clock::now();
+        collect_changes( repo, tip_updates );
+        reload = std::chrono::steady_clock::now() - reload_start;
+
+        std::lock_guard< std::mutex > l{ m_changes_mutex };
+        m_pending_updates.erase( repo->path() );
+        result.collected = true;
+    }
+    catch( const std::exception& e )
+    {
+        if( result.ok )
+        {
+            result.error = std::string{ "Collecting the changes failed: " } + e.what();
+        }
+    }
+
+    auto stats = repo->last_fetch_stats();
+    stats.reload = reload;
+    record_stats( repo->path(), std::move( stats ), result.ok );
+
+    return result;
+}
+
+auto git_handler::add_pending_updates( const std::string& path, const std::vector< tip_update >& tip_updates ) -> std::vector< tip_update >
+{
+    std::lock_guard< std::mutex > l{ m_changes_mutex };
+
+    auto& pending = m_pending_updates[ path ];
+    for( const auto& update : tip_updates )
     {
-       repo.second->fetch( fetch_opts );
+        auto stored = std::find_if( pending.begin(), pending.end(),
+                                    [ & ]( const tip_update& pending_update ){ return pending_update.ref_name == update.ref_name; } );
+
+        // a ref moved again keeps the head it had before the first uncollected update
+        if( stored != pending.end() )
+        {
+            stored->head = update.head;
+        }
+        else
+        {
+            pending.push_back( update );
+        }
+    }
+
+    return pending;
+}
+
+void git_handler::collect_changes( base::repo_wrapper* repo, const std::vector< tip_update >& tip_updates )
+{
+    new_branches_storage::mapped_type branches;
+    new_commits_storage commits;
+
+    for( const auto& update : tip_updates )
+    {
+        // tags and other refs move too, only branches are tracked, deleted ones are just dropped
+        if( ( update.ref_name.compare( 0, 11, "refs/heads/" ) != 0 &&
+              update.ref_name.compare( 0, 13, "refs/remotes/" ) != 0 ) ||
+            git_oid_iszero( &update.head ) )
+        {
+            continue;
+        }
+
+        // new branches are reported without their commits, refresh_branch() reads them if needed
+        if( git_oid_iszero( &update.old_head ) )
+        {
+            auto branch = repo->get_branch( update.ref_name, false );
+            if( branch )
+            {
+                branches.push_back( std::move( branch ) );
+            }
+
+            continue;
+        }
+
+        // the walk stops where the old head's history starts, so the cost only depends on the delta
+        base::walk_options options;
+        options.hide.push_back( update.old_head );
+
+        auto& new_commits = commits[ std::make_pair( repo->path(), update.ref_name ) ];
+        for( auto& commit : repo->walk( update.head, options ) )
+        {
+            new_commits.push_back( commit );
+        }
+    }
+
+    std::lock_guard< std::mutex > l{ m_changes_mutex };
+
+    if( !branches.empty() )
+    {
+        auto& repo_branches = m_new_branches[ repo->path() ];
+        std::move( branches.begin(), branches.end(), std::back_inserter( repo_branches ) );
+    }
+
+    for( auto& ref_commits : commits )
+    {
+        auto& stored_commits = m_new_commits[ ref_commits.first ];
+
+        // the newest commits come first, even across several updates
+        stored_commits.insert( stored_commits.begin(),
+                               std::make_move_iterator( ref_commits.second.begin() ),
+                               std::make_move_iterator( ref_commits.second.end() ) );
     }
 }
 
 void git_handler::clear() noexcept
 {
-    m_repos.clear();
+    std::lock_guard< std::mutex > l{ m_changes_mutex };
+
     m_new_branches.clear();
     m_new_commits.clear();
+    m_pending_updates.clear();
+    m_repos.clear();
+    m_credentials.clear();
+    m_scheduler.clear();
+}
+
+void git_handler::set_schedule_options( const base::schedule_options& options )
+{
+    m_scheduler.set_options( options );
+}
+
+void git_handler::set_priority( const std::string& path, const int priority )
+{
+    m_scheduler.set_priority( path, priority );
+}
+
+auto git_handler::get_scheduler() const noexcept -> const base::fetch_scheduler&
+{
+    return m_scheduler;
+}
+
+auto git_handler::get_identities() const noexcept -> const std::shared_ptr< base::identity_table >&
+{
+    return m_identities;
 }
 
 base::repo_wrapper* git_handler::getRepo( const std::string& path ) const noexcept
@@ -67,15 +350,92 @@ auto git_handler::get_repos() const noexcept -> const repos&
     return m_repos;
 }
 
-//auto GitHandler::newBranches() -> NewBranchStorage
-//{
-//    return NewBranchStorage( std::move(mNewBranches) );
-//}
+auto git_handler::take_new_branches() -> new_branches_storage
+{
+    new_branches_storage branches;
+
+    std::lock_guard< std::mutex > l{ m_changes_mutex };
+    branches.swap( m_new_branches );
+
+    return branches;
+}
+
+auto git_handler::take_new_commits() -> new_commits_storage
+{
+    new_commits_storage commits;
 
-//auto GitHandler::newCommits() -> NewCommitStorage
-//{
-//    return NewCommitStorage( std::move( mNewCommits ) );
-//}
+    std::lock_guard< std::mutex > l{ m_changes_mutex };
+    commits.swap( m_new_commits );
+
+    return commits;
+}
+
+auto git_handler::get_stats() const -> stats_storage
+{
+    std::lock_guard< std::mutex > l{ m_stats_mutex };
+    return m_stats;
+}
+
+void git_handler::reset_stats() noexcept
+{
+    std::lock_guard< std::mutex > l{ m_stats_mutex };
+    m_stats.clear();
+}
+
+void git_handler::set_stats_dump( const std::chrono::seconds interval, stats_sink sink )
+{
+    std::lock_guard< std::mutex > l{ m_stats_mutex };
+
+    m_dump_interval = interval;
+    m_dump_sink = std::move( sink );
+    m_last_dump = std::chrono::steady_clock::now();
+}
+
+void git_handler::record_stats( const std::string& path, base::fetch_stats stats, const bool ok )
+{
+    std::lock_guard< std::mutex > l{ m_stats_mutex };
+
+    auto& repo_stats = m_stats[ path ];
+    ++repo_stats.updates;
+    repo_stats.failures += ok ? 0 : 1;
+    repo_stats.total_duration += stats.duration + stats.reload;
+    repo_stats.total_reload += stats.reload;
+    repo_stats.received_objects += stats.received_objects();
+    repo_stats.received_bytes += stats.received_bytes();
+    repo_stats.updated_refs += stats.updated_refs();
+    repo_stats.skipped_remotes += stats.skipped_remotes();
+    repo_stats.last = std::move( stats );
+}
+
+void git_handler::dump_stats()
+{
+    stats_storage stats;
+    stats_sink sink;
+
+    {
+        std::lock_guard< std::mutex > l{ m_stats_mutex };
+
+        const auto now = std::chrono::steady_clock::now();
+        if( m_dump_interval.count() == 0 || now - m_last_dump < m_dump_interval )
+        {
+            return;
+        }
+
+        m_last_dump = now;
+        stats = m_stats;
+        sink = m_dump_sink;
+    }
+
+    // the sink is called without the lock, so it may query the handler
+    if( sink )
+    {
+        sink( stats );
+    }
+    else
+    {
+        aux::print_stats( stats );
+    }
+}
 
 int git_handler::progress_cb( const char *str, int len, void *data )
 {
@@ -86,61 +446,14 @@ int git_handler::progress_cb( const char *str, int len, void *data )
 
 int git_handler::update_cb(const char *refname, const git_oid *oldHead, const git_oid *head, void *data)
 {
-//    if ( !mCurrentRepo )
-//    {
-//        return 1;
-//    }
-
-//    if ( git_oid_iszero( oldHead ) ) // new branch
-//    {
-//        auto ref = base::Aux::getReference( refname, currRepo->get() );
-//        if ( !ref )
-//        {
-//            return 1;
-//        }
-
-//        auto branchPtr = std::make_unique< Branch >( ref, true );
-
-//        auto branchStor = mNewBranches.find( currRepo->path() );
-//        if ( branchStor == mNewBranches.end() )
-//        {
-//            mNewBranches.emplace( currRepo->path(), std::vector< base::Branch* >() );
-//            branchStor = mNewBranches.find( currRepo->path() );
-//        }
-
-//        branchStor->second.push_back( branchPtr );
-//    }
-//    else //new commit
-//    {
-//        auto key = std::make_pair(currRepo->path(), refname);
-//        auto storage = mNewCommits.find(key);
-//        if (storage == mNewCommits.end())
-//        {
-//            mNewCommits.insert(std::make_pair(key, vector<CommitPtr>()));
-//            storage = mNewCommits.find(key);
-//        }
-
-//        auto branch = currRepo->getBranch(refname);
-//        if (branch == nullptr){
-//            return 1;
-//        }
-
-//        const CommitStorage& commits = branch->commits();
-//        auto oldHeadCommit = std::find_if(commits.begin(), commits.end(),
-//                                          [oldHead](CommitStorage::value_type commit)->bool
-//                                          {
-//                                            const auto& id = commit.second->id();
-//                                            return git_oid_equal(oldHead, &id);
-//                                          });
-
-//        if (oldHeadCommit != commits.end()){
-//            oldHeadCommit++;
-//        }
-			
-//        for (auto commitIt = oldHeadCommit; commitIt != commits.end(); ++commitIt){
-//            storage->second.push_back(commitIt->second);
-//        }
-//    }
+    auto payload = static_cast< fetch_payload* >( data );
+    if ( !payload || !refname || !oldHead || !head )
+    {
+        return 1;
+    }
+
+    // the changes are only collected once the fetch is over, the repo can't be walked in the middle of it
+    payload->tip_updates.push_back( { refname, *oldHead, *head } );
 	
     return 0;
 }
@@ -149,49 +462,79 @@ int git_handler::cred_acquire_cb( git_cred **out, const char* url, const char* u
 {
     int res = 1;
 
-    if ( !mCurrentRepo )
+    auto payload = static_cast< fetch_payload* >( data );
+    if ( !payload || !payload->repo )
     {
         return res;
     }
 
-    const auto& credentials = mCredentials.find( mCurrentRepo->path() );
-    if (credentials != mCredentials.end())
+    const auto credentials = payload->credentials;
+    if ( credentials )
     {
-        res = git_cred_userpass_plaintext_new( out, credentials->second.first.c_str(), credentials->second.second.c_str() );
+        res = git_cred_userpass_plaintext_new( out, credentials->first.c_str(), credentials->second.c_str() );
         //int res = git_cred_ssh_key_new(out, "git", "C:\\Users\\Sergey\\\.ssh\\id_rsa.pub", "C:\\Users\\Sergey\\\.ssh\\id_rsa", "221289");
     }
 
-    printf("checking key: %d\n", res);
     return res;
 }
 
-template< class GitItemType >
-std::unique_ptr< factory::igit_item_factory > create_factory()
+git_handler::~git_handler()
 {
-    return std::make_unique< factory::git_item_factory< GitItemType > >();
+    clear();
+    git_libgit2_shutdown();
 }
 
-bool git_handler::register_git_items()
+////////////////////////////////////////////////////////////////////////////////
+/////////////////                   Aux                   //////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+void aux::print_stats( const git_handler::stats_storage& stats )
 {
-    bool ok = true;
-	
-    auto& c = factory::git_item_creator::get();
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
 
-    ok &= c.register_item_type < git_repository > ( item::type::GIT_REPO,     std::move( create_factory< git_repository >() ) );
-    ok &= c.register_item_type < git_repository > ( item::type::GIT_REMOTE,   std::move( create_factory< git_remote >() ) );
-    ok &= c.register_item_type < git_repository > ( item::type::GIT_COMMIT,   std::move( create_factory< git_commit >() ) );
-    ok &= c.register_item_type < git_repository > ( item::type::GIT_REF,      std::move( create_factory< git_reference >() ) );
-    ok &= c.register_item_type < git_repository > ( item::type::GIT_STR_ARR,  std::move( create_factory< git_strarray >() ) );
-    ok &= c.register_item_type < git_repository > ( item::type::GIT_REV_WALK, std::move( create_factory< git_repository >() ) );
-    ok &= c.register_item_type < git_repository > ( item::type::GIT_REPO,     std::move( create_factory< git_revwalk >() ) );
+    printf( "\n-------------------\n" );
+    printf( "%s\n", "FETCH STATS" );
+    printf( "-------------------\n\n" );
 
-    return ok;
-}
+    for( const auto& repo : stats )
+    {
+        const auto& repo_stats = repo.second;
+        const auto& last = repo_stats.last;
+
+        printf( "%s: %zu updates, %zu failed, %lld ms total, %lld ms reloading, %zu objects, %zu bytes, %zu refs, %zu remotes skipped\n",
+                repo.first.c_str(),
+                repo_stats.updates,
+                repo_stats.failures,
+                static_cast< long long >( duration_cast< milliseconds >( repo_stats.total_duration ).count() ),
+                static_cast< long long >( duration_cast< milliseconds >( repo_stats.total_reload ).count() ),
+                repo_stats.received_objects,
+                repo_stats.received_bytes,
+                repo_stats.updated_refs,
+                repo_stats.skipped_remotes );
+
+        printf( "  last: %lld ms, update_remotes %lld ms, reload %lld ms\n",
+                static_cast< long long >( duration_cast< milliseconds >( last.duration ).count() ),
+                static_cast< long long >( duration_cast< milliseconds >( last.update_remotes ).count() ),
+                static_cast< long long >( duration_cast< milliseconds >( last.reload ).count() ) );
+
+        for( const auto& remote : last.remotes )
+        {
+            printf( "  %s%s: negotiation %lld ms, transfer %lld ms, indexing %lld ms, update %lld ms, %zu/%zu objects, %zu bytes, %zu refs\n",
+                    remote.remote.c_str(),
+                    remote.skipped ? " ( skipped )" : "",
+                    static_cast< long long >( duration_cast< milliseconds >( remote.negotiation ).count() ),
+                    static_cast< long long >( duration_cast< milliseconds >( remote.transfer ).count() ),
+                    static_cast< long long >( duration_cast< milliseconds >( remote.indexing ).count() ),
+                    static_cast< long long >( duration_cast< milliseconds >( remote.update ).count() ),
+                    remote.received_objects,
+                    remote.total_objects,
+                    remote.received_bytes,
+                    remote.updated_refs );
+        }
+    }
 
-git_handler::~git_handler()
-{
-    clear();
-    git_libgit2_shutdown();
+    fflush( stdout );
 }
 
 } //git_handler
@@ -1,9 +1,13 @@
 #ifndef GITHANDLER_H
 #define GITHANDLER_H
 
+#include<mutex>
+#include<chrono>
 #include<vector>
+#include<functional>
 
 #include "GitBaseClasses.h"
+#include "GitScheduler.h"
 
 namespace git_handler
 {
@@ -15,10 +19,43 @@ namespace git_handler
 class git_handler
 {
 public:
-    using new_braches = std::map< std::string, std::vector< base::branch_wrapper* > >;
-    using new_commits = std::map< std::pair< std::string, std::string >, std::vector< base::commit_wrapper* > > ;
+    // Outcome of fetching a single repo
+    struct update_result
+    {
+        // whether the fetch itself succeeded
+        bool ok{ false };
+        // whether the fetch moved any ref
+        bool changed{ false };
+        // whether the new branches and commits were collected, the ones that weren't are
+        // collected again by the next update of the repo
+        bool collected{ false };
+        std::string error;
+    };
+
+    // new branches per repo path and new commits per ( repo path, ref name ), newest commits first
+    using new_branches_storage = std::map< std::string, std::vector< std::unique_ptr< base::branch_wrapper > > >;
+    using new_commits_storage = std::map< std::pair< std::string, std::string >, std::vector< std::shared_ptr< base::commit_wrapper > > > ;
     using credentials = std::map< std::string, std::pair< std::string, std::string > >;
     using repos = std::map< std::string, std::unique_ptr< base::repo_wrapper > >;
+    using update_results = std::map< std::string, update_result >;
+
+    // Fetch statistics of a repo accumulated over the updates
+    struct repo_stats
+    {
+        size_t updates{ 0 };
+        size_t failures{ 0 };
+        std::chrono::nanoseconds total_duration{ 0 };
+        std::chrono::nanoseconds total_reload{ 0 };
+        size_t received_objects{ 0 };
+        size_t received_bytes{ 0 };
+        size_t updated_refs{ 0 };
+        // remotes whose fetch was skipped as they had nothing new
+        size_t skipped_remotes{ 0 };
+        base::fetch_stats last;
+    };
+
+    using stats_storage = std::map< std::string, repo_stats >;
+    using stats_sink = std::function< void( const stats_storage& ) >;
 
 public:
     git_handler();
@@ -29,17 +66,60 @@ public:
     ~git_handler();
 
     bool add_repo( std::unique_ptr< base::repo_wrapper >&& repo, const std::string& username, const std::string& pass );
-    void update() noexcept;
+    // Fetches every repo, regardless of its schedule. Failed fetches are reported in the results,
+    // only running out of memory or a throwing stats sink makes the update itself throw
+    update_results update( const size_t workers_count = 1 );
+    // Fetches only the repos due according to the scheduler, highest priority first, keeping
+    // within its concurrency caps. Meant to be called periodically, repos failing or bringing
+    // nothing new are fetched less and less often while busy ones are fetched more often.
+    // Throws like update()
+    update_results update_scheduled( const size_t workers_count = 1 );
     void clear() noexcept;
+
+    void set_schedule_options( const base::schedule_options& options );
+    void set_priority( const std::string& path, const int priority );
+    const base::fetch_scheduler& get_scheduler() const noexcept;
+    // identities shared by all the added repos
+    const std::shared_ptr< base::identity_table >& get_identities() const noexcept;
 		
     base::repo_wrapper* getRepo(const std::string& path) const noexcept;
     const repos& get_repos() const noexcept;
 
-//    NewBranchStorage newBranches();
-//    NewCommitStorage newCommits();
+    // move out the changes collected by the updates since the previous call
+    new_branches_storage take_new_branches();
+    new_commits_storage take_new_commits();
+
+    stats_storage get_stats() const;
+    void reset_stats() noexcept;
+    // update() hands the stats to the sink once the interval has passed since the previous dump,
+    // without a sink they are printed. A zero interval turns the dump off
+    void set_stats_dump( const std::chrono::seconds interval, stats_sink sink = nullptr );
 
 private:
-    bool register_git_items();
+    // Per-fetch state handed to the callbacks, so concurrent fetches don't share anything
+    struct tip_update
+    {
+        std::string ref_name;
+        git_oid old_head;
+        git_oid head;
+    };
+
+    struct fetch_payload
+    {
+        base::repo_wrapper* repo{ nullptr };
+        const std::pair< std::string, std::string >* credentials{ nullptr };
+        std::vector< tip_update > tip_updates;
+    };
+
+private:
+    static git_fetch_options make_fetch_options() noexcept;
+    // failed fetches are reported in the result, only recording the stats may throw
+    update_result fetch_repo( base::repo_wrapper* repo, git_fetch_options fetch_opts );
+    void collect_changes( base::repo_wrapper* repo, const std::vector< tip_update >& tip_updates );
+    // adds the updates to the pending ones of the repo, returns all of them
+    std::vector< tip_update > add_pending_updates( const std::string& path, const std::vector< tip_update >& tip_updates );
+    void record_stats( const std::string& path, base::fetch_stats stats, const bool ok );
+    void dump_stats();
 
     //callbacks with params determined by the lib
     static int progress_cb(const char *str, int len, void *data);
@@ -48,14 +128,32 @@ private:
 
 private:
     repos m_repos;
+    credentials m_credentials;
+    base::fetch_scheduler m_scheduler;
+    std::shared_ptr< base::identity_table > m_identities{ std::make_shared< base::identity_table >() };
 
-    static credentials mCredentials;
-    static base::repo_wrapper* mCurrentRepo;
+    new_branches_storage m_new_branches;
+    new_commits_storage m_new_commits;
+    // tip updates per repo path whose changes haven't been collected yet
+    std::map< std::string, std::vector< tip_update > > m_pending_updates;
+    std::mutex m_changes_mutex;
 
-    static new_braches m_new_branches;
-    static new_commits m_new_commits;
+    stats_storage m_stats;
+    std::chrono::seconds m_dump_interval{ 0 };
+    std::chrono::steady_clock::time_point m_last_dump;
+    stats_sink m_dump_sink;
+    mutable std::mutex m_stats_mutex;
 };
 
+////////////////////////////////////////////////////////////////////////////////
+/////////////////                   Aux                   //////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+namespace aux
+{
+    void print_stats( const git_handler::stats_storage& stats );
+}
+
 } //git_handler
 
 #endif // GITHANDLER_H
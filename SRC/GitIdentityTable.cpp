@@ -0,0 +1,102 @@
+#include <mutex>
+#include <stdexcept>
+
+#include <boost/functional/hash.hpp>
+
+#include "GitIdentityTable.h"
+
+namespace git_handler
+{
+
+namespace base
+{
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////              IdentityTable              //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+const identity_table::identity_id identity_table::no_identity;
+
+bool identity_table::key::operator==( const key& other ) const noexcept
+{
+    return name == other.name && email == other.email;
+}
+
+size_t identity_table::key_hash::operator()( const key& identity ) const noexcept
+{
+    size_t hash{ boost::hash_range( identity.name.begin(), identity.name.end() ) };
+    boost::hash_combine( hash, boost::hash_range( identity.email.begin(), identity.email.end() ) );
+    return hash;
+}
+
+auto identity_table::intern( const boost::string_view name, const boost::string_view email ) -> identity_id
+{
+    const key identity{ name, email };
+
+    // most lookups find a known identity, those only take the shared lock
+    {
+        std::shared_lock< std::shared_timed_mutex > l{ m_mutex };
+
+        const identity_id known{ find_locked( identity ) };
+        if( known != no_identity )
+        {
+            return known;
+        }
+    }
+
+    std::unique_lock< std::shared_timed_mutex > l{ m_mutex };
+
+    // another thread may have added it in between
+    const identity_id known{ find_locked( identity ) };
+    if( known != no_identity )
+    {
+        return known;
+    }
+
+    if( m_identities.size() >= no_identity )
+    {
+        throw std::logic_error{ "Too many identities" };
+    }
+
+    m_identities.push_back( { name.to_string(), email.to_string() } );
+    const auto& added = m_identities.back();
+
+    const auto id = static_cast< identity_id >( m_identities.size() - 1 );
+    m_ids.emplace( key{ added.name, added.email }, id );
+
+    return id;
+}
+
+auto identity_table::find( const boost::string_view name, const boost::string_view email ) const noexcept -> identity_id
+{
+    std::shared_lock< std::shared_timed_mutex > l{ m_mutex };
+    return find_locked( key{ name, email } );
+}
+
+size_t identity_table::size() const noexcept
+{
+    std::shared_lock< std::shared_timed_mutex > l{ m_mutex };
+    return m_identities.size();
+}
+
+boost::string_view identity_table::name( const identity_id identity ) const noexcept
+{
+    std::shared_lock< std::shared_timed_mutex > l{ m_mutex };
+    return m_identities[ identity ].name;
+}
+
+boost::string_view identity_table::email( const identity_id identity ) const noexcept
+{
+    std::shared_lock< std::shared_timed_mutex > l{ m_mutex };
+    return m_identities[ identity ].email;
+}
+
+auto identity_table::find_locked( const key& identity ) const noexcept -> identity_id
+{
+    auto found = m_ids.find( identity );
+    return found != m_ids.end() ? found->second : no_identity;
+}
+
+}//base
+
+}//git_handler
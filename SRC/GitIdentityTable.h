@@ -0,0 +1,82 @@
+#ifndef GITIDENTITYTABLE_H
+#define GITIDENTITYTABLE_H
+
+#include <deque>
+#include <string>
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include <boost/utility/string_view.hpp>
+
+namespace git_handler
+{
+
+namespace base
+{
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////              IdentityTable              //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+// Interned author and committer identities: every distinct ( name, email ) pair is stored once
+// and gets a small id, numbered from 0 in the order of interning. Ids and names never change
+// and the views stay valid as long as the table, so records can keep ids and compare them
+// instead of strings. Safe to use from several threads, a repo owns one by default and
+// git_handler shares one between all its repos
+class identity_table
+{
+public:
+    using identity_id = uint32_t;
+
+    static const identity_id no_identity{ UINT32_MAX };
+
+public:
+    identity_table() = default;
+    identity_table( const identity_table& ) = delete;
+    identity_table& operator=( const identity_table& ) = delete;
+
+    // id of the identity, added if it isn't known yet. Throws std::logic_error once the ids run out
+    identity_id intern( const boost::string_view name, const boost::string_view email );
+    // no_identity if the identity isn't known
+    identity_id find( const boost::string_view name, const boost::string_view email ) const noexcept;
+
+    size_t size() const noexcept;
+    boost::string_view name( const identity_id identity ) const noexcept;
+    boost::string_view email( const identity_id identity ) const noexcept;
+
+private:
+    struct key
+    {
+        boost::string_view name;
+        boost::string_view email;
+
+        bool operator==( const key& other ) const noexcept;
+    };
+
+    struct key_hash
+    {
+        size_t operator()( const key& identity ) const noexcept;
+    };
+
+    struct identity
+    {
+        std::string name;
+        std::string email;
+    };
+
+private:
+    identity_id find_locked( const key& identity ) const noexcept;
+
+private:
+    // a deque never moves its elements, so the keys can point into them
+    std::deque< identity > m_identities;
+    std::unordered_map< key, identity_id, key_hash > m_ids;
+    mutable std::shared_timed_mutex m_mutex;
+};
+
+}//base
+
+}//git_handler
+
+#endif // GITIDENTITYTABLE_H
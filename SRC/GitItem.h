@@ -3,7 +3,7 @@
 
 #include <type_traits>
 
-#include "memory"
+#include <memory>
 #include "GitDeleters.h"
 
 namespace details
@@ -27,20 +27,22 @@ namespace git_handler
 namespace item
 {
 
-// Base item class
-class item
-{
-public:
-    virtual ~item() = default;
-};
-
+// Owning handle of a libgit2 object. The deleter is picked at compile time from the libgit2 type
+// and takes no storage, so an item is the size of a raw pointer and can be kept by value
 template< class LibGitItemType >
-class git_item : public item, public details::unique_ptr_base< LibGitItemType >
+class git_item : public details::unique_ptr_base< LibGitItemType >
 {    
     using details::unique_ptr_base< LibGitItemType >::unique_ptr;
 
+    static_assert( sizeof( details::unique_ptr_base< LibGitItemType > ) == sizeof( LibGitItemType* ),
+                   "the deleter must not take storage" );
+
 public:
     using _internalType = LibGitItemType;
+
+public:
+    explicit git_item( LibGitItemType* manage = nullptr ) noexcept :
+        details::unique_ptr_base< LibGitItemType >( manage ){}
 };
 
 // type checkers
@@ -48,10 +50,16 @@ template< typename T, typename = void, typename = void >
 struct is_git_item : std::false_type{};
 
 template< typename T >
-struct is_git_item< T, details::tag_checker_t< T >, std::enable_if_t< std::is_base_of< item, T >::value > > : std::true_type{};
+struct is_git_item< T, details::tag_checker_t< T >,
+                    std::enable_if_t< std::is_base_of< git_item< typename T::_internalType >, T >::value > > : std::true_type{};
 
-// Item types
-enum class type;
+// Creates a heap allocated item for the handles kept behind a pointer, like the repos and
+// the branch refs. Short-lived items are created by value
+template< class GitItemType, typename = std::enable_if_t< is_git_item< GitItemType >::value > >
+std::unique_ptr< GitItemType > make_item( typename GitItemType::_internalType* manage = nullptr )
+{
+    return std::make_unique< GitItemType >( manage );
+}
 
 } //item
 
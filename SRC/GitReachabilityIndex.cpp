@@ -0,0 +1,446 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "GitReachabilityIndex.h"
+
+namespace git_handler
+{
+
+namespace base
+{
+
+namespace
+{
+
+// Per-thread search state. A node is visited in the current query if its mark equals the epoch
+// and known to reach the target if its alive mark does, so starting a query only takes a new epoch
+struct visit_marks
+{
+    struct frame
+    {
+        uint32_t node;
+        uint32_t next_parent;
+    };
+
+    std::vector< uint32_t > marks;
+    std::vector< uint32_t > alive;
+    std::vector< frame > path;
+    uint32_t epoch{ 0 };
+
+    void next_epoch( const size_t nodes_count )
+    {
+        if( marks.size() < nodes_count )
+        {
+            marks.resize( nodes_count, 0 );
+            alive.resize( nodes_count, 0 );
+        }
+
+        if( ++epoch == 0 )
+        {
+            std::fill( marks.begin(), marks.end(), 0 );
+            std::fill( alive.begin(), alive.end(), 0 );
+            epoch = 1;
+        }
+    }
+};
+
+visit_marks& thread_marks()
+{
+    thread_local visit_marks marks;
+    return marks;
+}
+
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////           ReachabilityIndex             //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+void reachability_index::batch::add( const git_oid& id, const std::vector< git_oid >& parents )
+{
+    m_ids.push_back( id );
+    m_parents_counts.push_back( static_cast< uint32_t >( parents.size() ) );
+    m_parents.insert( m_parents.end(), parents.begin(), parents.end() );
+}
+
+size_t reachability_index::batch::size() const noexcept
+{
+    return m_ids.size();
+}
+
+bool reachability_index::batch::empty() const noexcept
+{
+    return m_ids.empty();
+}
+
+void reachability_index::add( const batch& commits )
+{
+    std::unique_lock< std::shared_timed_mutex > l{ m_mutex };
+
+    const size_t old_nodes_count{ m_nodes.size() };
+    const size_t old_parents_count{ m_parents.size() };
+
+    // the nodes are added first, so that parents from the same batch can be resolved
+    std::vector< size_t > new_commits;
+    for( size_t commit_num = 0; commit_num < commits.m_ids.size(); ++commit_num )
+    {
+        const auto& id = commits.m_ids[ commit_num ];
+        if( m_index.emplace( id, static_cast< uint32_t >( m_nodes.size() ) ).second )
+        {
+            m_nodes.push_back( node{ id, 0, 0, 0, {}, {}, {} } );
+            new_commits.push_back( commit_num );
+        }
+    }
+
+    if( new_commits.empty() )
+    {
+        return;
+    }
+
+    std::vector< size_t > first_parents( commits.m_ids.size() );
+    for( size_t commit_num = 0, first_parent = 0; commit_num < commits.m_ids.size(); ++commit_num )
+    {
+        first_parents[ commit_num ] = first_parent;
+        first_parent += commits.m_parents_counts[ commit_num ];
+    }
+
+    for( size_t new_num = 0; new_num < new_commits.size(); ++new_num )
+    {
+        const size_t commit_num{ new_commits[ new_num ] };
+        auto& added_node = m_nodes[ old_nodes_count + new_num ];
+
+        added_node.first_parent = static_cast< uint32_t >( m_parents.size() );
+        added_node.parents_count = commits.m_parents_counts[ commit_num ];
+
+        for( uint32_t parent_num = 0; parent_num < added_node.parents_count; ++parent_num )
+        {
+            const uint32_t parent{ find( commits.m_parents[ first_parents[ commit_num ] + parent_num ] ) };
+            if( parent == no_node )
+            {
+                // the index stays as it was before the batch
+                for( size_t node_num = old_nodes_count; node_num < m_nodes.size(); ++node_num )
+                {
+                    m_index.erase( m_nodes[ node_num ].id );
+                }
+
+                m_nodes.resize( old_nodes_count );
+                m_parents.resize( old_parents_count );
+
+                throw std::logic_error{ "Commit parents are missing from the reachability index" };
+            }
+
+            m_parents.push_back( parent );
+        }
+    }
+
+    compute_labels( static_cast< uint32_t >( old_nodes_count ) );
+}
+
+void reachability_index::set_tip( const std::string& ref_name, const git_oid& tip )
+{
+    std::unique_lock< std::shared_timed_mutex > l{ m_mutex };
+    m_tips[ ref_name ] = tip;
+}
+
+void reachability_index::remove_tip( const std::string& ref_name )
+{
+    std::unique_lock< std::shared_timed_mutex > l{ m_mutex };
+    m_tips.erase( ref_name );
+}
+
+void reachability_index::clear() noexcept
+{
+    std::unique_lock< std::shared_timed_mutex > l{ m_mutex };
+
+    m_nodes.clear();
+    m_parents.clear();
+    m_index.clear();
+    m_tips.clear();
+    std::fill( std::begin( m_last_post ), std::end( m_last_post ), 0 );
+}
+
+size_t reachability_index::size() const noexcept
+{
+    std::shared_lock< std::shared_timed_mutex > l{ m_mutex };
+    return m_nodes.size();
+}
+
+bool reachability_index::contains( const git_oid& id ) const noexcept
+{
+    std::shared_lock< std::shared_timed_mutex > l{ m_mutex };
+    return find( id ) != no_node;
+}
+
+uint32_t reachability_index::generation( const git_oid& id ) const noexcept
+{
+    std::shared_lock< std::shared_timed_mutex > l{ m_mutex };
+
+    const uint32_t node{ find( id ) };
+    return node != no_node ? m_nodes[ node ].generation : 0;
+}
+
+bool reachability_index::is_ancestor( const git_oid& ancestor, const git_oid& descendant ) const
+{
+    std::shared_lock< std::shared_timed_mutex > l{ m_mutex };
+
+    const uint32_t target{ find( ancestor ) };
+    const uint32_t from{ find( descendant ) };
+    if( target == no_node || from == no_node )
+    {
+        return false;
+    }
+
+    thread_marks().next_epoch( m_nodes.size() );
+    return reaches( from, target );
+}
+
+bool reachability_index::branch_contains( const std::string& ref_name, const git_oid& id ) const
+{
+    git_oid tip;
+
+    {
+        std::shared_lock< std::shared_timed_mutex > l{ m_mutex };
+
+        auto stored_tip = m_tips.find( ref_name );
+        if( stored_tip == m_tips.end() )
+        {
+            return false;
+        }
+
+        tip = stored_tip->second;
+    }
+
+    return is_ancestor( id, tip );
+}
+
+std::vector< std::string > reachability_index::branches_containing( const git_oid& id ) const
+{
+    std::vector< std::string > branches;
+
+    std::shared_lock< std::shared_timed_mutex > l{ m_mutex };
+
+    const uint32_t target{ find( id ) };
+    if( target == no_node )
+    {
+        return branches;
+    }
+
+    thread_marks().next_epoch( m_nodes.size() );
+
+    // the marks stay valid for the whole query, the branches share most of their histories,
+    // so every search after the first one mostly stops at nodes already known to reach or not
+    for( const auto& tip : m_tips )
+    {
+        const uint32_t from{ find( tip.second ) };
+        if( from != no_node && reaches( from, target ) )
+        {
+            branches.push_back( tip.first );
+        }
+    }
+
+    return branches;
+}
+
+uint32_t reachability_index::find( const git_oid& id ) const noexcept
+{
+    auto node = m_index.find( id );
+    return node != m_index.end() ? node->second : no_node;
+}
+
+void reachability_index::compute_labels( const uint32_t first_node )
+{
+    for( size_t labeling = 0; labeling < labelings_count; ++labeling )
+    {
+        compute_labeling( first_node, labeling );
+    }
+}
+
+void reachability_index::compute_labeling( const uint32_t first_node, const size_t labeling )
+{
+    // new commits are never ancestors of the indexed ones, so the old labels stay valid
+    // and the new commits simply continue the post order
+    struct frame
+    {
+        uint32_t node;
+        uint32_t next_parent;
+    };
+
+    std::vector< frame > path;
+
+    for( uint32_t node_num = first_node; node_num < m_nodes.size(); ++node_num )
+    {
+        if( m_nodes[ node_num ].post[ labeling ] )
+        {
+            continue;
+        }
+
+        m_nodes[ node_num ].tree_low[ labeling ] = m_last_post[ labeling ] + 1;
+        path.push_back( { node_num, 0 } );
+
+        while( !path.empty() )
+        {
+            auto& current_frame = path.back();
+            auto& current = m_nodes[ current_frame.node ];
+
+            if( current_frame.next_parent < current.parents_count )
+            {
+                // every labeling takes the parents in its own order
+                const uint32_t parent_num{ current_frame.next_parent++ };
+                const uint32_t parent_pos{ labeling % 2 ? current.parents_count - 1 - parent_num : parent_num };
+                const uint32_t parent{ m_parents[ current.first_parent + parent_pos ] };
+
+                // in a DAG an unfinished parent can't be on the path, so it hasn't been visited yet
+                if( !m_nodes[ parent ].post[ labeling ] )
+                {
+                    m_nodes[ parent ].tree_low[ labeling ] = m_last_post[ labeling ] + 1;
+                    path.push_back( { parent, 0 } );
+                }
+
+                continue;
+            }
+
+            uint32_t generation{ 0 };
+            uint32_t low{ UINT32_MAX };
+
+            for( uint32_t parent_num = 0; parent_num < current.parents_count; ++parent_num )
+            {
+                const auto& parent = m_nodes[ m_parents[ current.first_parent + parent_num ] ];
+                generation = std::max( generation, parent.generation );
+                low = std::min( low, parent.low[ labeling ] );
+            }
+
+            current.post[ labeling ] = ++m_last_post[ labeling ];
+            current.low[ labeling ] = std::min( low, current.post[ labeling ] );
+
+            if( !current.generation )
+            {
+                current.generation = generation + 1;
+            }
+
+            path.pop_back();
+        }
+    }
+}
+
+bool reachability_index::may_reach( const uint32_t from, const uint32_t target ) const noexcept
+{
+    const auto& from_node = m_nodes[ from ];
+    const auto& target_node = m_nodes[ target ];
+
+    if( from_node.generation <= target_node.generation )
+    {
+        return false;
+    }
+
+    for( size_t labeling = 0; labeling < labelings_count; ++labeling )
+    {
+        if( target_node.post[ labeling ] > from_node.post[ labeling ] ||
+            target_node.low[ labeling ] < from_node.low[ labeling ] )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool reachability_index::surely_reaches( const uint32_t from, const uint32_t target ) const noexcept
+{
+    const auto& from_node = m_nodes[ from ];
+    const auto& target_node = m_nodes[ target ];
+
+    for( size_t labeling = 0; labeling < labelings_count; ++labeling )
+    {
+        if( from_node.tree_low[ labeling ] <= target_node.post[ labeling ] &&
+            target_node.post[ labeling ] <= from_node.post[ labeling ] )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool reachability_index::reaches( const uint32_t from, const uint32_t target ) const
+{
+    auto& marks = thread_marks();
+    const uint32_t epoch{ marks.epoch };
+
+    if( from == target || marks.alive[ from ] == epoch )
+    {
+        return true;
+    }
+
+    if( marks.marks[ from ] == epoch || !may_reach( from, target ) )
+    {
+        return false;
+    }
+
+    if( surely_reaches( from, target ) )
+    {
+        marks.alive[ from ] = epoch;
+        return true;
+    }
+
+    // a parent settled by the labels or by an earlier search ends the search right away
+    auto settles = [ & ]( const uint32_t parent )
+                   {
+                       return parent == target || marks.alive[ parent ] == epoch ||
+                              ( marks.marks[ parent ] != epoch && may_reach( parent, target ) && surely_reaches( parent, target ) );
+                   };
+
+    auto enter = [ & ]( const uint32_t node )
+                 {
+                     marks.marks[ node ] = epoch;
+                     marks.path.push_back( { node, 0 } );
+
+                     const auto& entered = m_nodes[ node ];
+                     for( uint32_t parent_num = 0; parent_num < entered.parents_count; ++parent_num )
+                     {
+                         if( settles( m_parents[ entered.first_parent + parent_num ] ) )
+                         {
+                             return true;
+                         }
+                     }
+
+                     return false;
+                 };
+
+    // depth first, so that on success the nodes on the path are the ones known to reach the target,
+    // while every node left behind has been fully explored and can't reach it. All the parents
+    // of a node are checked before descending into any of them
+    marks.path.clear();
+
+    bool found{ enter( from ) };
+    while( !found && !marks.path.empty() )
+    {
+        auto& frame = marks.path.back();
+        const auto& current = m_nodes[ frame.node ];
+
+        if( frame.next_parent == current.parents_count )
+        {
+            marks.path.pop_back();
+            continue;
+        }
+
+        const uint32_t parent{ m_parents[ current.first_parent + frame.next_parent++ ] };
+        if( marks.marks[ parent ] != epoch && may_reach( parent, target ) )
+        {
+            found = enter( parent );
+        }
+    }
+
+    if( found )
+    {
+        for( const auto& reaching : marks.path )
+        {
+            marks.alive[ reaching.node ] = epoch;
+        }
+    }
+
+    return found;
+}
+
+}//base
+
+}//git_handler
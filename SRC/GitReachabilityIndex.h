@@ -0,0 +1,121 @@
+#ifndef GITREACHABILITYINDEX_H
+#define GITREACHABILITYINDEX_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include <git2.h>
+
+#include "details/OidHash.h"
+
+namespace git_handler
+{
+
+namespace base
+{
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////           ReachabilityIndex             //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+// Commit graph of a repo answering ancestry queries without touching the ODB. Every commit
+// gets a generation number, 1 for root commits and one more than the highest of its parents
+// otherwise, so a search for an ancestor never descends below the ancestor's generation.
+// Every commit also gets a couple of depth first post-order labelings, one per parents order.
+// The interval from the lowest rank among a commit's ancestors to its own rank holds the ranks
+// of all its ancestors, so a commit whose interval misses the target's rank can't reach it,
+// which turns down most of the negative searches right away. The commits finished while one
+// was being visited are its ancestors, which settles most positive ones. Parents are kept in one array
+// indexed by the commits. The index only takes complete histories: the parents of every added
+// commit must be in the index or in the same batch
+class reachability_index
+{
+public:
+    // commits to add, in any order
+    class batch
+    {
+        friend class reachability_index;
+
+    public:
+        void add( const git_oid& id, const std::vector< git_oid >& parents );
+        size_t size() const noexcept;
+        bool empty() const noexcept;
+
+    private:
+        std::vector< git_oid > m_ids;
+        std::vector< uint32_t > m_parents_counts;
+        std::vector< git_oid > m_parents;
+    };
+
+public:
+    reachability_index() = default;
+    reachability_index( const reachability_index& ) = delete;
+    reachability_index& operator=( const reachability_index& ) = delete;
+
+    // throws std::logic_error if a parent is neither indexed nor in the batch
+    void add( const batch& commits );
+    void set_tip( const std::string& ref_name, const git_oid& tip );
+    void remove_tip( const std::string& ref_name );
+    void clear() noexcept;
+
+    size_t size() const noexcept;
+    bool contains( const git_oid& id ) const noexcept;
+    // 0 for unknown commits
+    uint32_t generation( const git_oid& id ) const noexcept;
+
+    // whether ancestor is reachable from descendant, a commit being its own ancestor.
+    // Unknown commits are not reachable from anything
+    bool is_ancestor( const git_oid& ancestor, const git_oid& descendant ) const;
+    // whether the commit is in the history of the branch with the given full ref name
+    bool branch_contains( const std::string& ref_name, const git_oid& id ) const;
+    // full ref names of the branches whose history has the commit
+    std::vector< std::string > branches_containing( const git_oid& id ) const;
+
+private:
+    static const size_t labelings_count{ 2 };
+
+    struct node
+    {
+        git_oid id;
+        uint32_t generation;
+        uint32_t first_parent;
+        uint32_t parents_count;
+        // post-order rank, 0 until labeled, the lowest rank among the ancestors
+        // and the lowest rank finished while the commit was being visited
+        uint32_t post[ labelings_count ];
+        uint32_t low[ labelings_count ];
+        uint32_t tree_low[ labelings_count ];
+    };
+
+    using node_index = std::unordered_map< git_oid, uint32_t, details::oid_hash, details::oid_equal >;
+
+    static const uint32_t no_node{ UINT32_MAX };
+
+private:
+    uint32_t find( const git_oid& id ) const noexcept;
+    void compute_labels( const uint32_t first_node );
+    void compute_labeling( const uint32_t first_node, const size_t labeling );
+    bool may_reach( const uint32_t from, const uint32_t target ) const noexcept;
+    bool surely_reaches( const uint32_t from, const uint32_t target ) const noexcept;
+    // searches the parents of from for the target using the marks of the current query
+    bool reaches( const uint32_t from, const uint32_t target ) const;
+
+private:
+    std::vector< node > m_nodes;
+    std::vector< uint32_t > m_parents;
+    uint32_t m_last_post[ labelings_count ]{};
+    node_index m_index;
+    std::map< std::string, git_oid > m_tips;
+    mutable std::shared_timed_mutex m_mutex;
+};
+
+}//base
+
+}//git_handler
+
+#endif // GITREACHABILITYINDEX_H
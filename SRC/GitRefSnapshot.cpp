@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "GitRefSnapshot.h"
+
+namespace git_handler
+{
+
+namespace base
+{
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////               RefSnapshot               //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+ref_snapshot::ref_snapshot() : m_refs( std::make_shared< const refs >() )
+{
+
+}
+
+ref_snapshot::ref_snapshot( refs snapshot_refs )
+{
+    std::sort( snapshot_refs.begin(), snapshot_refs.end(),
+               []( const ref& left, const ref& right ){ return left.name < right.name; } );
+
+    auto duplicate = std::adjacent_find( snapshot_refs.begin(), snapshot_refs.end(),
+                                         []( const ref& left, const ref& right ){ return left.name == right.name; } );
+    if( duplicate != snapshot_refs.end() )
+    {
+        throw std::logic_error{ "Duplicate ref " + duplicate->name + " in a snapshot" };
+    }
+
+    m_refs = std::make_shared< const refs >( std::move( snapshot_refs ) );
+}
+
+size_t ref_snapshot::size() const noexcept
+{
+    return m_refs->size();
+}
+
+bool ref_snapshot::empty() const noexcept
+{
+    return m_refs->empty();
+}
+
+auto ref_snapshot::begin() const noexcept -> const_iterator
+{
+    return m_refs->begin();
+}
+
+auto ref_snapshot::end() const noexcept -> const_iterator
+{
+    return m_refs->end();
+}
+
+auto ref_snapshot::find( const std::string& name ) const noexcept -> const ref*
+{
+    auto found = std::lower_bound( m_refs->begin(), m_refs->end(), name,
+                                   []( const ref& stored, const std::string& searched ){ return stored.name < searched; } );
+
+    return found != m_refs->end() && found->name == name ? &*found : nullptr;
+}
+
+auto ref_snapshot::diff( const ref_snapshot& previous ) const -> std::vector< ref_change >
+{
+    std::vector< ref_change > changes;
+
+    // a copy of the same snapshot can't differ
+    if( m_refs == previous.m_refs )
+    {
+        return changes;
+    }
+
+    const git_oid zero_id{};
+
+    // both sides are sorted, so one merge pass finds every change
+    auto old_ref = previous.begin();
+    auto new_ref = begin();
+
+    while( old_ref != previous.end() || new_ref != end() )
+    {
+        if( new_ref == end() || ( old_ref != previous.end() && old_ref->name < new_ref->name ) )
+        {
+            changes.push_back( { old_ref->name, old_ref->tip, zero_id } );
+            ++old_ref;
+        }
+        else if( old_ref == previous.end() || new_ref->name < old_ref->name )
+        {
+            changes.push_back( { new_ref->name, zero_id, new_ref->tip } );
+            ++new_ref;
+        }
+        else
+        {
+            if( !git_oid_equal( &old_ref->tip, &new_ref->tip ) )
+            {
+                changes.push_back( { new_ref->name, old_ref->tip, new_ref->tip } );
+            }
+
+            ++old_ref;
+            ++new_ref;
+        }
+    }
+
+    return changes;
+}
+
+}//base
+
+}//git_handler
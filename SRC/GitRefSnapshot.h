@@ -0,0 +1,66 @@
+#ifndef GITREFSNAPSHOT_H
+#define GITREFSNAPSHOT_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <git2.h>
+
+namespace git_handler
+{
+
+namespace base
+{
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////               RefSnapshot               //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+// Immutable set of refs and their tips taken at some point. The refs are kept sorted by name
+// and shared between the copies, so snapshots are cheap to pass around and to diff
+class ref_snapshot
+{
+public:
+    struct ref
+    {
+        std::string name;
+        git_oid tip;
+    };
+
+    // added refs have a zero old tip, removed ones a zero new tip
+    struct ref_change
+    {
+        std::string name;
+        git_oid old_tip;
+        git_oid new_tip;
+    };
+
+    using refs = std::vector< ref >;
+    using const_iterator = refs::const_iterator;
+
+public:
+    ref_snapshot();
+    // the refs may come in any order, but their names must be unique
+    explicit ref_snapshot( refs snapshot_refs );
+
+    size_t size() const noexcept;
+    bool empty() const noexcept;
+    const_iterator begin() const noexcept;
+    const_iterator end() const noexcept;
+
+    // nullptr if the snapshot doesn't have the ref
+    const ref* find( const std::string& name ) const noexcept;
+
+    // the changes leading from the previous snapshot to this one, sorted by ref name
+    std::vector< ref_change > diff( const ref_snapshot& previous ) const;
+
+private:
+    std::shared_ptr< const refs > m_refs;
+};
+
+}//base
+
+}//git_handler
+
+#endif // GITREFSNAPSHOT_H
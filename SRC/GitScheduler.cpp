@@ -0,0 +1,320 @@
+#include <cctype>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#include "GitScheduler.h"
+
+namespace git_handler
+{
+
+namespace base
+{
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////               Scheduler                 //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+fetch_scheduler::fetch_scheduler( const schedule_options& options )
+{
+    set_options( options );
+}
+
+void fetch_scheduler::set_options( const schedule_options& options )
+{
+    if( options.min_interval > options.max_interval || options.backoff < 1.0 ||
+        options.speedup <= 0.0 || options.speedup > 1.0 || options.failure_backoff < 1.0 )
+    {
+        throw std::logic_error{ "Invalid schedule options" };
+    }
+
+    std::lock_guard< std::mutex > l{ m_mutex };
+
+    m_options = options;
+    for( auto& repo : m_repos )
+    {
+        repo.second.interval = clamp( repo.second.interval );
+    }
+
+    // raised caps may unblock waiting workers
+    m_completed.notify_all();
+}
+
+schedule_options fetch_scheduler::options() const
+{
+    std::lock_guard< std::mutex > l{ m_mutex };
+    return m_options;
+}
+
+void fetch_scheduler::add( const std::string& path, const std::vector< std::string >& hosts, const int priority )
+{
+    std::lock_guard< std::mutex > l{ m_mutex };
+
+    repo_state repo;
+    repo.hosts = hosts;
+    repo.priority = priority;
+    repo.interval = clamp( m_options.initial_interval );
+
+    m_repos.emplace( path, std::move( repo ) );
+}
+
+void fetch_scheduler::remove( const std::string& path )
+{
+    std::lock_guard< std::mutex > l{ m_mutex };
+
+    auto repo = m_repos.find( path );
+    if( repo == m_repos.end() )
+    {
+        return;
+    }
+
+    if( repo->second.running )
+    {
+        set_running( repo, false );
+    }
+
+    m_round.erase( std::remove( m_round.begin(), m_round.end(), repo ), m_round.end() );
+    m_repos.erase( repo );
+    m_completed.notify_all();
+}
+
+void fetch_scheduler::clear() noexcept
+{
+    std::lock_guard< std::mutex > l{ m_mutex };
+
+    m_round.clear();
+    m_repos.clear();
+    m_running = 0;
+    m_running_per_host.clear();
+    m_completed.notify_all();
+}
+
+void fetch_scheduler::set_priority( const std::string& path, const int priority )
+{
+    std::lock_guard< std::mutex > l{ m_mutex };
+
+    auto repo = m_repos.find( path );
+    if( repo == m_repos.end() )
+    {
+        throw std::logic_error{ "Unknown repo " + path };
+    }
+
+    repo->second.priority = priority;
+}
+
+void fetch_scheduler::start_round( const clock::time_point now )
+{
+    std::lock_guard< std::mutex > l{ m_mutex };
+
+    m_round.clear();
+    for( auto repo = m_repos.begin(); repo != m_repos.end(); ++repo )
+    {
+        if( !repo->second.running && repo->second.next_fetch <= now )
+        {
+            m_round.push_back( repo );
+        }
+    }
+
+    std::stable_sort( m_round.begin(), m_round.end(),
+                      []( const repos::iterator& left, const repos::iterator& right )
+                      {
+                          if( left->second.priority != right->second.priority )
+                          {
+                              return left->second.priority > right->second.priority;
+                          }
+
+                          return left->second.next_fetch < right->second.next_fetch;
+                      } );
+}
+
+bool fetch_scheduler::acquire( std::string& path )
+{
+    std::unique_lock< std::mutex > l{ m_mutex };
+
+    for( ;; )
+    {
+        if( m_round.empty() )
+        {
+            return false;
+        }
+
+        if( !m_options.max_concurrent || m_running < m_options.max_concurrent )
+        {
+            // the round is in priority order, so the first repo the host caps allow is the one to run
+            auto next = std::find_if( m_round.begin(), m_round.end(),
+                                      [ this ]( const repos::iterator& repo ){ return can_run( repo->second ); } );
+
+            if( next != m_round.end() )
+            {
+                path = ( *next )->first;
+                set_running( *next, true );
+                m_round.erase( next );
+                return true;
+            }
+        }
+
+        // the caps block every remaining repo, the running fetches will free them
+        if( !m_running )
+        {
+            m_round.clear();
+            return false;
+        }
+
+        m_completed.wait( l );
+    }
+}
+
+void fetch_scheduler::complete( const std::string& path, const fetch_outcome outcome, const clock::time_point now )
+{
+    std::lock_guard< std::mutex > l{ m_mutex };
+
+    auto repo = m_repos.find( path );
+    if( repo == m_repos.end() || !repo->second.running )
+    {
+        return;
+    }
+
+    auto& state = repo->second;
+    set_running( repo, false );
+
+    switch( outcome )
+    {
+    case fetch_outcome::changed:
+        state.failures = 0;
+        state.interval = clamp( std::chrono::duration_cast< clock::duration >( state.interval * m_options.speedup ) );
+        state.next_fetch = now + state.interval;
+        break;
+
+    case fetch_outcome::unchanged:
+        state.failures = 0;
+        state.interval = clamp( std::chrono::duration_cast< clock::duration >( state.interval * m_options.backoff ) );
+        state.next_fetch = now + state.interval;
+        break;
+
+    case fetch_outcome::failed:
+    {
+        // the interval itself is kept, the repo is expected to behave as before once it recovers
+        ++state.failures;
+
+        const double factor{ std::pow( m_options.failure_backoff, static_cast< double >( state.failures ) ) };
+        const double delay{ std::min( std::chrono::duration< double >( state.interval ).count() * factor,
+                                      std::chrono::duration< double >( m_options.max_interval ).count() ) };
+
+        state.next_fetch = now + std::chrono::duration_cast< clock::duration >( std::chrono::duration< double >( delay ) );
+        break;
+    }
+    }
+
+    m_completed.notify_all();
+}
+
+bool fetch_scheduler::contains( const std::string& path ) const
+{
+    std::lock_guard< std::mutex > l{ m_mutex };
+    return m_repos.count( path ) != 0;
+}
+
+auto fetch_scheduler::state( const std::string& path ) const -> repo_state
+{
+    std::lock_guard< std::mutex > l{ m_mutex };
+
+    auto repo = m_repos.find( path );
+    if( repo == m_repos.end() )
+    {
+        throw std::logic_error{ "Unknown repo " + path };
+    }
+
+    return repo->second;
+}
+
+std::string fetch_scheduler::remote_host( const std::string& url )
+{
+    std::string rest;
+
+    const auto scheme_end = url.find( "://" );
+    if( scheme_end != std::string::npos )
+    {
+        if( url.compare( 0, scheme_end, "file" ) == 0 )
+        {
+            return {};
+        }
+
+        rest = url.substr( scheme_end + 3 );
+        rest = rest.substr( 0, rest.find( '/' ) );
+    }
+    else
+    {
+        // scp-like syntax, a colon before any slash, everything else is a local path,
+        // Windows ones with a drive letter included
+        const auto colon = url.find( ':' );
+        if( colon == std::string::npos || url.find_first_of( "/\\" ) < colon ||
+            ( colon == 1 && std::isalpha( static_cast< unsigned char >( url[ 0 ] ) ) ) )
+        {
+            return {};
+        }
+
+        rest = url.substr( 0, colon );
+    }
+
+    const auto at = rest.rfind( '@' );
+    if( at != std::string::npos )
+    {
+        rest = rest.substr( at + 1 );
+    }
+
+    // a bracketed IPv6 address keeps its colons
+    if( !rest.empty() && rest.front() == '[' )
+    {
+        return rest.substr( 1, rest.find( ']' ) - 1 );
+    }
+
+    return rest.substr( 0, rest.find( ':' ) );
+}
+
+bool fetch_scheduler::can_run( const repo_state& repo ) const noexcept
+{
+    if( !m_options.max_per_host )
+    {
+        return true;
+    }
+
+    for( const auto& host : repo.hosts )
+    {
+        auto running = m_running_per_host.find( host );
+        if( running != m_running_per_host.end() && running->second >= m_options.max_per_host )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void fetch_scheduler::set_running( repos::iterator repo, const bool running )
+{
+    repo->second.running = running;
+    m_running = running ? m_running + 1 : m_running - 1;
+
+    for( const auto& host : repo->second.hosts )
+    {
+        auto& host_running = m_running_per_host[ host ];
+        host_running = running ? host_running + 1 : host_running - 1;
+
+        if( !host_running )
+        {
+            m_running_per_host.erase( host );
+        }
+    }
+}
+
+auto fetch_scheduler::clamp( const clock::duration interval ) const noexcept -> clock::duration
+{
+    const clock::duration min_interval{ m_options.min_interval };
+    const clock::duration max_interval{ m_options.max_interval };
+
+    return std::max( min_interval, std::min( max_interval, interval ) );
+}
+
+}//base
+
+}//git_handler
@@ -0,0 +1,123 @@
+#ifndef GITSCHEDULER_H
+#define GITSCHEDULER_H
+
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <condition_variable>
+
+namespace git_handler
+{
+
+namespace base
+{
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////               Scheduler                 //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+struct schedule_options
+{
+    // bounds of the adaptive refresh intervals, new repos start at initial_interval
+    std::chrono::seconds min_interval{ 30 };
+    std::chrono::seconds max_interval{ 3600 };
+    std::chrono::seconds initial_interval{ 300 };
+
+    // a fetch bringing nothing new multiplies the interval by backoff,
+    // one bringing changes multiplies it by speedup
+    double backoff{ 1.5 };
+    double speedup{ 0.5 };
+
+    // failed fetches are retried after the interval times backoff to the number of failures in a row,
+    // never later than max_interval
+    double failure_backoff{ 2.0 };
+
+    // 0 means no limit
+    size_t max_concurrent{ 8 };
+    size_t max_per_host{ 2 };
+};
+
+enum class fetch_outcome
+{
+    changed,
+    unchanged,
+    failed
+};
+
+// Decides which repos to fetch and when. Every repo has a priority and a refresh interval adapting
+// to how often its fetches bring something new, and counts against the global and per-host caps
+// while it is being fetched. Repos are identified by their path
+class fetch_scheduler
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    struct repo_state
+    {
+        std::vector< std::string > hosts;
+        int priority{ 0 };
+        clock::duration interval{ 0 };
+        clock::time_point next_fetch;
+        size_t failures{ 0 };
+        bool running{ false };
+    };
+
+public:
+    explicit fetch_scheduler( const schedule_options& options = {} );
+    fetch_scheduler( const fetch_scheduler& ) = delete;
+    fetch_scheduler& operator=( const fetch_scheduler& ) = delete;
+
+    // the intervals of the known repos are clamped to the new bounds
+    void set_options( const schedule_options& options );
+    schedule_options options() const;
+
+    // new repos are due right away. Repos on several hosts count against the caps of all of them
+    void add( const std::string& path, const std::vector< std::string >& hosts, const int priority = 0 );
+    void remove( const std::string& path );
+    void clear() noexcept;
+    // higher priorities are fetched first when the caps don't let every due repo run
+    void set_priority( const std::string& path, const int priority );
+
+    // Starts a round with the repos due at the given time, highest priority and longest overdue first
+    void start_round( const clock::time_point now );
+    // Takes the next repo of the round the caps allow to run, waiting for running fetches
+    // to complete while the caps block every remaining one. False once the round is over
+    bool acquire( std::string& path );
+    // ends the fetch of an acquired repo and schedules its next one
+    void complete( const std::string& path, const fetch_outcome outcome, const clock::time_point now );
+
+    bool contains( const std::string& path ) const;
+    // throws std::logic_error for unknown repos
+    repo_state state( const std::string& path ) const;
+
+    // "github.com" for "https://user@github.com:443/a/b.git" and "git@github.com:a/b.git",
+    // empty for local paths, "C:/a.git" included, and file:// urls
+    static std::string remote_host( const std::string& url );
+
+private:
+    using repos = std::map< std::string, repo_state >;
+
+private:
+    bool can_run( const repo_state& repo ) const noexcept;
+    void set_running( repos::iterator repo, const bool running );
+    clock::duration clamp( const clock::duration interval ) const noexcept;
+
+private:
+    schedule_options m_options;
+    repos m_repos;
+    // the due repos of the current round not acquired yet
+    std::vector< repos::iterator > m_round;
+    size_t m_running{ 0 };
+    std::map< std::string, size_t > m_running_per_host;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_completed;
+};
+
+}//base
+
+}//git_handler
+
+#endif // GITSCHEDULER_H
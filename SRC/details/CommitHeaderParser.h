@@ -0,0 +1,228 @@
+#ifndef COMMIT_HEADER_PARSER_H
+#define COMMIT_HEADER_PARSER_H
+
+#include <limits>
+#include <cstdint>
+#include <cstring>
+
+#include <boost/utility/string_view.hpp>
+
+#include <git2.h>
+
+namespace details
+{
+
+// Parsing of raw commit objects as stored in the ODB:
+//
+//   tree <hex>\n
+//   parent <hex>\n ( any number of them )
+//   author <name> <<email>> <time> <+hhmm>\n
+//   committer <name> <<email>> <time> <+hhmm>\n
+//   other headers, a blank line and the message
+//
+// Nothing is copied, the parsed fields point into the raw object
+
+struct commit_signature
+{
+    boost::string_view name;
+    boost::string_view email;
+    int64_t time{ 0 };
+    // utc offset in minutes, as in git_time
+    int offset{ 0 };
+};
+
+struct commit_header_fields
+{
+    const char* tree{ nullptr };
+    // the first of parents_count consecutive parent lines, see parse_parent()
+    const char* parents{ nullptr };
+    size_t parents_count{ 0 };
+    commit_signature author;
+    commit_signature committer;
+    // everything after the blank line ending the headers, empty if there's none
+    boost::string_view message;
+};
+
+// "parent " + hex id + "\n"
+const size_t parent_line_length{ 7 + GIT_OID_HEXSZ + 1 };
+
+inline bool parse_oid( const char* hex, git_oid& id ) noexcept
+{
+    auto digit = []( const char c ) -> int
+                 {
+                     return c >= '0' && c <= '9' ? c - '0' :
+                            c >= 'a' && c <= 'f' ? c - 'a' + 10 :
+                            c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+                 };
+
+    for( size_t byte = 0; byte < GIT_OID_RAWSZ; ++byte )
+    {
+        const int high{ digit( hex[ 2 * byte ] ) };
+        const int low{ digit( hex[ 2 * byte + 1 ] ) };
+        if( high < 0 || low < 0 )
+        {
+            return false;
+        }
+
+        id.id[ byte ] = static_cast< unsigned char >( high << 4 | low );
+    }
+
+    return true;
+}
+
+// id of the parent_num-th parent of parsed fields
+inline bool parse_parent( const commit_header_fields& fields, const size_t parent_num, git_oid& id ) noexcept
+{
+    return parent_num < fields.parents_count &&
+           parse_oid( fields.parents + parent_num * parent_line_length + 7, id );
+}
+
+// "<name> <<email>> <time> <+hhmm>" without the line end
+inline bool parse_signature( const char* begin, const char* end, commit_signature& signature ) noexcept
+{
+    const char* email_begin = static_cast< const char* >( std::memchr( begin, '<', end - begin ) );
+    if( !email_begin )
+    {
+        return false;
+    }
+
+    const char* email_end = static_cast< const char* >( std::memchr( email_begin, '>', end - email_begin ) );
+    if( !email_end )
+    {
+        return false;
+    }
+
+    const char* name_end = email_begin;
+    while( name_end != begin && name_end[ -1 ] == ' ' )
+    {
+        --name_end;
+    }
+
+    signature.name = boost::string_view{ begin, static_cast< size_t >( name_end - begin ) };
+    signature.email = boost::string_view{ email_begin + 1, static_cast< size_t >( email_end - email_begin - 1 ) };
+
+    const char* field = email_end + 1;
+    while( field != end && *field == ' ' )
+    {
+        ++field;
+    }
+
+    if( field == end || *field < '0' || *field > '9' )
+    {
+        return false;
+    }
+
+    // times that don't fit into int64_t are malformed
+    int64_t time{ 0 };
+    for( ; field != end && *field >= '0' && *field <= '9'; ++field )
+    {
+        const int digit{ *field - '0' };
+        if( time > ( std::numeric_limits< int64_t >::max() - digit ) / 10 )
+        {
+            return false;
+        }
+
+        time = time * 10 + digit;
+    }
+
+    signature.time = time;
+    signature.offset = 0;
+
+    // a missing or malformed offset is taken as utc, like libgit2 does
+    if( end - field >= 6 && field[ 0 ] == ' ' && ( field[ 1 ] == '+' || field[ 1 ] == '-' ) )
+    {
+        int digits[ 4 ];
+        for( size_t digit_num = 0; digit_num < 4; ++digit_num )
+        {
+            const char c{ field[ 2 + digit_num ] };
+            if( c < '0' || c > '9' )
+            {
+                return true;
+            }
+
+            digits[ digit_num ] = c - '0';
+        }
+
+        const int offset{ ( digits[ 0 ] * 10 + digits[ 1 ] ) * 60 + digits[ 2 ] * 10 + digits[ 3 ] };
+        signature.offset = field[ 1 ] == '-' ? -offset : offset;
+    }
+
+    return true;
+}
+
+// returns false for objects that aren't well formed commits
+inline bool parse_commit_header( const char* data, const size_t size, commit_header_fields& fields ) noexcept
+{
+    const char* end = data + size;
+
+    // returns the end of the line starting at line if it starts with the keyword, nullptr otherwise
+    auto header_line = [ & ]( const char* line, const char* keyword, const size_t keyword_size ) -> const char*
+                       {
+                           if( static_cast< size_t >( end - line ) <= keyword_size ||
+                               std::memcmp( line, keyword, keyword_size ) != 0 )
+                           {
+                               return nullptr;
+                           }
+
+                           return static_cast< const char* >( std::memchr( line + keyword_size, '\n', end - line - keyword_size ) );
+                       };
+
+    const char* line_end = header_line( data, "tree ", 5 );
+    if( !line_end || line_end - data != 5 + GIT_OID_HEXSZ )
+    {
+        return false;
+    }
+
+    fields.tree = data + 5;
+    fields.parents = line_end + 1;
+    fields.parents_count = 0;
+
+    const char* line = line_end + 1;
+    while( ( line_end = header_line( line, "parent ", 7 ) ) )
+    {
+        git_oid parent;
+        if( line_end - line != 7 + GIT_OID_HEXSZ || !parse_oid( line + 7, parent ) )
+        {
+            return false;
+        }
+
+        ++fields.parents_count;
+        line = line_end + 1;
+    }
+
+    line_end = header_line( line, "author ", 7 );
+    if( !line_end || !parse_signature( line + 7, line_end, fields.author ) )
+    {
+        return false;
+    }
+
+    line = line_end + 1;
+    line_end = header_line( line, "committer ", 10 );
+    if( !line_end || !parse_signature( line + 10, line_end, fields.committer ) )
+    {
+        return false;
+    }
+
+    // the remaining headers ( encoding, gpgsig, ... ) are skipped up to the blank line
+    fields.message = boost::string_view{};
+    for( line = line_end + 1; line < end; line = line_end + 1 )
+    {
+        if( *line == '\n' )
+        {
+            fields.message = boost::string_view{ line + 1, static_cast< size_t >( end - line - 1 ) };
+            break;
+        }
+
+        line_end = static_cast< const char* >( std::memchr( line, '\n', end - line ) );
+        if( !line_end )
+        {
+            break;
+        }
+    }
+
+    return true;
+}
+
+}
+
+#endif // COMMIT_HEADER_PARSER_H
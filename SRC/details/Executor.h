@@ -0,0 +1,99 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+namespace details
+{
+
+// Fixed set of threads running posted tasks in order. Tasks must not throw,
+// the ones still queued when the executor is destroyed are run before it returns
+class executor
+{
+public:
+    using task = std::function< void() >;
+
+public:
+    explicit executor( const size_t threads_count )
+    {
+        for( size_t thread_num = 0; thread_num < std::max< size_t >( 1, threads_count ); ++thread_num )
+        {
+            m_threads.emplace_back( [ this ](){ run(); } );
+        }
+    }
+
+    executor( const executor& ) = delete;
+    executor& operator=( const executor& ) = delete;
+
+    ~executor()
+    {
+        {
+            std::lock_guard< std::mutex > l{ m_mutex };
+            m_stopping = true;
+        }
+
+        m_condition.notify_all();
+
+        for( auto& thread : m_threads )
+        {
+            thread.join();
+        }
+    }
+
+    void post( task new_task )
+    {
+        {
+            std::lock_guard< std::mutex > l{ m_mutex };
+            m_tasks.push_back( std::move( new_task ) );
+        }
+
+        m_condition.notify_one();
+    }
+
+    // the executor the library runs its asynchronous operations on, started on first use
+    static executor& shared()
+    {
+        static executor instance{ std::max( 4u, std::thread::hardware_concurrency() ) };
+        return instance;
+    }
+
+private:
+    void run()
+    {
+        for( ;; )
+        {
+            task current;
+
+            {
+                std::unique_lock< std::mutex > l{ m_mutex };
+                m_condition.wait( l, [ this ](){ return m_stopping || !m_tasks.empty(); } );
+
+                if( m_tasks.empty() )
+                {
+                    return;
+                }
+
+                current = std::move( m_tasks.front() );
+                m_tasks.pop_front();
+            }
+
+            current();
+        }
+    }
+
+private:
+    std::deque< task > m_tasks;
+    std::vector< std::thread > m_threads;
+    bool m_stopping{ false };
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+};
+
+}
+
+#endif // EXECUTOR_H
@@ -0,0 +1,400 @@
+#ifndef MEMORY_POOL_H
+#define MEMORY_POOL_H
+
+#include <new>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <stdlib.h>
+#endif
+
+namespace details
+{
+
+// Slab allocator for the small objects a history load creates by the million.
+// Threads allocate from separate arenas, so that parallel loaders don't contend on one lock. A pool
+// starts with a single arena, loaders add arenas up to their worker count with reserve_arenas(),
+// and threads are spread over them round robin. A slab serves a single size class of a single arena,
+// blocks are carved from it and recycled through its free list. A slab is returned as soon as its
+// last block is freed, unless it is the only one of its size class with free blocks left in its arena,
+// trim() returns those too once a history is dropped
+class memory_pool
+{
+public:
+    static constexpr size_t granularity{ 16 };
+    static constexpr size_t max_pooled_size{ 256 };
+    static constexpr size_t max_arenas{ 64 };
+
+public:
+    // the slab size is rounded up to a power of two
+    explicit memory_pool( const size_t slab_size = 256 * 1024, const size_t arenas_count = 1 ) :
+        m_slab_size( round_up_pow2( std::max( slab_size, 4 * max_pooled_size ) ) )
+    {
+        reserve_arenas( std::max< size_t >( arenas_count, 1 ) );
+    }
+
+    ~memory_pool()
+    {
+        // every block has been freed by now, so all the slabs left are on the free lists
+        trim_arenas( true );
+
+        for( auto& arena : m_arenas )
+        {
+            delete arena.load();
+        }
+    }
+
+    memory_pool( const memory_pool& ) = delete;
+    memory_pool& operator=( const memory_pool& ) = delete;
+
+    void* allocate( const size_t size )
+    {
+        if( size > max_pooled_size )
+        {
+            return ::operator new( size );
+        }
+
+        const size_t size_class{ class_of( size ) };
+        auto& owner = *m_arenas[ thread_slot() % m_arenas_count.load( std::memory_order_acquire ) ].load( std::memory_order_acquire );
+
+        std::lock_guard< std::mutex > l{ owner.mutex };
+
+        auto slab = owner.available[ size_class ];
+        if( !slab )
+        {
+            slab = new_slab( owner, size_class );
+            link( owner, slab );
+        }
+
+        void* block{ nullptr };
+        if( slab->free_blocks )
+        {
+            block = slab->free_blocks;
+            slab->free_blocks = slab->free_blocks->next;
+        }
+        else
+        {
+            block = slab->unused;
+            slab->unused += block_size( size_class );
+        }
+
+        ++slab->used;
+
+        // full slabs leave the list until one of their blocks is freed
+        if( is_full( slab ) )
+        {
+            unlink( owner, slab );
+        }
+
+        return block;
+    }
+
+    void deallocate( void* pointer, const size_t size ) noexcept
+    {
+        if( size > max_pooled_size )
+        {
+            ::operator delete( pointer );
+            return;
+        }
+
+        // slabs are aligned on their size, so the header is found from any of their blocks
+        auto slab = reinterpret_cast< slab_header* >( reinterpret_cast< uintptr_t >( pointer ) & ~( m_slab_size - 1 ) );
+        auto& owner = *slab->owner;
+
+        std::lock_guard< std::mutex > l{ owner.mutex };
+
+        const bool was_full{ is_full( slab ) };
+
+        auto block = static_cast< free_block* >( pointer );
+        block->next = slab->free_blocks;
+        slab->free_blocks = block;
+        --slab->used;
+
+        if( was_full )
+        {
+            link( owner, slab );
+        }
+        else if( !slab->used && ( slab->prev || slab->next ) )
+        {
+            unlink( owner, slab );
+            free_slab( slab );
+            --owner.slabs_count;
+        }
+    }
+
+    // adds arenas up to count, capped at max_arenas, arenas are never removed
+    void reserve_arenas( const size_t count )
+    {
+        std::lock_guard< std::mutex > l{ m_arenas_mutex };
+
+        const size_t target{ std::min( count, max_arenas ) };
+        for( size_t arena_num = m_arenas_count.load(); arena_num < target; ++arena_num )
+        {
+            m_arenas[ arena_num ].store( new arena{}, std::memory_order_release );
+            m_arenas_count.store( arena_num + 1, std::memory_order_release );
+        }
+    }
+
+    // returns the empty slabs kept for the next allocations
+    void trim() noexcept
+    {
+        trim_arenas( false );
+    }
+
+    size_t arenas_count() const noexcept
+    {
+        return m_arenas_count.load( std::memory_order_acquire );
+    }
+
+    size_t slabs_count() const noexcept
+    {
+        size_t count{ 0 };
+        for( size_t arena_num = 0; arena_num < arenas_count(); ++arena_num )
+        {
+            const auto& arena = *m_arenas[ arena_num ].load( std::memory_order_acquire );
+
+            std::lock_guard< std::mutex > l{ arena.mutex };
+            count += arena.slabs_count;
+        }
+
+        return count;
+    }
+
+private:
+    static constexpr size_t classes_count{ max_pooled_size / granularity };
+
+    struct free_block
+    {
+        free_block* next;
+    };
+
+    struct arena;
+
+    struct alignas( granularity ) slab_header
+    {
+        arena* owner;
+        // neighbours in the arena's list of the slabs of the size class with free blocks
+        slab_header* prev;
+        slab_header* next;
+        free_block* free_blocks;
+        // blocks from unused on have never been handed out
+        char* unused;
+        char* end;
+        size_t size_class;
+        size_t used;
+    };
+
+    struct arena
+    {
+        mutable std::mutex mutex;
+        std::array< slab_header*, classes_count > available{};
+        size_t slabs_count{ 0 };
+    };
+
+private:
+    static size_t class_of( const size_t size ) noexcept
+    {
+        return size ? ( size - 1 ) / granularity : 0;
+    }
+
+    static size_t block_size( const size_t size_class ) noexcept
+    {
+        return ( size_class + 1 ) * granularity;
+    }
+
+    static size_t round_up_pow2( const size_t value ) noexcept
+    {
+        size_t result{ 1 };
+        while( result < value )
+        {
+            result <<= 1;
+        }
+
+        return result;
+    }
+
+    // threads get consecutive slots, so that they spread evenly over the arenas
+    static size_t thread_slot() noexcept
+    {
+        static std::atomic< size_t > next_slot{ 0 };
+        static thread_local const size_t slot{ next_slot++ };
+        return slot;
+    }
+
+    static bool is_full( const slab_header* slab ) noexcept
+    {
+        return !slab->free_blocks && static_cast< size_t >( slab->end - slab->unused ) < block_size( slab->size_class );
+    }
+
+    slab_header* new_slab( arena& owner, const size_t size_class )
+    {
+        void* memory{ nullptr };
+#ifdef _WIN32
+        memory = _aligned_malloc( m_slab_size, m_slab_size );
+#else
+        if( posix_memalign( &memory, m_slab_size, m_slab_size ) != 0 )
+        {
+            memory = nullptr;
+        }
+#endif
+        if( !memory )
+        {
+            throw std::bad_alloc{};
+        }
+
+        auto slab = static_cast< slab_header* >( memory );
+        slab->owner = &owner;
+        slab->prev = nullptr;
+        slab->next = nullptr;
+        slab->free_blocks = nullptr;
+        slab->unused = static_cast< char* >( memory ) + sizeof( slab_header );
+        slab->end = static_cast< char* >( memory ) + m_slab_size;
+        slab->size_class = size_class;
+        slab->used = 0;
+
+        ++owner.slabs_count;
+        return slab;
+    }
+
+    static void free_slab( slab_header* slab ) noexcept
+    {
+#ifdef _WIN32
+        _aligned_free( slab );
+#else
+        free( slab );
+#endif
+    }
+
+    void trim_arenas( const bool all ) noexcept
+    {
+        for( size_t arena_num = 0; arena_num < arenas_count(); ++arena_num )
+        {
+            auto& owner = *m_arenas[ arena_num ].load( std::memory_order_acquire );
+            std::lock_guard< std::mutex > l{ owner.mutex };
+
+            for( auto slab : owner.available )
+            {
+                while( slab )
+                {
+                    auto next = slab->next;
+                    if( all || !slab->used )
+                    {
+                        unlink( owner, slab );
+                        free_slab( slab );
+                        --owner.slabs_count;
+                    }
+
+                    slab = next;
+                }
+            }
+        }
+    }
+
+    static void link( arena& owner, slab_header* slab ) noexcept
+    {
+        auto& head = owner.available[ slab->size_class ];
+        slab->prev = nullptr;
+        slab->next = head;
+        if( head )
+        {
+            head->prev = slab;
+        }
+
+        head = slab;
+    }
+
+    static void unlink( arena& owner, slab_header* slab ) noexcept
+    {
+        if( slab->prev )
+        {
+            slab->prev->next = slab->next;
+        }
+        else
+        {
+            owner.available[ slab->size_class ] = slab->next;
+        }
+
+        if( slab->next )
+        {
+            slab->next->prev = slab->prev;
+        }
+
+        slab->prev = nullptr;
+        slab->next = nullptr;
+    }
+
+private:
+    size_t m_slab_size;
+    // filled up to m_arenas_count, allocate() reads them without locking
+    std::array< std::atomic< arena* >, max_arenas > m_arenas{};
+    std::atomic< size_t > m_arenas_count{ 0 };
+    std::mutex m_arenas_mutex;
+};
+
+// Standard allocator on top of a shared memory_pool, single objects come from the pool,
+// arrays from the global heap. Every allocated object keeps the pool alive
+template< typename T >
+class pool_allocator
+{
+    template< typename U >
+    friend class pool_allocator;
+
+public:
+    using value_type = T;
+
+public:
+    explicit pool_allocator( std::shared_ptr< memory_pool > pool ) noexcept : m_pool( std::move( pool ) ){}
+
+    template< typename U >
+    pool_allocator( const pool_allocator< U >& other ) noexcept : m_pool( other.m_pool ){}
+
+    T* allocate( const size_t count )
+    {
+        static_assert( alignof( T ) <= memory_pool::granularity, "Pooled types must not be over-aligned" );
+
+        if( count == 1 && m_pool )
+        {
+            return static_cast< T* >( m_pool->allocate( sizeof( T ) ) );
+        }
+
+        return static_cast< T* >( ::operator new( count * sizeof( T ) ) );
+    }
+
+    void deallocate( T* pointer, const size_t count ) noexcept
+    {
+        if( count == 1 && m_pool )
+        {
+            m_pool->deallocate( pointer, sizeof( T ) );
+            return;
+        }
+
+        ::operator delete( pointer );
+    }
+
+    template< typename U >
+    bool operator==( const pool_allocator< U >& other ) const noexcept
+    {
+        return m_pool == other.m_pool;
+    }
+
+    template< typename U >
+    bool operator!=( const pool_allocator< U >& other ) const noexcept
+    {
+        return m_pool != other.m_pool;
+    }
+
+private:
+    std::shared_ptr< memory_pool > m_pool;
+};
+
+}
+
+#endif // MEMORY_POOL_H
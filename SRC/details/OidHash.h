@@ -0,0 +1,31 @@
+#ifndef OID_HASH_H
+#define OID_HASH_H
+
+#include <cstring>
+#include <git2.h>
+
+namespace details
+{
+
+// oids are sha1 digests, so any of their bytes is already a good hash
+struct oid_hash
+{
+    size_t operator()( const git_oid& id ) const noexcept
+    {
+        size_t hash;
+        std::memcpy( &hash, id.id, sizeof( hash ) );
+        return hash;
+    }
+};
+
+struct oid_equal
+{
+    bool operator()( const git_oid& left, const git_oid& right ) const noexcept
+    {
+        return std::memcmp( left.id, right.id, sizeof( left.id ) ) == 0;
+    }
+};
+
+}
+
+#endif // OID_HASH_H
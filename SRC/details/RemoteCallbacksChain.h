@@ -0,0 +1,231 @@
+#ifndef REMOTE_CALLBACKS_CHAIN_H
+#define REMOTE_CALLBACKS_CHAIN_H
+
+#include <chrono>
+#include <stdexcept>
+
+#include <git2.h>
+
+#include "GitCancel.h"
+#include "GitFetchStats.h"
+
+namespace details
+{
+
+// Sits between libgit2 and the remote callbacks set by the caller: every call is recorded
+// and then forwarded to the caller's callback with the caller's payload. The chain must
+// outlive the operation its callbacks are installed for. Once the cancel token is set
+// the progress callbacks return GIT_EUSER, which makes libgit2 abort the operation
+class remote_callbacks_chain
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+public:
+    explicit remote_callbacks_chain( const git_remote_callbacks& callbacks,
+                                     git_handler::base::cancel_token cancel = git_handler::base::cancel_token{} ) :
+        m_callbacks( callbacks ),
+        m_cancel( std::move( cancel ) )
+    {
+        // these get the payload too, but a fetch never needs them
+        if( m_callbacks.transport || m_callbacks.remote_ready ||
+            m_callbacks.push_transfer_progress || m_callbacks.push_update_reference || m_callbacks.push_negotiation )
+        {
+            throw std::logic_error{ "Transport and push callbacks are not supported" };
+        }
+    }
+
+    remote_callbacks_chain( const remote_callbacks_chain& ) = delete;
+    remote_callbacks_chain& operator=( const remote_callbacks_chain& ) = delete;
+
+    // the callbacks to hand to libgit2 instead of the caller's ones
+    git_remote_callbacks callbacks() noexcept
+    {
+        git_remote_callbacks callbacks = m_callbacks;
+        callbacks.sideband_progress = &sideband_progress_cb;
+        callbacks.completion = &completion_cb;
+        callbacks.credentials = &credentials_cb;
+        callbacks.certificate_check = &certificate_check_cb;
+        callbacks.transfer_progress = &transfer_progress_cb;
+        callbacks.update_tips = &update_tips_cb;
+        callbacks.pack_progress = &pack_progress_cb;
+        callbacks.payload = this;
+
+        return callbacks;
+    }
+
+    // marks the beginning of the operation, phases are measured from here
+    void start() noexcept
+    {
+        m_start = clock::now();
+        m_first_progress = m_received = m_last_progress = m_first_update = clock::time_point{};
+        m_progress = git_indexer_progress{};
+        m_updated_refs = 0;
+        m_cancelled = false;
+    }
+
+    // whether the operation has been stopped by the cancel token
+    bool cancelled() const noexcept
+    {
+        return m_cancelled;
+    }
+
+    // splits the time since start() into phases and fills in the transfer counters
+    void fill( git_handler::base::remote_fetch_stats& stats ) const noexcept
+    {
+        const auto end = clock::now();
+        const clock::time_point none{};
+
+        // without any pack data the whole download is negotiation
+        auto download_end = end;
+        if( m_last_progress != none )
+        {
+            download_end = m_last_progress;
+        }
+        else if( m_first_update != none )
+        {
+            download_end = m_first_update;
+        }
+
+        stats.duration = end - m_start;
+        stats.negotiation = ( m_first_progress != none ? m_first_progress : download_end ) - m_start;
+        stats.transfer = m_first_progress != none ? ( m_received != none ? m_received : download_end ) - m_first_progress
+                                                  : clock::duration{ 0 };
+        stats.indexing = m_received != none ? download_end - m_received : clock::duration{ 0 };
+        stats.update = end - download_end;
+
+        stats.total_objects = m_progress.total_objects;
+        stats.received_objects = m_progress.received_objects;
+        stats.local_objects = m_progress.local_objects;
+        stats.total_deltas = m_progress.total_deltas;
+        stats.received_bytes = m_progress.received_bytes;
+        stats.updated_refs = m_updated_refs;
+    }
+
+private:
+    static remote_callbacks_chain* chain( void* payload ) noexcept
+    {
+        return static_cast< remote_callbacks_chain* >( payload );
+    }
+
+    // checked by every progress callback, a cancelled operation stops at the next one
+    bool stop() noexcept
+    {
+        m_cancelled = m_cancelled || m_cancel.cancelled();
+        return m_cancelled;
+    }
+
+    static int sideband_progress_cb( const char* str, int len, void* payload )
+    {
+        auto self = chain( payload );
+        if( self->stop() )
+        {
+            return GIT_EUSER;
+        }
+
+        return self->m_callbacks.sideband_progress ?
+               self->m_callbacks.sideband_progress( str, len, self->m_callbacks.payload ) : 0;
+    }
+
+    static int completion_cb( git_remote_completion_t type, void* payload )
+    {
+        auto self = chain( payload );
+        return self->m_callbacks.completion ?
+               self->m_callbacks.completion( type, self->m_callbacks.payload ) : 0;
+    }
+
+    static int credentials_cb( git_credential** out, const char* url, const char* username_from_url,
+                               unsigned int allowed_types, void* payload )
+    {
+        // no credentials callback means no credentials
+        auto self = chain( payload );
+        return self->m_callbacks.credentials ?
+               self->m_callbacks.credentials( out, url, username_from_url, allowed_types, self->m_callbacks.payload ) :
+               GIT_PASSTHROUGH;
+    }
+
+    static int certificate_check_cb( git_cert* cert, int valid, const char* host, void* payload )
+    {
+        auto self = chain( payload );
+        return self->m_callbacks.certificate_check ?
+               self->m_callbacks.certificate_check( cert, valid, host, self->m_callbacks.payload ) :
+               GIT_PASSTHROUGH;
+    }
+
+    static int transfer_progress_cb( const git_indexer_progress* progress, void* payload )
+    {
+        auto self = chain( payload );
+        const auto now = clock::now();
+
+        if( self->m_first_progress == clock::time_point{} )
+        {
+            self->m_first_progress = now;
+        }
+
+        if( self->m_received == clock::time_point{} &&
+            progress->total_objects && progress->received_objects == progress->total_objects )
+        {
+            self->m_received = now;
+        }
+
+        self->m_last_progress = now;
+        self->m_progress = *progress;
+
+        if( self->stop() )
+        {
+            return GIT_EUSER;
+        }
+
+        return self->m_callbacks.transfer_progress ?
+               self->m_callbacks.transfer_progress( progress, self->m_callbacks.payload ) : 0;
+    }
+
+    static int update_tips_cb( const char* refname, const git_oid* old_head, const git_oid* head, void* payload )
+    {
+        auto self = chain( payload );
+
+        if( self->m_first_update == clock::time_point{} )
+        {
+            self->m_first_update = clock::now();
+        }
+
+        ++self->m_updated_refs;
+
+        if( self->stop() )
+        {
+            return GIT_EUSER;
+        }
+
+        return self->m_callbacks.update_tips ?
+               self->m_callbacks.update_tips( refname, old_head, head, self->m_callbacks.payload ) : 0;
+    }
+
+    static int pack_progress_cb( int stage, uint32_t current, uint32_t total, void* payload )
+    {
+        auto self = chain( payload );
+        if( self->stop() )
+        {
+            return GIT_EUSER;
+        }
+
+        return self->m_callbacks.pack_progress ?
+               self->m_callbacks.pack_progress( stage, current, total, self->m_callbacks.payload ) : 0;
+    }
+
+private:
+    git_remote_callbacks m_callbacks;
+    git_handler::base::cancel_token m_cancel;
+    bool m_cancelled{ false };
+
+    clock::time_point m_start;
+    clock::time_point m_first_progress;
+    clock::time_point m_received;
+    clock::time_point m_last_progress;
+    clock::time_point m_first_update;
+    git_indexer_progress m_progress{};
+    size_t m_updated_refs{ 0 };
+};
+
+}
+
+#endif // REMOTE_CALLBACKS_CHAIN_H
@@ -0,0 +1,248 @@
+#ifndef TEXT_FORMAT_H
+#define TEXT_FORMAT_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <git2.h>
+
+namespace details
+{
+
+// Formatters writing straight into a caller's buffer, they return the end of the written text
+
+const size_t max_int_length{ 20 };
+const size_t oid_hex_length{ GIT_OID_HEXSZ };
+// "2017-07-14T02:40:00+00:00"
+const size_t iso_time_length{ 25 };
+
+inline char* format_uint( uint64_t value, char* out ) noexcept
+{
+    char digits[ max_int_length ];
+    char* digit = digits + max_int_length;
+
+    do
+    {
+        *--digit = static_cast< char >( '0' + value % 10 );
+        value /= 10;
+    }
+    while( value );
+
+    while( digit != digits + max_int_length )
+    {
+        *out++ = *digit++;
+    }
+
+    return out;
+}
+
+inline char* format_int( const int64_t value, char* out ) noexcept
+{
+    if( value < 0 )
+    {
+        *out++ = '-';
+        return format_uint( 0 - static_cast< uint64_t >( value ), out );
+    }
+
+    return format_uint( static_cast< uint64_t >( value ), out );
+}
+
+inline char* format_oid( const git_oid& id, char* out ) noexcept
+{
+    static const char hex_digits[]{ "0123456789abcdef" };
+
+    for( const unsigned char byte : id.id )
+    {
+        *out++ = hex_digits[ byte >> 4 ];
+        *out++ = hex_digits[ byte & 0x0f ];
+    }
+
+    return out;
+}
+
+inline char* format_two_digits( const unsigned value, char* out ) noexcept
+{
+    *out++ = static_cast< char >( '0' + value / 10 );
+    *out++ = static_cast< char >( '0' + value % 10 );
+    return out;
+}
+
+// ISO 8601 local time of the commit with its utc offset, offset_minutes as in git_time
+inline char* format_iso_time( const int64_t time, const int offset_minutes, char* out ) noexcept
+{
+    const int64_t local{ time + int64_t{ offset_minutes } * 60 };
+
+    int64_t days{ local / 86400 };
+    int64_t seconds{ local % 86400 };
+    if( seconds < 0 )
+    {
+        seconds += 86400;
+        --days;
+    }
+
+    // civil date from the days since the epoch, in 400 year eras starting on March 1st
+    days += 719468;
+    const int64_t era{ ( days >= 0 ? days : days - 146096 ) / 146097 };
+    const unsigned day_of_era{ static_cast< unsigned >( days - era * 146097 ) };
+    const unsigned year_of_era{ ( day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096 ) / 365 };
+    const unsigned day_of_year{ day_of_era - ( 365 * year_of_era + year_of_era / 4 - year_of_era / 100 ) };
+    const unsigned shifted_month{ ( 5 * day_of_year + 2 ) / 153 };
+    const unsigned day{ day_of_year - ( 153 * shifted_month + 2 ) / 5 + 1 };
+    const unsigned month{ shifted_month < 10 ? shifted_month + 3 : shifted_month - 9 };
+    const int64_t year{ static_cast< int64_t >( year_of_era ) + era * 400 + ( month <= 2 ? 1 : 0 ) };
+
+    // years outside of 0-9999 can't be written in 4 digits, they are clamped
+    const unsigned clamped_year{ static_cast< unsigned >( year < 0 ? 0 : year > 9999 ? 9999 : year ) };
+
+    out = format_two_digits( clamped_year / 100, out );
+    out = format_two_digits( clamped_year % 100, out );
+    *out++ = '-';
+    out = format_two_digits( month, out );
+    *out++ = '-';
+    out = format_two_digits( day, out );
+    *out++ = 'T';
+    out = format_two_digits( static_cast< unsigned >( seconds / 3600 ), out );
+    *out++ = ':';
+    out = format_two_digits( static_cast< unsigned >( seconds / 60 % 60 ), out );
+    *out++ = ':';
+    out = format_two_digits( static_cast< unsigned >( seconds % 60 ), out );
+
+    const unsigned offset{ static_cast< unsigned >( std::abs( offset_minutes ) ) % ( 100 * 60 ) };
+    *out++ = offset_minutes < 0 ? '-' : '+';
+    out = format_two_digits( offset / 60, out );
+    *out++ = ':';
+    out = format_two_digits( offset % 60, out );
+
+    return out;
+}
+
+// the longest JSON escape of a single byte, \u00XX
+const size_t max_json_escape_length{ 6 };
+
+// Escapes a byte for a JSON string: controls and bytes that aren't part of a valid UTF-8
+// sequence are written as \u00XX, their Latin-1 reading, so that no byte of a message in
+// another encoding is lost. Other bytes are written as they are
+inline char* escape_json_char( const unsigned char c, char* out ) noexcept
+{
+    static const char hex_digits[]{ "0123456789abcdef" };
+
+    switch( c )
+    {
+    case '"':  *out++ = '\\'; *out++ = '"';  break;
+    case '\\': *out++ = '\\'; *out++ = '\\'; break;
+    case '\n': *out++ = '\\'; *out++ = 'n';  break;
+    case '\r': *out++ = '\\'; *out++ = 'r';  break;
+    case '\t': *out++ = '\\'; *out++ = 't';  break;
+    case '\b': *out++ = '\\'; *out++ = 'b';  break;
+    case '\f': *out++ = '\\'; *out++ = 'f';  break;
+    default:
+        if( c < 0x20 || c >= 0x80 )
+        {
+            *out++ = '\\';
+            *out++ = 'u';
+            *out++ = '0';
+            *out++ = '0';
+            *out++ = hex_digits[ c >> 4 ];
+            *out++ = hex_digits[ c & 0x0f ];
+        }
+        else
+        {
+            *out++ = static_cast< char >( c );
+        }
+    }
+
+    return out;
+}
+
+// Length of the well-formed UTF-8 sequence at in, 0 if the bytes there aren't one:
+// overlong forms, surrogates and code points above U+10FFFF are rejected
+inline size_t utf8_sequence_length( const char* in, const char* in_end ) noexcept
+{
+    const unsigned char lead{ static_cast< unsigned char >( *in ) };
+    unsigned char second_min{ 0x80 };
+    unsigned char second_max{ 0xbf };
+    size_t length{ 0 };
+
+    if( lead < 0x80 )
+    {
+        return 1;
+    }
+    else if( lead >= 0xc2 && lead <= 0xdf )
+    {
+        length = 2;
+    }
+    else if( lead >= 0xe0 && lead <= 0xef )
+    {
+        length = 3;
+        second_min = lead == 0xe0 ? 0xa0 : second_min;
+        second_max = lead == 0xed ? 0x9f : second_max;
+    }
+    else if( lead >= 0xf0 && lead <= 0xf4 )
+    {
+        length = 4;
+        second_min = lead == 0xf0 ? 0x90 : second_min;
+        second_max = lead == 0xf4 ? 0x8f : second_max;
+    }
+    else
+    {
+        return 0;
+    }
+
+    if( static_cast< size_t >( in_end - in ) < length )
+    {
+        return 0;
+    }
+
+    const unsigned char second{ static_cast< unsigned char >( in[ 1 ] ) };
+    if( second < second_min || second > second_max )
+    {
+        return 0;
+    }
+
+    for( size_t byte_num = 2; byte_num < length; ++byte_num )
+    {
+        if( ( static_cast< unsigned char >( in[ byte_num ] ) & 0xc0 ) != 0x80 )
+        {
+            return 0;
+        }
+    }
+
+    return length;
+}
+
+inline bool needs_json_escape( const unsigned char c ) noexcept
+{
+    return c < 0x20 || c == '"' || c == '\\';
+}
+
+// Escapes the bytes from in while they fit before out_end, leaving max_json_escape_length bytes
+// of slack after it. Returns the end of the written text, in is moved past the escaped bytes.
+// The text written is valid UTF-8 whatever the input
+inline char* escape_json( const char*& in, const char* in_end, char* out, const char* out_end ) noexcept
+{
+    while( in != in_end && out < out_end )
+    {
+        const unsigned char c{ static_cast< unsigned char >( *in ) };
+
+        // valid sequences are copied whole, strict parsers would reject invalid bytes
+        const size_t length{ c < 0x80 ? 1 : utf8_sequence_length( in, in_end ) };
+        if( length && !needs_json_escape( c ) )
+        {
+            std::memcpy( out, in, length );
+            in += length;
+            out += length;
+        }
+        else
+        {
+            out = escape_json_char( c, out );
+            ++in;
+        }
+    }
+
+    return out;
+}
+
+}
+
+#endif // TEXT_FORMAT_H
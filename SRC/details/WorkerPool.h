@@ -0,0 +1,65 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <system_error>
+
+namespace details
+{
+
+// Calls func( index, worker_num ) for every index in [ 0, count ) using up to workers_count threads,
+// the calling thread being worker 0. func must not throw. Threads that can't be started are left
+// out, the work is then shared by the ones running, at worst done by the calling thread alone
+template< typename Func >
+void parallel_for( const size_t count, size_t workers_count, Func&& func )
+{
+    workers_count = std::max< size_t >( 1, std::min( workers_count, count ) );
+
+    if( workers_count == 1 )
+    {
+        for( size_t index = 0; index < count; ++index )
+        {
+            func( index, 0 );
+        }
+
+        return;
+    }
+
+    std::atomic< size_t > next_index{ 0 };
+    auto worker = [ & ]( const size_t worker_num )
+    {
+        for( size_t index = next_index++; index < count; index = next_index++ )
+        {
+            func( index, worker_num );
+        }
+    };
+
+    std::vector< std::thread > threads;
+    threads.reserve( workers_count - 1 );
+
+    for( size_t worker_num = 1; worker_num < workers_count; ++worker_num )
+    {
+        try
+        {
+            threads.emplace_back( worker, worker_num );
+        }
+        catch( const std::system_error& )
+        {
+            break;
+        }
+    }
+
+    worker( 0 );
+
+    for( auto& thread : threads )
+    {
+        thread.join();
+    }
+}
+
+}
+
+#endif // WORKER_POOL_H
@@ -0,0 +1,251 @@
+#include <map>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <fstream>
+#include <functional>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#include "Benchmark.h"
+#include "GitBaseClasses.h"
+#include "Common/RepoGenerator.h"
+
+using namespace git_handler;
+
+namespace
+{
+
+std::atomic< size_t > allocations_count{ 0 };
+
+struct allocations
+{
+    size_t start{ allocations_count.load() };
+    size_t count() const noexcept { return allocations_count.load() - start; }
+};
+
+std::vector< std::pair< git_oid, git_time_t > > make_ids( const size_t commits_count )
+{
+    std::mt19937_64 random{ 42 };
+    std::vector< std::pair< git_oid, git_time_t > > ids( commits_count );
+    git_time_t time{ 1500000000 };
+
+    for( auto& id : ids )
+    {
+        uint64_t values[ 3 ]{ random(), random(), random() };
+        std::memcpy( id.first.id, values, sizeof( id.first.id ) );
+        id.second = time--;
+    }
+
+    return ids;
+}
+
+// resident set size in KB, 0 where it can't be read
+size_t resident_kb()
+{
+#ifdef __linux__
+    std::ifstream statm{ "/proc/self/statm" };
+    size_t total_pages{ 0 };
+    size_t resident_pages{ 0 };
+    statm >> total_pages >> resident_pages;
+
+    return resident_pages * static_cast< size_t >( sysconf( _SC_PAGESIZE ) ) / 1024;
+#else
+    return 0;
+#endif
+}
+
+}
+
+// Every allocation in the process is counted, the benchmarks only report the difference
+void* operator new( size_t size )
+{
+    ++allocations_count;
+
+    void* pointer = std::malloc( size ? size : 1 );
+    if( !pointer )
+    {
+        throw std::bad_alloc{};
+    }
+
+    return pointer;
+}
+
+void operator delete( void* pointer ) noexcept
+{
+    std::free( pointer );
+}
+
+void operator delete( void* pointer, size_t ) noexcept
+{
+    std::free( pointer );
+}
+
+// Materializing and dropping a history: a heap item, a shared wrapper, a store node and a map node
+// with its key per commit, against pooled wrappers, pooled store nodes and a contiguous storage
+GIT_HANDLER_BENCHMARK( history_allocations )
+{
+    const size_t commits_count{ state.param( "commits", 1000000 ) };
+    const std::string message( 80, 'm' );
+
+    auto ids = make_ids( commits_count );
+
+    {
+        allocations counter;
+        std::unordered_map< git_oid, std::weak_ptr< base::commit_wrapper >, details::oid_hash, details::oid_equal > store;
+        std::map< std::pair< git_time_t, std::string >, std::shared_ptr< base::commit_wrapper > > commits;
+
+        auto ns = bench::clock::now();
+        for( const auto& id : ids )
+        {
+            auto commit = std::make_shared< base::commit_wrapper >( std::make_unique< base::git_item_commit >( nullptr ) );
+            store.emplace( id.first, commit );
+            commits.emplace( std::make_pair( id.second, message ), std::move( commit ) );
+        }
+
+        commits.clear();
+        store.clear();
+
+        state.report( "heap", { { "ns", std::chrono::duration_cast< std::chrono::nanoseconds >( bench::clock::now() - ns ).count() },
+                                { "items", commits_count },
+                                { "allocations", counter.count() } } );
+    }
+
+    {
+        allocations counter;
+        auto pool = std::make_shared< details::memory_pool >();
+        details::pool_allocator< base::commit_wrapper > allocator{ pool };
+
+        std::unordered_map< git_oid,
+                            std::weak_ptr< base::commit_wrapper >,
+                            details::oid_hash,
+                            details::oid_equal,
+                            details::pool_allocator< std::pair< const git_oid, std::weak_ptr< base::commit_wrapper > > > >
+                store( 0, details::oid_hash{}, details::oid_equal{}, allocator );
+
+        base::commit_storage commits;
+        base::commit_storage::entries batch;
+        batch.reserve( commits_count );
+
+        auto ns = bench::clock::now();
+        for( const auto& id : ids )
+        {
+            auto commit = std::allocate_shared< base::commit_wrapper >( allocator, base::git_item_commit{ nullptr } );
+            store.emplace( id.first, commit );
+            batch.push_back( { id.second, id.first, std::move( commit ) } );
+        }
+
+        commits.add( std::move( batch ) );
+        commits.clear();
+        store.clear();
+
+        state.report( "pool", { { "ns", std::chrono::duration_cast< std::chrono::nanoseconds >( bench::clock::now() - ns ).count() },
+                                { "items", commits_count },
+                                { "allocations", counter.count() },
+                                { "slabs", pool->slabs_count() } } );
+    }
+}
+
+// Threads allocating and freeing wrapper sized blocks at once, the way parallel loaders do:
+// the global heap, a pool with a single arena, which every thread locks, and a pool with an arena
+// per thread. Params: threads, blocks ( per thread )
+GIT_HANDLER_BENCHMARK( pool_contention )
+{
+    const size_t threads_count{ state.param( "threads", std::max( 4u, std::thread::hardware_concurrency() ) ) };
+    const size_t blocks_count{ state.param( "blocks", 1000000 ) };
+    const size_t block_size{ sizeof( base::commit_wrapper ) };
+
+    auto run = [ & ]( const std::function< void*() >& allocate, const std::function< void( void* ) >& deallocate )
+               {
+                   std::vector< std::thread > threads;
+                   for( size_t thread_num = 0; thread_num < threads_count; ++thread_num )
+                   {
+                       threads.emplace_back( [ & ]()
+                                             {
+                                                 // batches keep some blocks alive, like a loader filling a branch
+                                                 std::vector< void* > batch( 64 );
+                                                 for( size_t block_num = 0; block_num < blocks_count; block_num += batch.size() )
+                                                 {
+                                                     for( auto& block : batch )
+                                                     {
+                                                         block = allocate();
+                                                     }
+
+                                                     for( auto block : batch )
+                                                     {
+                                                         deallocate( block );
+                                                     }
+                                                 }
+                                             } );
+                   }
+
+                   for( auto& thread : threads )
+                   {
+                       thread.join();
+                   }
+               };
+
+    const size_t items{ threads_count * blocks_count };
+
+    state.measure( "heap", items,
+                   [ & ](){ run( [ & ](){ return ::operator new( block_size ); }, []( void* block ){ ::operator delete( block ); } ); } );
+
+    details::memory_pool single{ 256 * 1024, 1 };
+    state.measure( "pool_single_arena", items,
+                   [ & ](){ run( [ & ](){ return single.allocate( block_size ); }, [ & ]( void* block ){ single.deallocate( block, block_size ); } ); } );
+
+    details::memory_pool arenas{ 256 * 1024, threads_count };
+    state.measure( "pool_arenas", items,
+                   [ & ](){ run( [ & ](){ return arenas.allocate( block_size ); }, [ & ]( void* block ){ arenas.deallocate( block, block_size ); } ); } );
+
+    state.report( "pool_contention_result", { { "threads", threads_count },
+                                              { "single_arena_slabs", single.slabs_count() },
+                                              { "arenas_slabs", arenas.slabs_count() } } );
+}
+
+// Reading the branches of a repo and dropping them over and over, the way a long running service
+// does: the allocations of every load and the resident memory once loaded, once the branch storage
+// is dropped and once the repo has released the memory.
+// Params: commits, branches, workers, loads
+GIT_HANDLER_BENCHMARK( history_reloads )
+{
+    test::repo_shape shape;
+    shape.commits = state.param( "commits", 20000 );
+    shape.branches = state.param( "branches", 8 );
+
+    const size_t workers{ state.param( "workers", 4 ) };
+    const size_t loads{ state.param( "loads", 5 ) };
+
+    test::temp_path dir{ "git_handler_bench" };
+    test::repo_generator source{ dir.sub( "source.git" ), shape };
+
+    auto repo = std::make_shared< base::repo_wrapper >();
+    repo->open_local( source.path() );
+
+    const size_t start_kb{ resident_kb() };
+
+    for( size_t load_num = 0; load_num < loads; ++load_num )
+    {
+        allocations counter;
+
+        base::repo_wrapper::branches branches;
+        repo->get_branches( branches, false, workers );
+        const size_t loaded_kb{ resident_kb() };
+
+        branches.clear();
+        const size_t dropped_kb{ resident_kb() };
+
+        repo->release_memory();
+
+        state.report( "load_" + std::to_string( load_num ), { { "allocations", counter.count() },
+                                                               { "start_kb", start_kb },
+                                                               { "loaded_kb", loaded_kb },
+                                                               { "dropped_kb", dropped_kb },
+                                                               { "released_kb", resident_kb() } } );
+    }
+}
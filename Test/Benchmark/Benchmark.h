@@ -0,0 +1,79 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <map>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace bench
+{
+
+using clock = std::chrono::steady_clock;
+using metrics = std::vector< std::pair< std::string, double > >;
+using params = std::map< std::string, std::string >;
+
+// Handed to every benchmark, gives access to the command line params
+// and prints the results as JSON lines to stdout
+class state
+{
+public:
+    state( std::string name, const params& benchmark_params );
+
+    size_t param( const std::string& name, const size_t default_value ) const;
+    std::string text_param( const std::string& name, const std::string& default_value ) const;
+
+    // runs func once and reports its duration in ns along with the number of processed items
+    template< typename Func >
+    uint64_t measure( const std::string& case_name, const size_t items, Func&& func )
+    {
+        auto start = clock::now();
+        func();
+        uint64_t ns = std::chrono::duration_cast< std::chrono::nanoseconds >( clock::now() - start ).count();
+
+        report( case_name, { { "ns", ns },
+                             { "items", items },
+                             { "ns_per_item", items ? double( ns ) / items : 0. } } );
+        return ns;
+    }
+
+    void report( const std::string& case_name, const metrics& values ) const;
+
+private:
+    std::string m_name;
+    const params& m_params;
+};
+
+using benchmark_func = void( * )( state& );
+using benchmarks = std::vector< std::pair< std::string, benchmark_func > >;
+
+inline benchmarks& registered_benchmarks()
+{
+    static benchmarks instance;
+    return instance;
+}
+
+struct registrar
+{
+    registrar( const char* name, benchmark_func func )
+    {
+        registered_benchmarks().emplace_back( name, func );
+    }
+};
+
+// keeps the optimizer from dropping computations whose result is otherwise unused
+template< typename T >
+void keep( const T& value )
+{
+    asm volatile( "" : : "g"( &value ) : "memory" );
+}
+
+}
+
+#define GIT_HANDLER_BENCHMARK( name ) \
+    static void name##_benchmark( bench::state& ); \
+    static bench::registrar name##_registrar{ #name, &name##_benchmark }; \
+    static void name##_benchmark( bench::state& state )
+
+#endif // BENCHMARK_H
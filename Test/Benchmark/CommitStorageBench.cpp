@@ -0,0 +1,176 @@
+#include <map>
+#include <random>
+#include <cstring>
+#include <algorithm>
+
+#include "Benchmark.h"
+#include "GitCommitStorage.h"
+
+using namespace git_handler;
+
+namespace
+{
+
+struct synthetic_commit
+{
+    git_oid id;
+    git_time_t time;
+    std::string message;
+};
+
+// revwalk-like order: newest first, with several commits sharing a second now and then
+std::vector< synthetic_commit > make_history( const size_t commits_count )
+{
+    std::mt19937_64 random{ 42 };
+    std::uniform_int_distribution< int > step{ 0, 600 };
+    std::uniform_int_distribution< size_t > length{ 40, 120 };
+    std::uniform_int_distribution< int > letter{ 'a', 'z' };
+
+    std::vector< synthetic_commit > history( commits_count );
+    git_time_t time{ 1500000000 };
+
+    for( auto& commit : history )
+    {
+        for( size_t byte = 0; byte < sizeof( commit.id.id ); byte += sizeof( uint64_t ) )
+        {
+            uint64_t value = random();
+            std::memcpy( commit.id.id + byte, &value, std::min( sizeof( value ), sizeof( commit.id.id ) - byte ) );
+        }
+
+        time -= step( random );
+        commit.time = time;
+        commit.message.resize( length( random ) );
+
+        for( auto& c : commit.message )
+        {
+            c = static_cast< char >( letter( random ) );
+        }
+    }
+
+    return history;
+}
+
+}
+
+// The former std::map< ( time, message ), commit > layout against base::commit_storage
+GIT_HANDLER_BENCHMARK( commit_storage )
+{
+    using legacy_storage = std::map< std::pair< git_time_t, std::string >, std::shared_ptr< base::commit_wrapper > >;
+
+    const size_t commits_count{ state.param( "commits", 1000000 ) };
+    const size_t lookups_count{ state.param( "lookups", 100000 ) };
+    const git_time_t range_length{ 24 * 60 * 60 };
+
+    auto history = make_history( commits_count );
+
+    std::mt19937_64 random{ 7 };
+    std::uniform_int_distribution< size_t > pick{ 0, commits_count - 1 };
+
+    std::vector< size_t > picked( lookups_count );
+    for( auto& commit_num : picked )
+    {
+        commit_num = pick( random );
+    }
+
+    legacy_storage legacy;
+    state.measure( "map.insert", commits_count, [ & ]()
+    {
+        for( const auto& commit : history )
+        {
+            legacy_storage::key_type id( commit.time, commit.message );
+            if( !legacy.count( id ) )
+            {
+                legacy.emplace( id, nullptr );
+            }
+        }
+    } );
+
+    base::commit_storage storage;
+    state.measure( "storage.insert", commits_count, [ & ]()
+    {
+        base::commit_storage::entries batch;
+        batch.reserve( history.size() );
+
+        for( const auto& commit : history )
+        {
+            batch.push_back( { commit.time, commit.id, nullptr } );
+        }
+
+        storage.add( std::move( batch ) );
+    } );
+
+    state.measure( "map.iterate", legacy.size(), [ & ]()
+    {
+        git_time_t sum{ 0 };
+        for( const auto& commit : legacy )
+        {
+            sum += commit.first.first;
+        }
+
+        bench::keep( sum );
+    } );
+
+    state.measure( "storage.iterate", storage.size(), [ & ]()
+    {
+        git_time_t sum{ 0 };
+        for( const auto& commit : storage )
+        {
+            sum += commit.time;
+        }
+
+        bench::keep( sum );
+    } );
+
+    // the map can only be searched by its ( time, message ) key
+    state.measure( "map.lookup", lookups_count, [ & ]()
+    {
+        size_t found{ 0 };
+        for( auto commit_num : picked )
+        {
+            const auto& commit = history[ commit_num ];
+            found += legacy.count( legacy_storage::key_type( commit.time, commit.message ) );
+        }
+
+        bench::keep( found );
+    } );
+
+    state.measure( "storage.lookup", lookups_count, [ & ]()
+    {
+        size_t found{ 0 };
+        for( auto commit_num : picked )
+        {
+            found += storage.find( history[ commit_num ].id ) != nullptr;
+        }
+
+        bench::keep( found );
+    } );
+
+    state.measure( "map.time_range", lookups_count, [ & ]()
+    {
+        size_t found{ 0 };
+        for( auto commit_num : picked )
+        {
+            const git_time_t from{ history[ commit_num ].time };
+            auto first = legacy.lower_bound( { from, std::string{} } );
+            auto last = legacy.lower_bound( { from + range_length + 1, std::string{} } );
+            found += std::distance( first, last );
+        }
+
+        bench::keep( found );
+    } );
+
+    state.measure( "storage.time_range", lookups_count, [ & ]()
+    {
+        size_t found{ 0 };
+        for( auto commit_num : picked )
+        {
+            const git_time_t from{ history[ commit_num ].time };
+            auto range = storage.time_range( from, from + range_length );
+            found += std::distance( range.first, range.second );
+        }
+
+        bench::keep( found );
+    } );
+
+    state.report( "stored", { { "map", legacy.size() }, { "storage", storage.size() } } );
+}
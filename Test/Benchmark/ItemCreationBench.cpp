@@ -0,0 +1,168 @@
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "Benchmark.h"
+#include "GitItem.h"
+
+using namespace git_handler;
+
+namespace
+{
+
+// The items used to derive from a virtual base and store a function pointer deleter
+class legacy_item
+{
+public:
+    virtual ~legacy_item() = default;
+};
+
+template< class LibGitItemType >
+class legacy_git_item : public legacy_item, public std::unique_ptr< LibGitItemType, void( * )( LibGitItemType* ) >
+{
+public:
+    using _internalType = LibGitItemType;
+
+public:
+    legacy_git_item() noexcept :
+        std::unique_ptr< LibGitItemType, void( * )( LibGitItemType* ) >( nullptr, deleters::delete_item< LibGitItemType > ){}
+};
+
+// The runtime factory git_item_creator used to be: a global mutex, a map lookup,
+// a virtual create() and a dynamic cast for every created item
+class legacy_item_factory
+{
+public:
+    virtual ~legacy_item_factory() = default;
+    virtual std::unique_ptr< legacy_item > create() const = 0;
+};
+
+template< class LibGitItemType >
+class legacy_git_item_factory : public legacy_item_factory
+{
+public:
+    std::unique_ptr< legacy_item > create() const override
+    {
+        return std::make_unique< legacy_git_item< LibGitItemType > >();
+    }
+};
+
+class legacy_item_creator
+{
+public:
+    legacy_item_creator()
+    {
+        m_factories.emplace( 0, std::make_unique< legacy_git_item_factory< git_repository > >() );
+        m_factories.emplace( 1, std::make_unique< legacy_git_item_factory< git_remote > >() );
+        m_factories.emplace( 2, std::make_unique< legacy_git_item_factory< git_commit > >() );
+        m_factories.emplace( 3, std::make_unique< legacy_git_item_factory< git_reference > >() );
+        m_factories.emplace( 4, std::make_unique< legacy_git_item_factory< git_strarray > >() );
+        m_factories.emplace( 5, std::make_unique< legacy_git_item_factory< git_revwalk > >() );
+    }
+
+    template< class GitItemType >
+    std::unique_ptr< GitItemType > create( const int item_type, typename GitItemType::_internalType* manage )
+    {
+        std::lock_guard< std::mutex > l{ m_mutex };
+
+        auto factory = m_factories.find( item_type );
+        if( factory == m_factories.end() )
+        {
+            return nullptr;
+        }
+
+        auto created = factory->second->create();
+        auto result = dynamic_cast< GitItemType* >( created.get() );
+        if( !result )
+        {
+            return nullptr;
+        }
+
+        created.release();
+        std::unique_ptr< GitItemType > item{ result };
+        item->reset( manage );
+        return item;
+    }
+
+private:
+    std::map< int, std::unique_ptr< legacy_item_factory > > m_factories;
+    std::mutex m_mutex;
+};
+
+template< typename Func >
+void run_threads( const size_t threads_count, Func&& func )
+{
+    std::vector< std::thread > threads;
+    for( size_t thread_num = 0; thread_num < threads_count; ++thread_num )
+    {
+        threads.emplace_back( func );
+    }
+
+    for( auto& thread : threads )
+    {
+        thread.join();
+    }
+}
+
+}
+
+// Handle creation throughput of the former runtime factory against item::make_item
+GIT_HANDLER_BENCHMARK( item_creation )
+{
+    using legacy_commit_item = legacy_git_item< git_commit >;
+    using commit_item = item::git_item< git_commit >;
+
+    const size_t items_count{ state.param( "items", 5000000 ) };
+    const size_t threads_count{ state.param( "threads", std::max( 2u, std::thread::hardware_concurrency() ) ) };
+
+    legacy_item_creator creator;
+
+    state.measure( "factory", items_count, [ & ]()
+    {
+        for( size_t item_num = 0; item_num < items_count; ++item_num )
+        {
+            bench::keep( creator.create< legacy_commit_item >( 2, nullptr ) );
+        }
+    } );
+
+    state.measure( "make_item", items_count, [ & ]()
+    {
+        for( size_t item_num = 0; item_num < items_count; ++item_num )
+        {
+            bench::keep( item::make_item< commit_item >( nullptr ) );
+        }
+    } );
+
+    state.measure( "by_value", items_count, [ & ]()
+    {
+        for( size_t item_num = 0; item_num < items_count; ++item_num )
+        {
+            commit_item commit{ nullptr };
+            bench::keep( commit );
+        }
+    } );
+
+    const size_t per_thread{ items_count / threads_count };
+
+    state.measure( "factory.threads_" + std::to_string( threads_count ), per_thread * threads_count, [ & ]()
+    {
+        run_threads( threads_count, [ & ]()
+        {
+            for( size_t item_num = 0; item_num < per_thread; ++item_num )
+            {
+                bench::keep( creator.create< legacy_commit_item >( 2, nullptr ) );
+            }
+        } );
+    } );
+
+    state.measure( "make_item.threads_" + std::to_string( threads_count ), per_thread * threads_count, [ & ]()
+    {
+        run_threads( threads_count, [ & ]()
+        {
+            for( size_t item_num = 0; item_num < per_thread; ++item_num )
+            {
+                bench::keep( item::make_item< commit_item >( nullptr ) );
+            }
+        } );
+    } );
+}
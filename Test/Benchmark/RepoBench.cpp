@@ -0,0 +1,677 @@
+#include <limits>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "Benchmark.h"
+#include "GitExport.h"
+#include "Common/RepoGenerator.h"
+
+using namespace git_handler;
+
+namespace
+{
+
+test::repo_shape read_shape( const bench::state& state )
+{
+    test::repo_shape shape;
+    shape.commits = state.param( "commits", 20000 );
+    shape.branches = state.param( "branches", 8 );
+    shape.merge_density = state.param( "merge_percent", 10 ) / 100.;
+    shape.message_size = state.param( "message_size", 256 );
+    shape.authors = state.param( "authors", 64 );
+    shape.seed = static_cast< uint32_t >( state.param( "seed", 42 ) );
+
+    return shape;
+}
+
+size_t commits_count( const base::repo_wrapper::branches& branches )
+{
+    size_t count{ 0 };
+    for( const auto& branch : branches )
+    {
+        count += branch.second->commits().size();
+    }
+
+    return count;
+}
+
+}
+
+// The repo_wrapper operations against a generated repository served as a file:// remote.
+// Params: commits, branches, merge_percent, message_size, authors, seed, workers, fetch_commits, dir
+GIT_HANDLER_BENCHMARK( repo_operations )
+{
+    const size_t workers{ state.param( "workers", std::max( 2u, std::thread::hardware_concurrency() ) ) };
+    const size_t fetch_commits{ state.param( "fetch_commits", 1000 ) };
+    const auto shape = read_shape( state );
+
+    test::temp_path dir{ "git_handler_bench" };
+    const std::string root{ state.text_param( "dir", dir.str() ) };
+    const std::string source_path{ root + "/source.git" };
+    const std::string clone_path{ root + "/clone" };
+
+    std::unique_ptr< test::repo_generator > source;
+    state.measure( "generate", shape.commits, [ & ](){ source = std::make_unique< test::repo_generator >( source_path, shape ); } );
+
+    {
+        auto repo = std::make_shared< base::repo_wrapper >();
+        state.measure( "clone", shape.commits, [ & ](){ repo->clone( source->url(), clone_path ); } );
+    }
+
+    // every reading case gets a fresh repo, so that nothing is shared through the commit store
+    {
+        auto repo = std::make_shared< base::repo_wrapper >();
+        repo->open_local( source_path );
+
+        base::repo_wrapper::branches branches;
+        state.measure( "get_branches", shape.commits, [ & ](){ repo->get_branches( branches ); } );
+        state.report( "get_branches_result", { { "branches", branches.size() }, { "commits", commits_count( branches ) } } );
+
+        state.measure( "get_branches_unchanged", branches.size(), [ & ](){ repo->get_branches( branches ); } );
+
+        repo->use_commit_metadata( root + "/metadata" );
+        state.measure( "save_commit_metadata", shape.commits, [ & ](){ repo->save_commit_metadata( branches ); } );
+    }
+
+    // a restart: the branches come from the saved metadata instead of a history traversal
+    {
+        auto repo = std::make_shared< base::repo_wrapper >();
+        repo->open_local( source_path );
+
+        base::repo_wrapper::branches branches;
+        state.measure( "get_branches_from_metadata", shape.commits,
+                       [ & ]()
+                       {
+                           repo->use_commit_metadata( root + "/metadata" );
+                           repo->get_branches( branches );
+                       } );
+    }
+
+    {
+        auto repo = std::make_shared< base::repo_wrapper >();
+        repo->open_local( source_path );
+
+        base::repo_wrapper::branches branches;
+        state.measure( "get_branches_parallel_" + std::to_string( workers ), shape.commits,
+                       [ & ](){ repo->get_branches( branches, false, workers ); } );
+    }
+
+    {
+        auto repo = std::make_shared< base::repo_wrapper >();
+        repo->open_local( source_path );
+
+        std::unique_ptr< base::branch_wrapper > branch;
+        state.measure( "get_branch", 1, [ & ](){ branch = repo->get_branch( test::repo_generator::master_ref, false ); } );
+
+        // refreshing a branch that hasn't been read yet reads its whole history
+        state.measure( "read_branch_commits", shape.commits, [ & ](){ repo->refresh_branch( branch.get() ); } );
+        state.report( "read_branch_commits_result", { { "commits", branch->commits().size() } } );
+
+        // reading every message and author, copied and through the views
+        size_t copied_bytes{ 0 }, viewed_bytes{ 0 };
+        state.measure( "message_copies", branch->commits().size(),
+                       [ & ]()
+                       {
+                           for( const auto& commit : branch->commits() )
+                           {
+                               copied_bytes += commit.commit->message().size() + commit.commit->author().size();
+                           }
+                       } );
+
+        state.measure( "message_views", branch->commits().size(),
+                       [ & ]()
+                       {
+                           for( const auto& commit : branch->commits() )
+                           {
+                               viewed_bytes += commit.commit->message_view().size() + commit.commit->author_view().size();
+                           }
+                       } );
+
+        state.report( "message_result", { { "copied_bytes", copied_bytes }, { "viewed_bytes", viewed_bytes } } );
+    }
+
+    {
+        auto repo = std::make_shared< base::repo_wrapper >();
+        repo->open_local( clone_path );
+
+        base::repo_wrapper::branches branches;
+        repo->get_branches( branches, true );
+
+        source->add_commits( fetch_commits );
+
+        state.measure( "fetch", fetch_commits, [ & ](){ repo->fetch(); } );
+
+        for( const auto& remote : repo->last_fetch_stats().remotes )
+        {
+            state.report( "fetch_phases_" + remote.remote, { { "negotiation_ns", remote.negotiation.count() },
+                                                             { "transfer_ns", remote.transfer.count() },
+                                                             { "indexing_ns", remote.indexing.count() },
+                                                             { "update_ns", remote.update.count() },
+                                                             { "received_objects", remote.received_objects },
+                                                             { "received_bytes", remote.received_bytes },
+                                                             { "updated_refs", remote.updated_refs } } );
+        }
+
+        state.measure( "get_branches_after_fetch", fetch_commits, [ & ](){ repo->get_branches( branches, true ); } );
+        state.report( "fetch_result", { { "branches", branches.size() }, { "commits", commits_count( branches ) } } );
+
+        // refresh fetches of a remote that hasn't changed, with and without the advertisement check
+        state.measure( "fetch_unchanged", 1, [ & ](){ repo->fetch(); } );
+
+        repo->set_skip_unchanged_fetches( true );
+        state.measure( "fetch_unchanged_skipped", 1, [ & ](){ repo->fetch(); } );
+        state.report( "fetch_unchanged_skipped_result", { { "skipped_remotes", repo->last_fetch_stats().skipped_remotes() } } );
+    }
+}
+
+// Branch enumeration in a repo with many other refs, against listing every ref and looking each one up.
+// Params: the repo shape ones ( commits default to 2000 ), refs
+GIT_HANDLER_BENCHMARK( ref_enumeration )
+{
+    const size_t refs{ state.param( "refs", 20000 ) };
+    auto shape = read_shape( state );
+    shape.commits = state.param( "commits", 2000 );
+
+    test::temp_path dir{ "git_handler_bench" };
+    test::repo_generator source{ dir.sub( "source.git" ), shape };
+    source.add_refs( "refs/tags/tag_", refs / 2 );
+    source.add_refs( "refs/pull/", refs - refs / 2 );
+
+    git_repository* raw_repo{ nullptr };
+    git_repository_open( &raw_repo, source.path().c_str() );
+    auto git_repo = item::make_item< base::git_item_repo >( raw_repo );
+
+    size_t listed_branches{ 0 };
+    state.measure( "reference_list_lookup", refs + shape.branches + 1,
+                   [ & ]()
+                   {
+                       auto arr = base::aux::get_repo_ref_list( git_repo.get() );
+                       for( size_t ref_num = 0; ref_num < arr->get()->count; ++ref_num )
+                       {
+                           auto ref = base::aux::get_reference( arr->get()->strings[ ref_num ], git_repo.get() );
+                           listed_branches += ref && git_reference_is_branch( ref->get() ) ? 1 : 0;
+                       }
+                   } );
+
+    auto repo = std::make_shared< base::repo_wrapper >();
+    repo->open_local( source.path() );
+
+    base::ref_snapshot previous;
+    state.measure( "snapshot_refs", shape.branches + 1, [ & ](){ previous = repo->snapshot_refs(); } );
+
+    source.add_commits( 100 );
+
+    const auto current = repo->snapshot_refs();
+    std::vector< base::ref_snapshot::ref_change > changes;
+    state.measure( "snapshot_diff", current.size(), [ & ](){ changes = current.diff( previous ); } );
+
+    state.report( "ref_enumeration_result", { { "listed_branches", listed_branches },
+                                              { "snapshot_branches", previous.size() },
+                                              { "changed_branches", changes.size() } } );
+}
+
+// Time to the first commit, to the latest 50 and to the end of a master walk for every walk strategy.
+// Every walk gets a fresh repo, so that no commit is read from the commit store.
+// Params: the repo shape ones ( branches default to 2, merge_percent to 20 )
+GIT_HANDLER_BENCHMARK( walk_strategies )
+{
+    auto shape = read_shape( state );
+    shape.branches = state.param( "branches", 2 );
+    shape.merge_density = state.param( "merge_percent", 20 ) / 100.;
+
+    test::temp_path dir{ "git_handler_bench" };
+    test::repo_generator source{ dir.sub( "source.git" ), shape };
+
+    const std::pair< const char*, base::walk_strategy > strategies[]{ { "time", base::walk_strategy::time },
+                                                                      { "topological", base::walk_strategy::topological },
+                                                                      { "first_parent", base::walk_strategy::first_parent },
+                                                                      { "reverse", base::walk_strategy::reverse } };
+
+    auto elapsed = []( const bench::clock::time_point start )
+                   {
+                       return double( std::chrono::duration_cast< std::chrono::nanoseconds >( bench::clock::now() - start ).count() );
+                   };
+
+    for( const auto& strategy : strategies )
+    {
+        base::walk_options options;
+        options.strategy = strategy.second;
+
+        double first_ns{ 0 };
+        double total_ns{ 0 };
+        size_t commits{ 0 };
+
+        {
+            auto repo = std::make_shared< base::repo_wrapper >();
+            repo->open_local( source.path() );
+
+            const auto start = bench::clock::now();
+            auto walk = repo->walk( test::repo_generator::master_ref, options );
+            for( auto commit = walk.begin(); commit != walk.end(); ++commit )
+            {
+                if( !commits++ )
+                {
+                    first_ns = elapsed( start );
+                }
+            }
+
+            total_ns = elapsed( start );
+        }
+
+        double first_50_ns{ 0 };
+
+        {
+            auto repo = std::make_shared< base::repo_wrapper >();
+            repo->open_local( source.path() );
+
+            options.limit = 50;
+            const auto start = bench::clock::now();
+            for( const auto& commit : repo->walk( test::repo_generator::master_ref, options ) )
+            {
+                ( void )commit;
+            }
+
+            first_50_ns = elapsed( start );
+        }
+
+        state.report( std::string{ "walk_" } + strategy.first, { { "first_commit_ns", first_ns },
+                                                                 { "first_50_ns", first_50_ns },
+                                                                 { "total_ns", total_ns },
+                                                                 { "commits", commits } } );
+    }
+}
+
+// The ids, times and authors of a whole history read through full commits and through the light
+// header records, then the headers of the same ids with one and with several workers.
+// Params: the repo shape ones, workers
+GIT_HANDLER_BENCHMARK( commit_headers )
+{
+    const size_t workers{ state.param( "workers", std::max( 2u, std::thread::hardware_concurrency() ) ) };
+    auto shape = read_shape( state );
+
+    test::temp_path dir{ "git_handler_bench" };
+    test::repo_generator source{ dir.sub( "source.git" ), shape };
+    const auto tip = source.tip( test::repo_generator::master_ref );
+
+    std::vector< git_oid > ids;
+
+    {
+        auto repo = std::make_shared< base::repo_wrapper >();
+        repo->open_local( source.path() );
+
+        for( const auto& header : repo->read_history_headers( tip ) )
+        {
+            ids.push_back( header.id );
+        }
+    }
+
+    size_t authors_size{ 0 };
+
+    {
+        auto repo = std::make_shared< base::repo_wrapper >();
+        repo->open_local( source.path() );
+
+        state.measure( "full_commits", ids.size(),
+                       [ & ]()
+                       {
+                           for( const auto& commit : repo->walk( tip ) )
+                           {
+                               authors_size += commit->author().size() + commit->parents().size();
+                           }
+                       } );
+    }
+
+    {
+        auto repo = std::make_shared< base::repo_wrapper >();
+        repo->open_local( source.path() );
+
+        state.measure( "history_headers", ids.size(),
+                       [ & ]()
+                       {
+                           const auto headers = repo->read_history_headers( tip );
+                           for( const auto& header : headers )
+                           {
+                               authors_size += headers.author_name( header ).size() + header.parents_count;
+                           }
+                       } );
+    }
+
+    // every worker reads through its own repo handle, opened before the measure
+    for( const size_t workers_count : { size_t{ 1 }, workers } )
+    {
+        auto repo = std::make_shared< base::repo_wrapper >();
+        repo->open_local( source.path() );
+        repo->read_commit_headers( { ids.front() }, workers_count );
+
+        base::commit_headers headers;
+        state.measure( "id_headers_" + std::to_string( workers_count ) + "_workers", ids.size(),
+                       [ & ](){ headers = repo->read_commit_headers( ids, workers_count ); } );
+
+        // the raw objects are in libgit2's cache by now, what's left is mostly the parsing
+        if( workers_count == 1 )
+        {
+            state.measure( "id_headers_cached", ids.size(), [ & ](){ headers = repo->read_commit_headers( ids ); } );
+        }
+    }
+
+    state.report( "commit_headers_result", { { "commits", ids.size() }, { "authors_size", authors_size } } );
+}
+
+// "Commits of an author in a time range" and per-day counts over every branch, answered by
+// the columnar commit table against a loop over the branch storages and their commit wrappers,
+// and commits per author grouped by interned ids against grouping by author strings.
+// Params: the repo shape ones, workers
+GIT_HANDLER_BENCHMARK( commit_analytics )
+{
+    const size_t workers{ state.param( "workers", std::max( 2u, std::thread::hardware_concurrency() ) ) };
+    const auto shape = read_shape( state );
+
+    test::temp_path dir{ "git_handler_bench" };
+    test::repo_generator source{ dir.sub( "source.git" ), shape };
+
+    auto repo = std::make_shared< base::repo_wrapper >();
+    repo->open_local( source.path() );
+
+    base::repo_wrapper::branches branches;
+    repo->get_branches( branches );
+
+    base::commit_table table;
+    state.measure( "table_build", shape.commits, [ & ](){ table = repo->read_commit_table( branches, workers ); } );
+
+    const base::commit_table::author_id author{ table.author( 0 ) };
+    const std::string author_name{ table.author_name( author ).to_string() };
+    const git_time_t from{ table.time( table.size() / 4 ) };
+    const git_time_t to{ from + git_time_t( shape.commits ) * 30 };
+
+    // the storages share commits, the loop has to deduplicate them like the table does
+    size_t storage_matches{ 0 };
+    state.measure( "storage_filter", shape.commits,
+                   [ & ]()
+                   {
+                       std::unordered_set< git_oid, details::oid_hash, details::oid_equal > seen;
+                       for( const auto& branch : branches )
+                       {
+                           for( const auto& commit : branch.second->commits() )
+                           {
+                               if( seen.insert( commit.id ).second && commit.time >= from && commit.time <= to &&
+                                   commit.commit->author() == author_name )
+                               {
+                                   ++storage_matches;
+                               }
+                           }
+                       }
+                   } );
+
+    std::vector< base::commit_table::row > rows;
+    state.measure( "table_filter", table.size(), [ & ](){ rows = table.filter( author, from, to ); } );
+
+    size_t counted{ 0 };
+    state.measure( "table_count", table.size(), [ & ](){ counted = table.count( author, from, to ); } );
+
+    std::map< git_time_t, uint32_t > storage_days;
+    state.measure( "storage_daily_counts", shape.commits,
+                   [ & ]()
+                   {
+                       std::unordered_set< git_oid, details::oid_hash, details::oid_equal > seen;
+                       for( const auto& branch : branches )
+                       {
+                           for( const auto& commit : branch.second->commits() )
+                           {
+                               if( seen.insert( commit.id ).second )
+                               {
+                                   ++storage_days[ commit.time / 86400 ];
+                               }
+                           }
+                       }
+                   } );
+
+    std::vector< uint32_t > days;
+    state.measure( "table_daily_counts", table.size(),
+                   [ & ](){ days = table.daily_counts( base::commit_table::any_author, storage_days.begin()->first * 86400,
+                                                       storage_days.rbegin()->first * 86400 + 86399 ); } );
+
+    // group by author, through the author strings and through the interned ids
+    std::unordered_map< std::string, uint32_t > storage_authors;
+    state.measure( "storage_group_by_author", shape.commits,
+                   [ & ]()
+                   {
+                       std::unordered_set< git_oid, details::oid_hash, details::oid_equal > seen;
+                       for( const auto& branch : branches )
+                       {
+                           for( const auto& commit : branch.second->commits() )
+                           {
+                               if( seen.insert( commit.id ).second )
+                               {
+                                   ++storage_authors[ commit.commit->author() ];
+                               }
+                           }
+                       }
+                   } );
+
+    std::vector< uint32_t > table_authors;
+    state.measure( "table_group_by_author", table.size(),
+                   [ & ](){ table_authors = table.author_counts( std::numeric_limits< git_time_t >::min(),
+                                                                 std::numeric_limits< git_time_t >::max() ); } );
+
+    state.report( "commit_analytics_result", { { "commits", table.size() },
+                                               { "authors", table.identities()->size() },
+                                               { "storage_matches", storage_matches },
+                                               { "table_matches", rows.size() },
+                                               { "table_count", counted },
+                                               { "days", days.size() },
+                                               { "storage_authors", storage_authors.size() },
+                                               { "table_authors", table_authors.size() } } );
+}
+
+// Diff stats of the whole history: one worker against several, each with its own repo handle,
+// and the same commits again from the cache.
+// Params: the repo shape ones, workers
+GIT_HANDLER_BENCHMARK( diff_stats )
+{
+    const size_t workers{ state.param( "workers", std::max( 2u, std::thread::hardware_concurrency() ) ) };
+    const auto shape = read_shape( state );
+
+    test::temp_path dir{ "git_handler_bench" };
+    test::repo_generator source{ dir.sub( "source.git" ), shape };
+
+    std::vector< git_oid > ids;
+    {
+        base::repo_wrapper repo;
+        repo.open_local( source.path() );
+
+        for( const auto& header : repo.read_history_headers( source.tip( test::repo_generator::master_ref ) ) )
+        {
+            ids.push_back( header.id );
+        }
+    }
+
+    // every case starts from a repo with an empty cache
+    std::vector< base::diff_stats > serial;
+    {
+        base::repo_wrapper repo;
+        repo.open_local( source.path() );
+        state.measure( "serial", ids.size(), [ & ](){ serial = repo.read_diff_stats( ids ); } );
+    }
+
+    base::repo_wrapper repo;
+    repo.open_local( source.path() );
+
+    std::vector< base::diff_stats > parallel;
+    state.measure( "parallel", ids.size(), [ & ](){ parallel = repo.read_diff_stats( ids, workers ); } );
+
+    std::vector< base::diff_stats > cached;
+    state.measure( "cached", ids.size(), [ & ](){ cached = repo.read_diff_stats( ids, workers ); } );
+
+    uint64_t insertions{ 0 };
+    for( const auto& stats : cached )
+    {
+        insertions += stats.insertions;
+    }
+
+    state.report( "diff_stats_result", { { "commits", ids.size() },
+                                         { "workers", workers },
+                                         { "insertions", insertions },
+                                         { "cached", repo.diff_cache().size() } } );
+}
+
+// Exporting every branch of a repo, against formatting the commits with get_commit_message_str().
+// Params: the repo shape ones
+GIT_HANDLER_BENCHMARK( history_export )
+{
+    const auto shape = read_shape( state );
+
+    test::temp_path dir{ "git_handler_bench" };
+    test::repo_generator source{ dir.sub( "source.git" ), shape };
+
+    auto repo = std::make_shared< base::repo_wrapper >();
+    repo->open_local( source.path() );
+
+    base::repo_wrapper::branches branches;
+    repo->get_branches( branches );
+
+    const size_t commits{ commits_count( branches ) };
+
+    size_t formatted_bytes{ 0 };
+    state.measure( "get_commit_message_str", commits,
+                   [ & ]()
+                   {
+                       for( const auto& branch : branches )
+                       {
+                           for( const auto& commit : branch.second->commits() )
+                           {
+                               formatted_bytes += base::aux::get_commit_message_str( commit.commit.get() ).size();
+                           }
+                       }
+                   } );
+
+    // counts the bytes, so that only the formatting is measured
+    struct counting_sink : public base::export_sink
+    {
+        void write( const char*, const size_t size ) override
+        {
+            bytes += size;
+        }
+
+        size_t bytes{ 0 };
+    };
+
+    counting_sink json;
+    state.measure( "export_json_lines", commits,
+                   [ & ]()
+                   {
+                       base::commit_exporter exporter{ json, base::export_format::json_lines };
+                       exporter.write( branches );
+                   } );
+
+    counting_sink binary;
+    state.measure( "export_binary", commits,
+                   [ & ]()
+                   {
+                       base::commit_exporter exporter{ binary, base::export_format::binary };
+                       exporter.write( branches );
+                   } );
+
+    state.report( "history_export_result", { { "formatted_bytes", formatted_bytes },
+                                             { "json_bytes", json.bytes },
+                                             { "binary_bytes", binary.bytes } } );
+}
+
+// Ancestry queries answered by the reachability index against libgit2's graph walk
+// and against scanning the branch storages. Params: the repo shape ones, queries
+GIT_HANDLER_BENCHMARK( reachability_queries )
+{
+    const size_t queries{ state.param( "queries", 10000 ) };
+    const size_t libgit2_queries{ std::min( queries, state.param( "libgit2_queries", 100 ) ) };
+    const auto shape = read_shape( state );
+
+    test::temp_path dir{ "git_handler_bench" };
+    test::repo_generator source{ dir.sub( "source.git" ), shape };
+
+    auto repo = std::make_shared< base::repo_wrapper >();
+    repo->open_local( source.path() );
+    repo->set_reachability_index( true );
+
+    base::repo_wrapper::branches branches;
+    state.measure( "get_branches_with_index", shape.commits, [ & ](){ repo->get_branches( branches ); } );
+
+    std::vector< git_oid > ids;
+    for( const auto& branch : branches )
+    {
+        for( const auto& commit : branch.second->commits() )
+        {
+            ids.push_back( commit.id );
+        }
+    }
+
+    std::mt19937 random{ 42 };
+    std::uniform_int_distribution< size_t > pick{ 0, ids.size() - 1 };
+
+    std::vector< std::pair< git_oid, git_oid > > pairs( queries );
+    for( auto& pair : pairs )
+    {
+        pair = { ids[ pick( random ) ], ids[ pick( random ) ] };
+    }
+
+    const auto index = repo->reachability();
+
+    size_t found{ 0 };
+    state.measure( "is_ancestor_index", queries,
+                   [ & ]()
+                   {
+                       for( const auto& pair : pairs )
+                       {
+                           found += index->is_ancestor( pair.first, pair.second ) ? 1 : 0;
+                       }
+                   } );
+
+    git_repository* raw_repo{ nullptr };
+    git_repository_open( &raw_repo, source.path().c_str() );
+    auto git_repo = item::make_item< base::git_item_repo >( raw_repo );
+
+    // libgit2 walks the graph for every query, so it only gets a sample
+    size_t expected{ 0 }, sample_found{ 0 };
+    state.measure( "is_ancestor_libgit2", libgit2_queries,
+                   [ & ]()
+                   {
+                       for( size_t query = 0; query < libgit2_queries; ++query )
+                       {
+                           const auto& pair = pairs[ query ];
+                           expected += git_oid_equal( &pair.first, &pair.second ) ||
+                                       git_graph_descendant_of( git_repo->get(), &pair.second, &pair.first ) == 1 ? 1 : 0;
+                       }
+                   } );
+
+    for( size_t query = 0; query < libgit2_queries; ++query )
+    {
+        sample_found += index->is_ancestor( pairs[ query ].first, pairs[ query ].second ) ? 1 : 0;
+    }
+
+    state.report( "is_ancestor_result", { { "found", found }, { "sample_found", sample_found }, { "sample_expected", expected } } );
+
+    size_t containing{ 0 };
+    state.measure( "branches_containing_index", queries,
+                   [ & ]()
+                   {
+                       for( const auto& pair : pairs )
+                       {
+                           containing += index->branches_containing( pair.first ).size();
+                       }
+                   } );
+
+    size_t scanned{ 0 };
+    state.measure( "branches_containing_storage", queries,
+                   [ & ]()
+                   {
+                       for( const auto& pair : pairs )
+                       {
+                           for( const auto& branch : branches )
+                           {
+                               scanned += branch.second->commits().contains( pair.first ) ? 1 : 0;
+                           }
+                       }
+                   } );
+
+    state.report( "branches_containing_result", { { "index", containing }, { "storage", scanned } } );
+}
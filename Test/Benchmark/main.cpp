@@ -0,0 +1,86 @@
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "Benchmark.h"
+
+namespace bench
+{
+
+state::state( std::string name, const params& benchmark_params ) :
+    m_name( std::move( name ) ),
+    m_params( benchmark_params )
+{
+
+}
+
+size_t state::param( const std::string& name, const size_t default_value ) const
+{
+    auto value = m_params.find( name );
+    return value != m_params.end() ? std::strtoull( value->second.c_str(), nullptr, 10 ) : default_value;
+}
+
+std::string state::text_param( const std::string& name, const std::string& default_value ) const
+{
+    auto value = m_params.find( name );
+    return value != m_params.end() ? value->second : default_value;
+}
+
+void state::report( const std::string& case_name, const metrics& values ) const
+{
+    printf( "{\"benchmark\":\"%s\",\"case\":\"%s\"", m_name.c_str(), case_name.c_str() );
+
+    for( const auto& value : values )
+    {
+        printf( ",\"%s\":%.15g", value.first.c_str(), value.second );
+    }
+
+    printf( "}\n" );
+    fflush( stdout );
+}
+
+}
+
+// Usage: GitHandlerBenchmarks [filter=<name part>] [<param>=<value>]...
+// Every benchmark whose name contains the filter is run, results are printed as JSON lines
+int main( int argc, char **argv )
+{
+    bench::params params;
+
+    for( int arg_num = 1; arg_num < argc; ++arg_num )
+    {
+        std::string arg{ argv[ arg_num ] };
+        auto separator = arg.find( '=' );
+        if( separator == std::string::npos )
+        {
+            fprintf( stderr, "Wrong argument %s, expected <param>=<value>\n", arg.c_str() );
+            return 1;
+        }
+
+        params[ arg.substr( 0, separator ) ] = arg.substr( separator + 1 );
+    }
+
+    const std::string filter{ params.count( "filter" ) ? params[ "filter" ] : "" };
+
+    int result{ 0 };
+    for( const auto& benchmark : bench::registered_benchmarks() )
+    {
+        if( benchmark.first.find( filter ) == std::string::npos )
+        {
+            continue;
+        }
+
+        try
+        {
+            bench::state state{ benchmark.first, params };
+            benchmark.second( state );
+        }
+        catch( const std::exception& e )
+        {
+            fprintf( stderr, "Benchmark %s failed: %s\n", benchmark.first.c_str(), e.what() );
+            result = 1;
+        }
+    }
+
+    return result;
+}
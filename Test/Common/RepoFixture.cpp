@@ -0,0 +1,32 @@
+#include "RepoFixture.h"
+
+namespace git_handler
+{
+
+namespace test
+{
+
+git_oid make_id( const unsigned char seed )
+{
+    git_oid id{};
+    id.id[ 0 ] = seed;
+    id.id[ 19 ] = 1;
+    return id;
+}
+
+void repo_fixture::generate( const repo_shape& shape )
+{
+    mSource = std::make_unique< repo_generator >( mDir.sub( "source.git" ), shape );
+    mRepo = open_repo();
+}
+
+std::shared_ptr< base::repo_wrapper > repo_fixture::open_repo() const
+{
+    auto repo = std::make_shared< base::repo_wrapper >();
+    repo->open_local( mSource->path() );
+    return repo;
+}
+
+}//test
+
+}//git_handler
@@ -0,0 +1,37 @@
+#ifndef REPOFIXTURE_H
+#define REPOFIXTURE_H
+
+#include <memory>
+
+#include "gtest/gtest.h"
+
+#include "RepoGenerator.h"
+
+namespace git_handler
+{
+
+namespace test
+{
+
+// id with the seed in its first byte, never the zero id
+git_oid make_id( const unsigned char seed );
+
+// Base of the tests run against a generated repository: generate() builds it in a temp
+// directory and opens mRepo on it, open_repo() opens further handles on the same repo
+class repo_fixture : public testing::Test
+{
+protected:
+    void generate( const repo_shape& shape );
+    std::shared_ptr< base::repo_wrapper > open_repo() const;
+
+protected:
+    temp_path mDir;
+    std::unique_ptr< repo_generator > mSource;
+    std::shared_ptr< base::repo_wrapper > mRepo;
+};
+
+}//test
+
+}//git_handler
+
+#endif // REPOFIXTURE_H
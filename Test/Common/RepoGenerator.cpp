@@ -0,0 +1,322 @@
+#include <stdexcept>
+
+#include <boost/filesystem.hpp>
+
+#include "RepoGenerator.h"
+
+namespace git_handler
+{
+
+namespace test
+{
+
+namespace
+{
+
+bool is_zero( const git_oid& id ) noexcept
+{
+    static const git_oid zero_id{};
+    return git_oid_equal( &id, &zero_id ) != 0;
+}
+
+using signature_ptr = std::unique_ptr< git_signature, void( * )( git_signature* ) >;
+
+signature_ptr make_signature( const size_t author_num, const git_time_t time )
+{
+    const std::string name{ "author_" + std::to_string( author_num ) };
+    const std::string email{ name + "@example.com" };
+
+    git_signature* signature{ nullptr };
+    if( git_signature_new( &signature, name.c_str(), email.c_str(), time, 0 ) != 0 )
+    {
+        throw std::runtime_error{ "Could not create signature" };
+    }
+
+    return signature_ptr{ signature, git_signature_free };
+}
+
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////              RepoGenerator              //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+const std::string repo_generator::master_ref{ "refs/heads/master" };
+
+repo_generator::repo_generator( const std::string& path, const repo_shape& shape ) :
+    m_shape( shape ),
+    m_path( path ),
+    m_random( shape.seed )
+{
+    git_libgit2_init();
+
+    boost::filesystem::remove_all( m_path );
+
+    git_repository* r{ nullptr };
+    if( git_repository_init( &r, m_path.c_str(), true ) != 0 )
+    {
+        throw std::runtime_error{ "Could not init repository " + m_path };
+    }
+
+    m_repo = item::make_item< base::git_item_repo >( r );
+
+    m_ref_names.push_back( master_ref );
+    for( size_t branch_num = 1; branch_num <= m_shape.branches; ++branch_num )
+    {
+        m_ref_names.push_back( "refs/heads/branch_" + std::to_string( branch_num ) );
+    }
+
+    m_tips.resize( m_ref_names.size() );
+
+    add_commits( m_shape.commits );
+
+    if( git_repository_set_head( m_repo->get(), master_ref.c_str() ) != 0 )
+    {
+        throw std::runtime_error{ "Could not set HEAD of " + m_path };
+    }
+}
+
+void repo_generator::add_commits( const size_t count )
+{
+    std::uniform_int_distribution< size_t > branch_dist{ 1, std::max< size_t >( m_shape.branches, 1 ) };
+    std::bernoulli_distribution on_master{ m_shape.branches ? 0.5 : 1. };
+
+    for( size_t commit_num = 0; commit_num < count; ++commit_num )
+    {
+        size_t branch_num{ on_master( m_random ) ? 0 : branch_dist( m_random ) };
+
+        // branches fork off master, so master gets the very first commit
+        if( is_zero( m_tips[ 0 ] ) )
+        {
+            branch_num = 0;
+        }
+
+        m_tips[ branch_num ] = write_commit( branch_num, m_time, m_time );
+        m_time += 60;
+        ++m_commits_count;
+    }
+
+    update_refs();
+}
+
+git_oid repo_generator::add_commit( const std::string& ref_name, const git_time_t author_time, const git_time_t committer_time,
+                                    const std::string& message )
+{
+    const size_t branch{ branch_num( ref_name ) };
+
+    m_tips[ branch ] = write_commit( branch, author_time, committer_time, message );
+    ++m_commits_count;
+
+    update_refs();
+    return m_tips[ branch ];
+}
+
+std::string repo_generator::path() const
+{
+    return m_path;
+}
+
+std::string repo_generator::url() const
+{
+    return "file://" + boost::filesystem::absolute( m_path ).string();
+}
+
+size_t repo_generator::commits_count() const noexcept
+{
+    return m_commits_count;
+}
+
+std::vector< std::string > repo_generator::ref_names() const
+{
+    std::vector< std::string > names;
+
+    for( size_t branch_num = 0; branch_num < m_ref_names.size(); ++branch_num )
+    {
+        if( !is_zero( m_tips[ branch_num ] ) )
+        {
+            names.push_back( m_ref_names[ branch_num ] );
+        }
+    }
+
+    return names;
+}
+
+git_oid repo_generator::tip( const std::string& ref_name ) const
+{
+    return m_tips[ branch_num( ref_name ) ];
+}
+
+size_t repo_generator::branch_num( const std::string& ref_name ) const
+{
+    for( size_t branch_num = 0; branch_num < m_ref_names.size(); ++branch_num )
+    {
+        if( m_ref_names[ branch_num ] == ref_name )
+        {
+            return branch_num;
+        }
+    }
+
+    throw std::logic_error{ "Unknown branch " + ref_name };
+}
+
+git_oid repo_generator::write_commit( const size_t branch_num, const git_time_t author_time, const git_time_t committer_time,
+                                      const std::string& custom_message )
+{
+    std::vector< git_oid > parent_ids;
+    if( !is_zero( m_tips[ branch_num ] ) )
+    {
+        parent_ids.push_back( m_tips[ branch_num ] );
+
+        std::bernoulli_distribution merge{ m_shape.merge_density };
+        if( branch_num && merge( m_random ) && !git_oid_equal( &m_tips[ 0 ], &m_tips[ branch_num ] ) )
+        {
+            parent_ids.push_back( m_tips[ 0 ] );
+        }
+    }
+    else if( branch_num )
+    {
+        parent_ids.push_back( m_tips[ 0 ] );
+    }
+
+    std::vector< base::git_item_commit > parents;
+    std::vector< const git_commit* > parent_pointers;
+
+    for( const auto& parent_id : parent_ids )
+    {
+        auto parent = base::aux::read_commit( m_repo.get(), &parent_id );
+        if( !parent )
+        {
+            throw std::runtime_error{ "Could not read generated commit" };
+        }
+
+        parent_pointers.push_back( parent.get() );
+        parents.push_back( std::move( parent ) );
+    }
+
+    const std::string content{ m_ref_names[ branch_num ] + " " + std::to_string( m_commits_count ) + "\n" };
+
+    git_oid blob_id;
+    if( git_blob_create_from_buffer( &blob_id, m_repo->get(), content.data(), content.size() ) != 0 )
+    {
+        throw std::runtime_error{ "Could not write blob" };
+    }
+
+    git_treebuilder* builder{ nullptr };
+    if( git_treebuilder_new( &builder, m_repo->get(), nullptr ) != 0 )
+    {
+        throw std::runtime_error{ "Could not create tree builder" };
+    }
+
+    std::unique_ptr< git_treebuilder, void( * )( git_treebuilder* ) > builder_ptr{ builder, git_treebuilder_free };
+
+    git_oid tree_id;
+    if( git_treebuilder_insert( nullptr, builder, "file", &blob_id, GIT_FILEMODE_BLOB ) != 0 ||
+        git_treebuilder_write( &tree_id, builder ) != 0 )
+    {
+        throw std::runtime_error{ "Could not write tree" };
+    }
+
+    git_tree* tree{ nullptr };
+    if( git_tree_lookup( &tree, m_repo->get(), &tree_id ) != 0 )
+    {
+        throw std::runtime_error{ "Could not read tree" };
+    }
+
+    std::unique_ptr< git_tree, void( * )( git_tree* ) > tree_ptr{ tree, git_tree_free };
+
+    std::string message{ custom_message };
+    if( message.empty() )
+    {
+        message = "Commit " + std::to_string( m_commits_count ) + " on " + m_ref_names[ branch_num ] + "\n";
+    }
+
+    if( custom_message.empty() && message.size() < m_shape.message_size )
+    {
+        message += "\n" + std::string( m_shape.message_size - message.size(), 'm' );
+    }
+
+    std::uniform_int_distribution< size_t > author_dist{ 0, std::max< size_t >( m_shape.authors, 1 ) - 1 };
+    const size_t author_num{ author_dist( m_random ) };
+    auto author = make_signature( author_num, author_time );
+    auto committer = make_signature( author_num, committer_time );
+
+    git_oid commit_id;
+    if( git_commit_create( &commit_id, m_repo->get(), nullptr,
+                           author.get(), committer.get(), nullptr,
+                           message.c_str(), tree,
+                           parent_pointers.size(), parent_pointers.data() ) != 0 )
+    {
+        throw std::runtime_error{ "Could not write commit" };
+    }
+
+    return commit_id;
+}
+
+void repo_generator::add_refs( const std::string& prefix, const size_t count )
+{
+    const git_oid target = tip( master_ref );
+
+    for( size_t ref_num = 0; ref_num < count; ++ref_num )
+    {
+        const std::string name{ prefix + std::to_string( ref_num ) };
+
+        git_reference* ref{ nullptr };
+        if( git_reference_create( &ref, m_repo->get(), name.c_str(), &target, true, nullptr ) != 0 )
+        {
+            throw std::runtime_error{ "Could not create " + name };
+        }
+
+        item::make_item< base::git_item_ref >( ref );
+    }
+}
+
+void repo_generator::update_refs()
+{
+    for( size_t branch_num = 0; branch_num < m_ref_names.size(); ++branch_num )
+    {
+        if( is_zero( m_tips[ branch_num ] ) )
+        {
+            continue;
+        }
+
+        git_reference* ref{ nullptr };
+        if( git_reference_create( &ref, m_repo->get(), m_ref_names[ branch_num ].c_str(),
+                                  &m_tips[ branch_num ], true, nullptr ) != 0 )
+        {
+            throw std::runtime_error{ "Could not update " + m_ref_names[ branch_num ] };
+        }
+
+        item::make_item< base::git_item_ref >( ref );
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///////////////                TempPath                 //////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+temp_path::temp_path( const std::string& prefix ) :
+    m_path( ( boost::filesystem::temp_directory_path() /
+              boost::filesystem::unique_path( prefix + "_%%%%-%%%%-%%%%" ) ).string() )
+{
+    boost::filesystem::create_directories( m_path );
+}
+
+temp_path::~temp_path()
+{
+    boost::system::error_code error;
+    boost::filesystem::remove_all( m_path, error );
+}
+
+std::string temp_path::str() const
+{
+    return m_path;
+}
+
+std::string temp_path::sub( const std::string& name ) const
+{
+    return ( boost::filesystem::path{ m_path } / name ).string();
+}
+
+}//test
+
+}//git_handler
@@ -0,0 +1,98 @@
+#ifndef REPOGENERATOR_H
+#define REPOGENERATOR_H
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "GitBaseClasses.h"
+
+namespace git_handler
+{
+
+namespace test
+{
+
+// Shape of a generated repository
+struct repo_shape
+{
+    size_t commits{ 1000 };
+    // branches besides master, each forks off master at a random commit
+    size_t branches{ 4 };
+    // probability that a branch commit merges the current master
+    double merge_density{ 0.1 };
+    size_t message_size{ 64 };
+    size_t authors{ 16 };
+    uint32_t seed{ 42 };
+};
+
+// Builds a bare repository with a deterministic history of the given shape, usable as a
+// file:// remote. Commits are spread randomly over master and the other branches and every
+// commit gets its own one-file tree
+class repo_generator
+{
+public:
+    static const std::string master_ref;
+
+public:
+    repo_generator( const std::string& path, const repo_shape& shape );
+    repo_generator( const repo_generator& ) = delete;
+    repo_generator& operator=( const repo_generator& ) = delete;
+
+    // extends the history, the branch refs are moved once all the commits are written
+    void add_commits( const size_t count );
+    // Appends one commit with the given dates to the branch and moves its ref, e.g. a rebased commit
+    // keeping an old author date. The generated commits get equal, increasing author and committer dates.
+    // The message is written as it is, in any encoding, an empty one is generated
+    git_oid add_commit( const std::string& ref_name, const git_time_t author_time, const git_time_t committer_time,
+                        const std::string& message = {} );
+    // count refs named prefix + number, all pointing at the master tip, e.g. tags or pull request refs
+    void add_refs( const std::string& prefix, const size_t count );
+
+    std::string path() const;
+    std::string url() const;
+    size_t commits_count() const noexcept;
+    // full names of all the generated branches, master first
+    std::vector< std::string > ref_names() const;
+    git_oid tip( const std::string& ref_name ) const;
+
+private:
+    git_oid write_commit( const size_t branch_num, const git_time_t author_time, const git_time_t committer_time,
+                          const std::string& message = {} );
+    size_t branch_num( const std::string& ref_name ) const;
+    void update_refs();
+
+private:
+    repo_shape m_shape;
+    std::string m_path;
+    std::unique_ptr< base::git_item_repo > m_repo;
+    std::mt19937 m_random;
+    // tips in ref_names() order, zero until the branch gets its first commit
+    std::vector< git_oid > m_tips;
+    std::vector< std::string > m_ref_names;
+    size_t m_commits_count{ 0 };
+    git_time_t m_time{ 1500000000 };
+};
+
+// Unique path in the temp directory, removed with everything under it on destruction
+class temp_path
+{
+public:
+    explicit temp_path( const std::string& prefix = "git_handler" );
+    ~temp_path();
+    temp_path( const temp_path& ) = delete;
+    temp_path& operator=( const temp_path& ) = delete;
+
+    std::string str() const;
+    std::string sub( const std::string& name ) const;
+
+private:
+    std::string m_path;
+};
+
+}//test
+
+}//git_handler
+
+#endif // REPOGENERATOR_H
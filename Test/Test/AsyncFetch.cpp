@@ -0,0 +1,89 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <future>
+
+#include "gtest/gtest.h"
+
+#include "GitBaseClasses.h"
+#include "Common/RepoFixture.h"
+
+using namespace git_handler;
+
+namespace
+{
+
+// slows the transfer down, so that the test can cancel it halfway
+int slow_progress( const git_indexer_progress*, void* payload )
+{
+    auto calls = static_cast< std::atomic< size_t >* >( payload );
+    ++*calls;
+
+    std::this_thread::sleep_for( std::chrono::milliseconds{ 1 } );
+    return 0;
+}
+
+}
+
+class AsyncFetchTest : public test::repo_fixture{};
+
+TEST_F( AsyncFetchTest, CancelsClone )
+{
+    test::repo_shape shape;
+    shape.commits = 2000;
+
+    generate( shape );
+
+    std::atomic< size_t > calls{ 0 };
+    git_clone_options opts = GIT_CLONE_OPTIONS_INIT;
+    opts.bare = 1;
+    opts.fetch_opts.callbacks.transfer_progress = &slow_progress;
+    opts.fetch_opts.callbacks.payload = &calls;
+
+    auto repo = std::make_shared< base::repo_wrapper >();
+    base::cancel_token cancel;
+    auto cloned = repo->clone_async( mSource->url(), mDir.sub( "clone" ), opts, cancel );
+
+    while( !calls )
+    {
+        std::this_thread::sleep_for( std::chrono::milliseconds{ 1 } );
+    }
+
+    cancel.cancel();
+    ASSERT_THROW( cloned.get(), base::operation_cancelled );
+    ASSERT_FALSE( repo->is_valid() );
+
+    // the transfer stopped at the first progress call after the cancel
+    const auto& stats = repo->last_fetch_stats();
+    ASSERT_EQ( stats.remotes.size(), 1u );
+    ASSERT_LT( stats.remotes.front().received_objects, stats.remotes.front().total_objects );
+
+    // a cancelled token cancels the operations before they start
+    ASSERT_THROW( repo->clone_async( mSource->url(), mDir.sub( "clone" ), opts, cancel ).get(), base::operation_cancelled );
+
+    opts.fetch_opts.callbacks.transfer_progress = nullptr;
+    ASSERT_NO_THROW( repo->clone_async( mSource->url(), mDir.sub( "clone" ), opts ).get() );
+    ASSERT_TRUE( repo->is_valid() );
+}
+
+TEST_F( AsyncFetchTest, CompletionHandler )
+{
+    test::repo_shape shape;
+    shape.commits = 100;
+
+    generate( shape );
+
+    auto repo = std::make_shared< base::repo_wrapper >();
+    repo->clone( mSource->url(), mDir.sub( "clone" ) );
+    mSource->add_commits( 20 );
+
+    std::promise< std::exception_ptr > done;
+    repo->fetch_async( [ &done ]( std::exception_ptr error ){ done.set_value( error ); } );
+
+    ASSERT_TRUE( done.get_future().get() == nullptr );
+    ASSERT_GT( repo->last_fetch_stats().updated_refs(), 0u );
+
+    // failures reach the handler as exceptions
+    auto invalid = std::make_shared< base::repo_wrapper >();
+    ASSERT_THROW( invalid->fetch_async().get(), std::logic_error );
+}
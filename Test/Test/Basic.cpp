@@ -1,79 +1,203 @@
 #include "gtest/gtest.h"
-#include<boost/filesystem.hpp>
 
 #include "GitHandler.h"
-#include "TestArgs.h"
+#include "Common/RepoGenerator.h"
 
-extern TestArgs testArgs;
 using namespace git_handler;
 
 class GitHandlerTest : public testing::Test
 {
 protected:
-    virtual void SetUp(){}
+    virtual void SetUp()
+    {
+        test::repo_shape shape;
+        shape.commits = 200;
+        shape.branches = 3;
+
+        mSource = std::make_unique< test::repo_generator >( mDir.sub( "source.git" ), shape );
+    }
+
     virtual void TearDown(){}
 
 protected:
-    GitHandler mHandler;
+    test::temp_path mDir;
+    std::unique_ptr< test::repo_generator > mSource;
 };
 
 TEST_F( GitHandlerTest, OpenLocal )
 {
-    auto repo = base::Repo{};
-    ASSERT_FALSE( repo.openLocal( "" ) ) << "Empty opening local repo didn't fail";
-    ASSERT_TRUE( repo.openLocal( testArgs.localRepoPath ) ) << "Opening local repo failed";
+    auto repo = std::make_shared< base::repo_wrapper >();
+    ASSERT_THROW( repo->open_local( "" ), std::runtime_error ) << "Empty opening local repo didn't fail";
+    ASSERT_NO_THROW( repo->open_local( mSource->path() ) ) << "Opening local repo failed";
+    ASSERT_TRUE( repo->is_valid() );
 }
 
 TEST_F( GitHandlerTest, Clone )
 {
-    auto repo = base::Repo{};
-    ASSERT_FALSE( repo.clone( "", "" ) ) << "Empty clone didn't fail";
-    bool cloneResult = repo.clone( testArgs.remoteRepoUrl, testArgs.remoteRepoLocalPath );
+    auto repo = std::make_shared< base::repo_wrapper >();
+    ASSERT_ANY_THROW( repo->clone( "", "" ) ) << "Empty clone didn't fail";
+    ASSERT_NO_THROW( repo->clone( mSource->url(), mDir.sub( "clone" ) ) ) << "Cloning remote repo failed";
+
+    ASSERT_TRUE( repo->is_valid() );
+    ASSERT_NO_THROW( repo->fetch() );
+
+    base::repo_wrapper::branches branches;
+    ASSERT_TRUE( repo->get_branches( branches, true ) );
+    ASSERT_EQ( branches.size(), mSource->ref_names().size() );
+
+    for( const auto& branch : branches )
+    {
+        ASSERT_TRUE( branch.second != nullptr );
+        ASSERT_TRUE( repo->get_branch( branch.second->ref_name() ) != nullptr );
+    }
+}
+
+TEST_F( GitHandlerTest, LocalAndRemoteBranches )
+{
+    auto repo = std::make_shared< base::repo_wrapper >();
+    repo->clone( mSource->url(), mDir.sub( "clone" ) );
+
+    // a local branch with the short name of a remote-tracking one
+    {
+        git_repository* raw_repo{ nullptr };
+        ASSERT_EQ( git_repository_open( &raw_repo, mDir.sub( "clone" ).c_str() ), 0 );
+        auto git_repo = item::make_item< base::git_item_repo >( raw_repo );
+
+        const git_oid tip = mSource->tip( test::repo_generator::master_ref );
+        git_commit* commit{ nullptr };
+        ASSERT_EQ( git_commit_lookup( &commit, git_repo->get(), &tip ), 0 );
+        auto commit_item = item::make_item< base::git_item_commit >( commit );
+
+        git_reference* branch{ nullptr };
+        ASSERT_EQ( git_branch_create( &branch, git_repo->get(), "origin/master", commit_item->get(), 0 ), 0 );
+        git_reference_free( branch );
+    }
+
+    base::repo_wrapper::branches local;
+    ASSERT_TRUE( repo->get_branches( local ) );
+
+    base::repo_wrapper::branches remote;
+    ASSERT_TRUE( repo->get_branches( remote, true ) );
+
+    // one storage holds both kinds, reading one of them doesn't drop the other
+    base::repo_wrapper::branches branches;
+    ASSERT_TRUE( repo->get_branches( branches ) );
+    ASSERT_TRUE( repo->get_branches( branches, true ) );
+    ASSERT_EQ( branches.size(), local.size() + remote.size() );
 
-    if( cloneResult )
+    ASSERT_TRUE( repo->get_branches( branches ) );
+    ASSERT_EQ( branches.size(), local.size() + remote.size() );
+
+    size_t remotes_count{ 0 };
+    for( const auto& branch : branches )
     {
-        ASSERT_TRUE( repo.isValid() );
-        ASSERT_TRUE( repo.fetch() );
-
-        base::Repo::BranchStorage branches;
-        ASSERT_TRUE( repo.getBranches( branches ) );
-
-        for( const auto& branch : branches )
-        {
-            auto name = branch.first;
-            ASSERT_TRUE( branch.second != nullptr );
-            ASSERT_TRUE( repo.getBranch( name ) != nullptr );
-        }
+        ASSERT_EQ( branch.first, branch.second->ref_name() );
+        ASSERT_EQ( branch.second->is_remote(), branch.first.compare( 0, 13, "refs/remotes/" ) == 0 );
+        remotes_count += branch.second->is_remote() ? 1 : 0;
+        ASSERT_FALSE( branch.second->commits().empty() );
     }
 
-    boost::filesystem::remove_all( testArgs.remoteRepoLocalPath );
-    ASSERT_TRUE( cloneResult ) << "Cloning remote repo failed";
+    ASSERT_EQ( remotes_count, remote.size() );
+}
+
+TEST_F( GitHandlerTest, IncrementalRefresh )
+{
+    auto repo = std::make_shared< base::repo_wrapper >();
+    repo->open_local( mSource->path() );
+
+    base::repo_wrapper::branches branches;
+    repo->get_branches( branches, false, 2 );
+
+    auto master = branches.find( test::repo_generator::master_ref );
+    ASSERT_TRUE( master != branches.end() );
+
+    const auto* master_branch = master->second.get();
+    const size_t old_size{ master_branch->commits().size() };
+
+    mSource->add_commits( 50 );
+    repo->get_branches( branches );
+
+    // the stored branch is refreshed from its old tip, the reread one must match it
+    auto reread = repo->get_branch( test::repo_generator::master_ref );
+    ASSERT_TRUE( reread != nullptr );
+    ASSERT_EQ( master->second.get(), master_branch );
+    ASSERT_GE( master_branch->commits().size(), old_size );
+    ASSERT_EQ( master_branch->commits().size(), reread->commits().size() );
+
+    const git_oid tip = mSource->tip( test::repo_generator::master_ref );
+    const git_oid branch_tip = master_branch->tip();
+    ASSERT_TRUE( git_oid_equal( &tip, &branch_tip ) );
 }
 
-// GitHandler h;
+TEST_F( GitHandlerTest, FetchStats )
+{
+    auto repo = std::make_unique< base::repo_wrapper >();
+    repo->clone( mSource->url(), mDir.sub( "clone" ) );
+
+    const auto& clone_stats = repo->last_fetch_stats();
+    ASSERT_EQ( clone_stats.remotes.size(), 1u );
+    ASSERT_GT( clone_stats.received_objects(), 0u );
+
+    mSource->add_commits( 20 );
+
+    const std::string path{ repo->path() };
 
-// string path = "/home/skoparov/Repo/dir";
-// //string path = "D:\\Repo\\libgit2";
+    git_handler::git_handler handler;
+    ASSERT_TRUE( handler.add_repo( std::move( repo ), "", "" ) );
 
+    size_t dumps{ 0 };
+    handler.set_stats_dump( std::chrono::seconds{ 0 }, [ & ]( const git_handler::git_handler::stats_storage& ){ ++dumps; } );
 
-// RepoPtr repo = std::make_shared<Repo>();
-// bool result = repo->openLocal(path);
-// h.addRepo(repo, "Skoparov", "Q3e5T7u9");
+    auto results = handler.update();
+    ASSERT_TRUE( results[ path ].ok ) << results[ path ].error;
+    ASSERT_TRUE( results[ path ].collected );
+    ASSERT_FALSE( handler.take_new_commits().empty() );
 
-// //bool a = h.update();
-// //printf("Fetch %s\n", a ? "successful" : "failed");
-// //printNew(h);
+    auto stats = handler.get_stats();
+    ASSERT_EQ( stats.size(), 1u );
 
-// auto repoPtr = h.getRepo(path);
-// if (repoPtr != nullptr)
-// {
-//     BranchStorage locals;
-//     if (repoPtr->getBranches(locals, true))
-//     {
-//         Aux::printBranches(locals);
-//         for (auto branch : locals){
-//             Aux::printBranchCommits(branch.second);
-//         }
-//     }
-// }
+    const auto& repo_stats = stats[ path ];
+    ASSERT_EQ( repo_stats.updates, 1u );
+    ASSERT_EQ( repo_stats.failures, 0u );
+    ASSERT_EQ( repo_stats.last.remotes.size(), 1u );
+    ASSERT_GT( repo_stats.received_objects, 0u );
+    ASSERT_GT( repo_stats.updated_refs, 0u );
 
+    // the phases cover the whole fetch of the remote
+    const auto& remote = repo_stats.last.remotes.front();
+    ASSERT_EQ( remote.negotiation + remote.transfer + remote.indexing + remote.update, remote.duration );
+    ASSERT_EQ( dumps, 0u );
+}
+
+TEST_F( GitHandlerTest, SkipsUnchangedFetches )
+{
+    auto repo = std::make_shared< base::repo_wrapper >();
+    repo->clone( mSource->url(), mDir.sub( "clone" ) );
+    repo->set_skip_unchanged_fetches( true );
+
+    repo->fetch();
+    ASSERT_EQ( repo->last_fetch_stats().skipped_remotes(), 1u );
+    ASSERT_TRUE( repo->last_fetch_stats().remotes.front().skipped );
+
+    // moved refs are fetched over the connection opened for the check
+    mSource->add_commits( 10 );
+    repo->fetch();
+    ASSERT_EQ( repo->last_fetch_stats().skipped_remotes(), 0u );
+    ASSERT_GT( repo->last_fetch_stats().updated_refs(), 0u );
+
+    const git_oid tip = mSource->tip( test::repo_generator::master_ref );
+    auto master = repo->get_branch( "refs/remotes/origin/master" );
+    ASSERT_TRUE( master != nullptr );
+
+    const git_oid master_tip = master->tip();
+    ASSERT_TRUE( git_oid_equal( &master_tip, &tip ) );
+
+    repo->fetch();
+    ASSERT_EQ( repo->last_fetch_stats().skipped_remotes(), 1u );
+
+    // pruning fetches can't be decided from the advertisement
+    git_fetch_options opts = GIT_FETCH_OPTIONS_INIT;
+    opts.prune = GIT_FETCH_PRUNE;
+    repo->fetch( opts );
+    ASSERT_EQ( repo->last_fetch_stats().skipped_remotes(), 0u );
+}
@@ -0,0 +1,149 @@
+#include <map>
+#include <limits>
+#include <algorithm>
+
+#include "gtest/gtest.h"
+
+#include "GitBaseClasses.h"
+#include "details/CommitHeaderParser.h"
+#include "Common/RepoFixture.h"
+
+using namespace git_handler;
+
+namespace
+{
+
+std::string oid_str( const git_oid& id )
+{
+    char id_str[ GIT_OID_HEXSZ + 1 ];
+    git_oid_tostr( id_str, sizeof( id_str ), &id );
+    return id_str;
+}
+
+}
+
+TEST( CommitHeaderParserTest, Parses )
+{
+    const std::string raw{ "tree 4b825dc642cb6eb9a060e54bf8d69288fbee4904\n"
+                           "parent 0123456789abcdef0123456789abcdef01234567\n"
+                           "parent 89abcdef0123456789abcdef0123456789ABCDEF\n"
+                           "author Jane Doe <jane@example.com> 1500000000 +0230\n"
+                           "committer John Roe <john@example.com> 1500000100 -0100\n"
+                           "gpgsig -----BEGIN PGP SIGNATURE-----\n"
+                           "\n"
+                           "message\n" };
+
+    details::commit_header_fields fields;
+    ASSERT_TRUE( details::parse_commit_header( raw.data(), raw.size(), fields ) );
+
+    ASSERT_EQ( fields.parents_count, 2u );
+    git_oid parent;
+    ASSERT_TRUE( details::parse_parent( fields, 1, parent ) );
+    ASSERT_EQ( oid_str( parent ), "89abcdef0123456789abcdef0123456789abcdef" );
+    ASSERT_FALSE( details::parse_parent( fields, 2, parent ) );
+
+    ASSERT_EQ( fields.author.name, "Jane Doe" );
+    ASSERT_EQ( fields.author.email, "jane@example.com" );
+    ASSERT_EQ( fields.author.time, 1500000000 );
+    ASSERT_EQ( fields.author.offset, 150 );
+    ASSERT_EQ( fields.committer.name, "John Roe" );
+    ASSERT_EQ( fields.committer.time, 1500000100 );
+    ASSERT_EQ( fields.committer.offset, -60 );
+    ASSERT_EQ( fields.message, "message\n" );
+
+    // a root commit with an empty name and no offset
+    const std::string root{ "tree 4b825dc642cb6eb9a060e54bf8d69288fbee4904\n"
+                            "author <nobody@example.com> 42\n"
+                            "committer <nobody@example.com> 42\n" };
+
+    ASSERT_TRUE( details::parse_commit_header( root.data(), root.size(), fields ) );
+    ASSERT_EQ( fields.parents_count, 0u );
+    ASSERT_TRUE( fields.author.name.empty() );
+    ASSERT_EQ( fields.committer.time, 42 );
+    ASSERT_EQ( fields.committer.offset, 0 );
+    ASSERT_TRUE( fields.message.empty() );
+
+    const std::string malformed[]{ "",
+                                   "tree 4b825dc6\nauthor a <b> 1 +0000\ncommitter a <b> 1 +0000\n",
+                                   "tree 4b825dc642cb6eb9a060e54bf8d69288fbee4904\nauthor a b 1 +0000\ncommitter a <b> 1 +0000\n",
+                                   "tree 4b825dc642cb6eb9a060e54bf8d69288fbee4904\nauthor a <b> 1 +0000\n",
+                                   "tree 4b825dc642cb6eb9a060e54bf8d69288fbee4904\nparent 01\nauthor a <b> 1 +0000\ncommitter a <b> 1 +0000\n",
+                                   "tree 4b825dc642cb6eb9a060e54bf8d69288fbee4904\nparent 0123456789abcdef0123456789abcdef0123456z\n"
+                                   "author a <b> 1 +0000\ncommitter a <b> 1 +0000\n",
+                                   "tree 4b825dc642cb6eb9a060e54bf8d69288fbee4904\nauthor a <b> 9223372036854775808 +0000\ncommitter a <b> 1 +0000\n" };
+
+    for( const auto& text : malformed )
+    {
+        ASSERT_FALSE( details::parse_commit_header( text.data(), text.size(), fields ) ) << text;
+    }
+
+    // the largest time that fits
+    const std::string latest{ "tree 4b825dc642cb6eb9a060e54bf8d69288fbee4904\n"
+                              "author a <b> 9223372036854775807 +0000\n"
+                              "committer a <b> 1 +0000\n" };
+
+    ASSERT_TRUE( details::parse_commit_header( latest.data(), latest.size(), fields ) );
+    ASSERT_EQ( fields.author.time, std::numeric_limits< int64_t >::max() );
+}
+
+class CommitHeadersTest : public test::repo_fixture{};
+
+TEST_F( CommitHeadersTest, MatchesCommits )
+{
+    test::repo_shape shape;
+    shape.commits = 3000;
+    shape.branches = 3;
+    shape.merge_density = 0.3;
+
+    generate( shape );
+
+    const auto tip = mSource->tip( mSource->ref_names().back() );
+    const auto headers = mRepo->read_history_headers( tip );
+    ASSERT_TRUE( headers.missing().empty() );
+
+    std::map< std::string, std::shared_ptr< base::commit_wrapper > > commits;
+    for( const auto& commit : mRepo->walk( tip ) )
+    {
+        commits.emplace( oid_str( commit->id() ), commit );
+    }
+
+    ASSERT_EQ( headers.size(), commits.size() );
+
+    for( const auto& header : headers )
+    {
+        const auto commit = commits.at( oid_str( header.id ) );
+
+        ASSERT_EQ( header.time.time, commit->time().time );
+        ASSERT_EQ( header.time.offset, commit->time().offset );
+        ASSERT_EQ( headers.author_name( header ), commit->author_view() );
+        ASSERT_EQ( headers.author_email( header ), commit->author_email_view() );
+
+        const auto parents = commit->parents();
+        ASSERT_EQ( header.parents_count, parents.size() );
+        ASSERT_TRUE( std::equal( parents.begin(), parents.end(), headers.parents_begin( header ),
+                                 []( const git_oid& left, const git_oid& right ){ return git_oid_equal( &left, &right ) != 0; } ) );
+    }
+
+    // several workers read the same headers, in the order of the ids
+    std::vector< git_oid > all_ids;
+    for( const auto& header : headers )
+    {
+        all_ids.push_back( header.id );
+    }
+
+    const auto parallel = mRepo->read_commit_headers( all_ids, 4 );
+    ASSERT_EQ( parallel.size(), headers.size() );
+    for( size_t header_num = 0; header_num < parallel.size(); ++header_num )
+    {
+        ASSERT_TRUE( git_oid_equal( &parallel[ header_num ].id, &headers[ header_num ].id ) );
+        ASSERT_EQ( parallel.author_email( parallel[ header_num ] ), headers.author_email( headers[ header_num ] ) );
+    }
+
+    // the order of the ids is kept, unknown ids are reported
+    std::vector< git_oid > ids{ headers[ 2 ].id, git_oid{}, headers[ 0 ].id };
+    const auto picked = mRepo->read_commit_headers( ids );
+    ASSERT_EQ( picked.size(), 2u );
+    ASSERT_TRUE( git_oid_equal( &picked[ 0 ].id, &headers[ 2 ].id ) );
+    ASSERT_TRUE( git_oid_equal( &picked[ 1 ].id, &headers[ 0 ].id ) );
+    ASSERT_EQ( picked.missing().size(), 1u );
+}
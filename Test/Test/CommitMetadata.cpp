@@ -0,0 +1,230 @@
+#include <fstream>
+#include <cstddef>
+
+#include <boost/filesystem.hpp>
+
+#include "gtest/gtest.h"
+
+#include "GitBaseClasses.h"
+#include "Common/RepoGenerator.h"
+
+using namespace git_handler;
+
+class CommitMetadataTest : public testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        test::repo_shape shape;
+        shape.commits = 300;
+        shape.branches = 3;
+
+        mSource = std::make_unique< test::repo_generator >( mDir.sub( "source.git" ), shape );
+    }
+
+    std::shared_ptr< base::repo_wrapper > open_repo()
+    {
+        auto repo = std::make_shared< base::repo_wrapper >();
+        repo->open_local( mSource->path() );
+        repo->use_commit_metadata( mDir.sub( "metadata" ) );
+
+        return repo;
+    }
+
+    static void expect_same( const base::repo_wrapper::branches& left, const base::repo_wrapper::branches& right )
+    {
+        ASSERT_EQ( left.size(), right.size() );
+
+        for( const auto& branch : left )
+        {
+            auto other = right.find( branch.first );
+            ASSERT_TRUE( other != right.end() );
+
+            const auto& commits = branch.second->commits();
+            const auto& other_commits = other->second->commits();
+            ASSERT_EQ( commits.size(), other_commits.size() );
+
+            auto other_commit = other_commits.begin();
+            for( const auto& commit : commits )
+            {
+                ASSERT_TRUE( git_oid_equal( &commit.id, &other_commit->id ) );
+                ASSERT_EQ( commit.commit->author(), other_commit->commit->author() );
+                ASSERT_EQ( commit.commit->message(), other_commit->commit->message() );
+                ++other_commit;
+            }
+        }
+    }
+
+protected:
+    test::temp_path mDir;
+    std::unique_ptr< test::repo_generator > mSource;
+};
+
+TEST_F( CommitMetadataTest, RestoresSavedBranches )
+{
+    base::repo_wrapper::branches branches;
+    auto repo = open_repo();
+    repo->get_branches( branches );
+    repo->save_commit_metadata( branches );
+
+    base::repo_wrapper::branches restored;
+    auto restarted = open_repo();
+    restarted->get_branches( restored, false, 2 );
+
+    expect_same( branches, restored );
+
+    // the commits come from the file, not from the repo, their authors are interned all the same
+    for( const auto& commit : restored.begin()->second->commits() )
+    {
+        ASSERT_TRUE( commit.commit->is_lazy() );
+        ASSERT_EQ( commit.commit->author_id(),
+                   restarted->identities()->find( commit.commit->author_view(), commit.commit->author_email_view() ) );
+        ASSERT_NE( commit.commit->author_id(), base::identity_table::no_identity );
+    }
+}
+
+TEST_F( CommitMetadataTest, WalksOnlyTheDelta )
+{
+    {
+        base::repo_wrapper::branches branches;
+        auto repo = open_repo();
+        repo->get_branches( branches );
+        repo->save_commit_metadata( branches );
+    }
+
+    mSource->add_commits( 40 );
+
+    base::repo_wrapper::branches restored;
+    auto restarted = open_repo();
+    restarted->get_branches( restored );
+
+    base::repo_wrapper::branches fresh;
+    auto repo = std::make_shared< base::repo_wrapper >();
+    repo->open_local( mSource->path() );
+    repo->get_branches( fresh );
+
+    expect_same( fresh, restored );
+
+    // saved commits stay lazy, the ones added since then are read from the repo
+    size_t lazy_count{ 0 };
+    const auto& master = restored.at( test::repo_generator::master_ref )->commits();
+    for( const auto& commit : master )
+    {
+        lazy_count += commit.commit->is_lazy() ? 1 : 0;
+    }
+
+    ASSERT_GT( lazy_count, 0u );
+    ASSERT_LT( lazy_count, master.size() );
+}
+
+TEST_F( CommitMetadataTest, IgnoresInvalidFiles )
+{
+    {
+        std::ofstream file{ mDir.sub( "metadata" ), std::ios::binary };
+        file << "GHCMETA garbage";
+    }
+
+    base::repo_wrapper::branches branches;
+    auto repo = open_repo();
+    ASSERT_NO_THROW( repo->get_branches( branches ) );
+    ASSERT_FALSE( branches.empty() );
+}
+
+TEST_F( CommitMetadataTest, SkipsPartialBranches )
+{
+    base::repo_wrapper::branches full;
+    open_repo()->get_branches( full );
+
+    auto commits_count = []( const base::repo_wrapper::branches& storage )
+                         {
+                             size_t count{ 0 };
+                             for( const auto& branch : storage )
+                             {
+                                 count += branch.second->commits().size();
+                             }
+
+                             return count;
+                         };
+
+    auto repo = open_repo();
+    repo->set_walk_strategy( base::walk_strategy::first_parent );
+
+    base::repo_wrapper::branches partial;
+    repo->get_branches( partial );
+    ASSERT_TRUE( partial.begin()->second->is_partial() );
+    ASSERT_LT( commits_count( partial ), commits_count( full ) );
+
+    repo->save_commit_metadata( partial );
+
+    // the next run doesn't take the first parent chains for full histories
+    auto restarted = open_repo();
+    restarted->set_reachability_index( true );
+
+    base::repo_wrapper::branches restored;
+    ASSERT_TRUE( restarted->get_branches( restored ) );
+    expect_same( restored, full );
+
+    // nor does the same repo once it leaves first_parent, though the tips haven't moved
+    repo->set_walk_strategy( base::walk_strategy::time );
+    repo->get_branches( partial );
+    ASSERT_FALSE( partial.begin()->second->is_partial() );
+    expect_same( partial, full );
+}
+
+TEST_F( CommitMetadataTest, ReplacesMappedFile )
+{
+    base::repo_wrapper::branches branches;
+    auto repo = open_repo();
+    repo->get_branches( branches );
+    repo->save_commit_metadata( branches );
+
+    // the restored commits keep the file mapped while it is saved again
+    base::repo_wrapper::branches restored;
+    auto restarted = open_repo();
+    restarted->get_branches( restored );
+
+    mSource->add_commits( 10 );
+    restarted->get_branches( restored );
+    ASSERT_NO_THROW( restarted->save_commit_metadata( restored ) );
+
+    base::repo_wrapper::branches reloaded;
+    open_repo()->get_branches( reloaded );
+    expect_same( reloaded, restored );
+
+    // no temporary file is left behind
+    size_t files_count{ 0 };
+    for( boost::filesystem::directory_iterator entry{ mDir.str() }, end; entry != end; ++entry )
+    {
+        files_count += boost::filesystem::is_regular_file( entry->path() ) ? 1 : 0;
+    }
+
+    ASSERT_EQ( files_count, 1u );
+}
+
+TEST_F( CommitMetadataTest, IgnoresCorruptedRecords )
+{
+    base::repo_wrapper::branches branches;
+    auto repo = open_repo();
+    repo->get_branches( branches );
+    repo->save_commit_metadata( branches );
+
+    // points the message of the first commit record past the end of the file
+    {
+        std::fstream file{ mDir.sub( "metadata" ), std::ios::binary | std::ios::in | std::ios::out };
+
+        base::commit_metadata::file_header header;
+        file.read( reinterpret_cast< char* >( &header ), sizeof( header ) );
+
+        auto align = []( const uint64_t offset ){ return ( offset + 7 ) & ~uint64_t{ 7 }; };
+        const auto commits = align( align( sizeof( header ) ) + header.refs_count * sizeof( base::commit_metadata::ref_record ) );
+
+        const uint32_t message_size{ 0xffffffff };
+        file.seekp( commits + offsetof( base::commit_metadata::commit_record, message_size ) );
+        file.write( reinterpret_cast< const char* >( &message_size ), sizeof( message_size ) );
+    }
+
+    base::repo_wrapper::branches restored;
+    auto restarted = open_repo();
+    ASSERT_TRUE( restarted->get_branches( restored ) );
+    expect_same( restored, branches );
+}
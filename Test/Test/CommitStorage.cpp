@@ -0,0 +1,68 @@
+#include "gtest/gtest.h"
+
+#include "GitCommitStorage.h"
+#include "Common/RepoFixture.h"
+
+using namespace git_handler;
+using test::make_id;
+
+TEST( CommitStorageTest, KeepsTimeOrder )
+{
+    base::commit_storage storage;
+    storage.add( { { 30, make_id( 3 ), nullptr },
+                   { 10, make_id( 1 ), nullptr },
+                   { 20, make_id( 2 ), nullptr } } );
+
+    // newer commits are appended, older ones are merged in
+    storage.add( { { 40, make_id( 4 ), nullptr } } );
+    storage.add( { { 5, make_id( 5 ), nullptr } } );
+
+    std::vector< git_time_t > times;
+    for( const auto& commit : storage )
+    {
+        times.push_back( commit.time );
+    }
+
+    ASSERT_EQ( times, ( std::vector< git_time_t >{ 5, 10, 20, 30, 40 } ) );
+
+    for( unsigned char seed = 1; seed <= 5; ++seed )
+    {
+        auto id = make_id( seed );
+        auto commit = storage.find( id );
+        ASSERT_TRUE( commit != nullptr );
+        ASSERT_TRUE( git_oid_equal( &commit->id, &id ) );
+    }
+}
+
+TEST( CommitStorageTest, DeduplicatesById )
+{
+    base::commit_storage storage;
+
+    ASSERT_EQ( storage.add( { { 10, make_id( 1 ), nullptr },
+                              { 10, make_id( 1 ), nullptr },
+                              { 10, make_id( 2 ), nullptr } } ), 2u );
+
+    ASSERT_FALSE( storage.add( { 10, make_id( 2 ), nullptr } ) );
+    ASSERT_EQ( storage.size(), 2u );
+    ASSERT_FALSE( storage.contains( make_id( 3 ) ) );
+}
+
+TEST( CommitStorageTest, TimeRange )
+{
+    base::commit_storage storage;
+    base::commit_storage::entries batch;
+
+    for( unsigned char seed = 1; seed <= 100; ++seed )
+    {
+        batch.push_back( { seed * 10, make_id( seed ), nullptr } );
+    }
+
+    storage.add( std::move( batch ) );
+
+    auto range = storage.time_range( 95, 200 );
+    ASSERT_EQ( std::distance( range.first, range.second ), 11 );
+    ASSERT_EQ( range.first->time, 100 );
+
+    range = storage.time_range( 2000, 3000 );
+    ASSERT_TRUE( range.first == range.second );
+}
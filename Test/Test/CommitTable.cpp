@@ -0,0 +1,150 @@
+#include "gtest/gtest.h"
+
+#include "GitBaseClasses.h"
+#include "details/CommitHeaderParser.h"
+#include "Common/RepoFixture.h"
+
+using namespace git_handler;
+
+class CommitTableTest : public test::repo_fixture{};
+
+TEST_F( CommitTableTest, MatchesBranches )
+{
+    test::repo_shape shape;
+    shape.commits = 2000;
+    shape.branches = 3;
+    shape.authors = 5;
+
+    generate( shape );
+
+    base::repo_wrapper::branches branches;
+    mRepo->get_branches( branches );
+
+    const auto table = mRepo->read_commit_table( branches, 3 );
+    ASSERT_EQ( table.size(), shape.commits );
+    ASSERT_TRUE( table.missing().empty() );
+    ASSERT_EQ( table.identities()->size(), shape.authors );
+    ASSERT_EQ( table.identities(), mRepo->identities() );
+
+    // the same table built from the commit wrappers
+    base::commit_table wrapped;
+    for( const auto& branch : branches )
+    {
+        wrapped.add( branch.second->commits() );
+    }
+
+    ASSERT_EQ( wrapped.size(), table.size() );
+
+    for( const auto& branch : branches )
+    {
+        for( const auto& commit : branch.second->commits() )
+        {
+            const auto row = table.find( commit.id );
+            ASSERT_LT( row, table.size() );
+            ASSERT_EQ( table.time( row ), commit.time );
+            ASSERT_EQ( table.message( row ), commit.commit->message_view() );
+            ASSERT_EQ( table.author_name( table.author( row ) ), commit.commit->author_view() );
+            ASSERT_EQ( static_cast< size_t >( table.parents_end( row ) - table.parents_begin( row ) ), commit.commit->parents().size() );
+
+            const auto wrapped_row = wrapped.find( commit.id );
+            ASSERT_EQ( wrapped.author_email( wrapped.author( wrapped_row ) ), table.author_email( table.author( row ) ) );
+        }
+    }
+
+    // scans against plain loops
+    const base::commit_table::author_id author{ table.author( 0 ) };
+    ASSERT_EQ( table.find_author( table.author_name( author ), table.author_email( author ) ), author );
+    ASSERT_EQ( table.find_author( "nobody", "nobody@example.com" ), base::commit_table::no_author );
+
+    git_time_t first{ table.time( 0 ) };
+    git_time_t last{ table.time( 0 ) };
+    for( base::commit_table::row row = 0; row < table.size(); ++row )
+    {
+        first = std::min( first, table.time( row ) );
+        last = std::max( last, table.time( row ) );
+    }
+
+    const git_time_t from{ first + ( last - first ) / 4 };
+    const git_time_t to{ last - ( last - first ) / 4 };
+
+    std::vector< base::commit_table::row > expected;
+    for( base::commit_table::row row = 0; row < table.size(); ++row )
+    {
+        if( table.author( row ) == author && table.time( row ) >= from && table.time( row ) <= to )
+        {
+            expected.push_back( row );
+        }
+    }
+
+    ASSERT_FALSE( expected.empty() );
+    ASSERT_EQ( table.filter( author, from, to ), expected );
+    ASSERT_EQ( table.count( author, from, to ), expected.size() );
+    ASSERT_EQ( table.count( base::commit_table::any_author, first, last ), table.size() );
+
+    const auto days = table.daily_counts( author, from, to );
+    ASSERT_EQ( days.size(), static_cast< size_t >( to / 86400 - from / 86400 + 1 ) );
+
+    size_t days_total{ 0 };
+    for( const auto day : days )
+    {
+        days_total += day;
+    }
+
+    ASSERT_EQ( days_total, expected.size() );
+    ASSERT_EQ( days.front(), table.count( author, from, ( from / 86400 + 1 ) * 86400 - 1 ) );
+    ASSERT_TRUE( table.daily_counts( author, to, from ).empty() );
+
+    const auto authors = table.author_counts( from, to );
+    ASSERT_EQ( authors.size(), table.identities()->size() );
+    ASSERT_EQ( authors[ author ], expected.size() );
+}
+
+TEST_F( CommitTableTest, AuthorTimes )
+{
+    test::repo_shape shape;
+    shape.commits = 20;
+    shape.branches = 0;
+
+    generate( shape );
+    const git_oid rebased = mSource->add_commit( test::repo_generator::master_ref, 1000, 2000000000 );
+
+    base::repo_wrapper::branches branches;
+    mRepo->get_branches( branches );
+
+    // raw objects and commit wrappers agree on the author time
+    const auto raw = mRepo->read_commit_table( std::vector< git_oid >{ rebased } );
+    base::commit_table wrapped;
+    wrapped.add( branches.begin()->second->commits() );
+
+    ASSERT_EQ( raw.time( raw.find( rebased ) ), 1000 );
+    ASSERT_EQ( wrapped.time( wrapped.find( rebased ) ), 1000 );
+
+    wrapped.append( raw );
+    ASSERT_EQ( wrapped.count( base::commit_table::any_author, 0, 1000 ), 1u );
+}
+
+TEST_F( CommitTableTest, MalformedParents )
+{
+    const std::string parents{ "parent 0123456789abcdef0123456789abcdef01234567\n"
+                               "parent 0123456789abcdef0123456789abcdef0123456z\n" };
+
+    details::commit_header_fields fields;
+    fields.parents = parents.data();
+    fields.parents_count = 2;
+    fields.author.name = "Jane Doe";
+    fields.author.email = "jane@example.com";
+
+    git_oid id{};
+    id.id[ 0 ] = 1;
+
+    base::commit_table table;
+    table.add( id, fields );
+    ASSERT_TRUE( table.empty() );
+    ASSERT_EQ( table.missing().size(), 1u );
+    ASSERT_TRUE( git_oid_equal( &table.missing().front(), &id ) );
+
+    fields.parents_count = 1;
+    table.add( id, fields );
+    ASSERT_EQ( table.size(), 1u );
+    ASSERT_EQ( table.parents_end( 0 ) - table.parents_begin( 0 ), 1 );
+}
@@ -0,0 +1,110 @@
+#include "gtest/gtest.h"
+
+#include "GitBaseClasses.h"
+#include "Common/RepoFixture.h"
+
+using namespace git_handler;
+
+namespace
+{
+
+void expect_views( const base::commit_wrapper& commit )
+{
+    const auto message = commit.message();
+    ASSERT_EQ( commit.message_view(), message );
+    ASSERT_EQ( commit.author_view(), commit.author() );
+    ASSERT_EQ( commit.summary_view(), message.substr( 0, message.find( '\n' ) ) );
+    ASSERT_EQ( commit.summary_view().substr( 0, 7 ), "Commit " );
+    ASSERT_EQ( commit.author_email_view(), commit.author_view().to_string() + "@example.com" );
+    ASSERT_EQ( commit.committer_view(), commit.author_view() );
+    ASSERT_EQ( commit.raw_header_view().substr( 0, 5 ), "tree " );
+}
+
+}
+
+class CommitViewsTest : public test::repo_fixture{};
+
+TEST_F( CommitViewsTest, AllCommitKinds )
+{
+    test::repo_shape shape;
+    shape.commits = 50;
+    shape.message_size = 200;
+
+    generate( shape );
+    auto eager = mRepo;
+
+    // a tiny cache, so that the views must survive the lazy commits being evicted
+    auto lazy = open_repo();
+    lazy->set_lazy_commits( true, 2 );
+
+    auto saved = open_repo();
+    saved->use_commit_metadata( mDir.sub( "metadata" ) );
+
+    for( auto repo : { eager, lazy, saved } )
+    {
+        base::repo_wrapper::branches branches;
+        repo->get_branches( branches );
+
+        if( repo == saved )
+        {
+            repo->save_commit_metadata( branches );
+            branches.clear();
+            repo->use_commit_metadata( mDir.sub( "metadata" ) );
+            repo->get_branches( branches );
+        }
+
+        std::vector< boost::string_view > summaries;
+        for( const auto& commit : branches.at( test::repo_generator::master_ref )->commits() )
+        {
+            expect_views( *commit.commit );
+            summaries.push_back( commit.commit->summary_view() );
+        }
+
+        // still valid after the other commits have been read
+        size_t summary_num{ 0 };
+        for( const auto& commit : branches.at( test::repo_generator::master_ref )->commits() )
+        {
+            const auto& summary = summaries[ summary_num++ ];
+            ASSERT_EQ( summary, commit.commit->message().substr( 0, summary.size() ) );
+        }
+    }
+}
+
+TEST_F( CommitViewsTest, PinsUntilUnpinned )
+{
+    test::repo_shape shape;
+    shape.commits = 50;
+    shape.branches = 0;
+
+    generate( shape );
+    mRepo->set_lazy_commits( true, 2 );
+
+    auto branch = mRepo->get_branch( test::repo_generator::master_ref );
+
+    // the views keep every commit loaded, whatever the cache budget
+    for( const auto& commit : branch->commits() )
+    {
+        ASSERT_FALSE( commit.commit->is_pinned() );
+        ASSERT_FALSE( commit.commit->summary_view().empty() );
+        ASSERT_TRUE( commit.commit->is_pinned() );
+    }
+
+    // once unpinned only the cache holds them, and new views load them again
+    for( const auto& commit : branch->commits() )
+    {
+        commit.commit->unpin();
+        ASSERT_FALSE( commit.commit->is_pinned() );
+        ASSERT_EQ( commit.commit->message_view(), commit.commit->message() );
+        commit.commit->unpin();
+    }
+
+    // one-off readers leave them as they were
+    const auto& pinned = *branch->commits().begin()->commit;
+    pinned.summary_view();
+
+    for( const auto& commit : branch->commits() )
+    {
+        base::aux::get_commit_message_str( commit.commit.get() );
+        ASSERT_EQ( commit.commit->is_pinned(), commit.commit.get() == &pinned );
+    }
+}
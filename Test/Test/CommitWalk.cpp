@@ -0,0 +1,186 @@
+#include <map>
+#include <set>
+#include <algorithm>
+
+#include "gtest/gtest.h"
+
+#include "GitBaseClasses.h"
+#include "Common/RepoGenerator.h"
+
+using namespace git_handler;
+
+namespace
+{
+
+std::string oid_str( const git_oid& id )
+{
+    char id_str[ GIT_OID_HEXSZ + 1 ];
+    git_oid_tostr( id_str, sizeof( id_str ), &id );
+    return id_str;
+}
+
+}
+
+class CommitWalkTest : public testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        test::repo_shape shape;
+        shape.commits = 300;
+        shape.branches = 3;
+        shape.merge_density = 0.3;
+
+        mSource = std::make_unique< test::repo_generator >( mDir.sub( "source.git" ), shape );
+
+        mRepo = std::make_shared< base::repo_wrapper >();
+        mRepo->open_local( mSource->path() );
+
+        // the other branches merge master, so their first parent chains are shorter than their histories
+        mRefName = mSource->ref_names().back();
+    }
+
+    std::vector< std::shared_ptr< base::commit_wrapper > > walk( const base::walk_strategy strategy, const git_time_t since = 0 )
+    {
+        base::walk_options options;
+        options.strategy = strategy;
+        options.since = since;
+
+        std::vector< std::shared_ptr< base::commit_wrapper > > commits;
+        for( const auto& commit : mRepo->walk( mRefName, options ) )
+        {
+            commits.push_back( commit );
+        }
+
+        return commits;
+    }
+
+protected:
+    test::temp_path mDir;
+    std::unique_ptr< test::repo_generator > mSource;
+    std::shared_ptr< base::repo_wrapper > mRepo;
+    std::string mRefName;
+};
+
+TEST_F( CommitWalkTest, Strategies )
+{
+    const auto by_time = walk( base::walk_strategy::time );
+    const auto topological = walk( base::walk_strategy::topological );
+    const auto reverse = walk( base::walk_strategy::reverse );
+    const auto first_parent = walk( base::walk_strategy::first_parent );
+
+    ASSERT_FALSE( by_time.empty() );
+    ASSERT_EQ( topological.size(), by_time.size() );
+    ASSERT_EQ( reverse.size(), by_time.size() );
+
+    ASSERT_TRUE( std::is_sorted( by_time.begin(), by_time.end(),
+                                 []( const auto& left, const auto& right ){ return left->time().time > right->time().time; } ) );
+
+    // every parent comes after its children
+    std::map< std::string, size_t > positions;
+    for( size_t commit_num = 0; commit_num < topological.size(); ++commit_num )
+    {
+        positions[ oid_str( topological[ commit_num ]->id() ) ] = commit_num;
+    }
+
+    for( size_t commit_num = 0; commit_num < topological.size(); ++commit_num )
+    {
+        for( const auto& parent : topological[ commit_num ]->parents() )
+        {
+            ASSERT_GT( positions.at( oid_str( parent ) ), commit_num );
+        }
+    }
+
+    ASSERT_TRUE( std::equal( reverse.begin(), reverse.end(), topological.rbegin(),
+                             []( const auto& left, const auto& right ){ return oid_str( left->id() ) == oid_str( right->id() ); } ) );
+
+    // the first parent chain from the tip down to the root
+    ASSERT_LT( first_parent.size(), by_time.size() );
+    for( size_t commit_num = 0; commit_num + 1 < first_parent.size(); ++commit_num )
+    {
+        const auto parent = first_parent[ commit_num + 1 ]->id();
+        ASSERT_TRUE( git_oid_equal( &first_parent[ commit_num ]->parents().front(), &parent ) );
+    }
+
+    ASSERT_TRUE( first_parent.back()->parents().empty() );
+}
+
+TEST_F( CommitWalkTest, SinceAndBranchReads )
+{
+    const auto by_time = walk( base::walk_strategy::time );
+    const git_time_t since{ by_time[ by_time.size() / 2 ]->time().time };
+
+    auto newer = []( const std::vector< std::shared_ptr< base::commit_wrapper > >& commits, const git_time_t since )
+                 {
+                     return std::all_of( commits.begin(), commits.end(), [ & ]( const auto& commit ){ return commit->time().time >= since; } );
+                 };
+
+    // the reverse walk skips the old commits instead of ending on them
+    const auto recent = walk( base::walk_strategy::time, since );
+    const auto recent_reverse = walk( base::walk_strategy::reverse, since );
+    ASSERT_FALSE( recent.empty() );
+    ASSERT_EQ( recent_reverse.size(), recent.size() );
+    ASSERT_TRUE( newer( recent, since ) );
+    ASSERT_TRUE( newer( recent_reverse, since ) );
+
+    mRepo->set_walk_strategy( base::walk_strategy::first_parent );
+    auto branch = mRepo->get_branch( mRefName );
+    ASSERT_EQ( branch->commits().size(), walk( base::walk_strategy::first_parent ).size() );
+
+    mRepo->set_walk_strategy( base::walk_strategy::topological );
+    auto full_branch = mRepo->get_branch( mRefName );
+    ASSERT_EQ( full_branch->commits().size(), by_time.size() );
+}
+
+TEST_F( CommitWalkTest, SinceSkewedDates )
+{
+    // a rebased commit keeps its old author date but sits on top of newer commits
+    const git_time_t now{ mRepo->walk( test::repo_generator::master_ref ).next()->time().time };
+    mSource->add_commit( test::repo_generator::master_ref, 1000, now + 60 );
+    for( git_time_t commit_num = 2; commit_num < 5; ++commit_num )
+    {
+        mSource->add_commit( test::repo_generator::master_ref, now + commit_num * 60, now + commit_num * 60 );
+    }
+
+    mRefName = test::repo_generator::master_ref;
+    const auto all = walk( base::walk_strategy::topological );
+    const git_time_t since{ now - 50 * 60 };
+
+    std::set< std::string > expected;
+    for( const auto& commit : all )
+    {
+        if( commit->time().time >= since )
+        {
+            expected.insert( oid_str( commit->id() ) );
+        }
+    }
+
+    auto ids = []( const std::vector< std::shared_ptr< base::commit_wrapper > >& commits )
+               {
+                   std::set< std::string > result;
+                   for( const auto& commit : commits )
+                   {
+                       result.insert( oid_str( commit->id() ) );
+                   }
+
+                   return result;
+               };
+
+    ASSERT_GT( expected.size(), 5u );
+    ASSERT_EQ( ids( walk( base::walk_strategy::time, since ) ), expected );
+    ASSERT_EQ( ids( walk( base::walk_strategy::first_parent, since ) ), expected );
+    ASSERT_EQ( ids( walk( base::walk_strategy::reverse, since ) ), expected );
+
+    // hiding commits falls back to a revwalk sorted by committer time
+    base::walk_options options;
+    options.since = since;
+    options.hide.push_back( all.back()->id() );
+
+    std::vector< std::shared_ptr< base::commit_wrapper > > hidden_walk;
+    for( const auto& commit : mRepo->walk( mRefName, options ) )
+    {
+        hidden_walk.push_back( commit );
+    }
+
+    ASSERT_EQ( ids( hidden_walk ), expected );
+}
@@ -0,0 +1,53 @@
+#include "gtest/gtest.h"
+
+#include "GitBaseClasses.h"
+#include "Common/RepoFixture.h"
+
+using namespace git_handler;
+
+class DiffStatsTest : public test::repo_fixture{};
+
+TEST_F( DiffStatsTest, ComputesAndCaches )
+{
+    test::repo_shape shape;
+    shape.commits = 500;
+    shape.branches = 2;
+    shape.merge_density = 0.3;
+
+    generate( shape );
+
+    const auto headers = mRepo->read_history_headers( mSource->tip( mSource->ref_names().back() ) );
+    std::vector< git_oid > ids;
+    for( const auto& header : headers )
+    {
+        ids.push_back( header.id );
+    }
+
+    const auto stats = mRepo->read_diff_stats( ids, 4 );
+    ASSERT_EQ( stats.size(), ids.size() );
+    ASSERT_EQ( mRepo->diff_cache().size(), ids.size() );
+
+    // every generated commit rewrites the single line of its single file
+    for( size_t commit_num = 0; commit_num < headers.size(); ++commit_num )
+    {
+        const bool root{ headers[ commit_num ].parents_count == 0 };
+
+        ASSERT_EQ( stats[ commit_num ].files_changed, 1u );
+        ASSERT_EQ( stats[ commit_num ].insertions, 1u );
+        ASSERT_EQ( stats[ commit_num ].deletions, root ? 0u : 1u );
+    }
+
+    // cached commits come back in the order asked for, repeated ones included
+    std::vector< git_oid > picked{ ids[ 3 ], ids[ 1 ], ids[ 3 ] };
+    const auto cached = mRepo->read_diff_stats( picked );
+    ASSERT_EQ( cached.size(), 3u );
+    ASSERT_EQ( cached[ 0 ].deletions, stats[ 3 ].deletions );
+    ASSERT_EQ( cached[ 2 ].deletions, stats[ 3 ].deletions );
+    ASSERT_EQ( mRepo->diff_cache().size(), ids.size() );
+
+    base::diff_stats found;
+    ASSERT_TRUE( mRepo->diff_cache().find( ids[ 1 ], found ) );
+    ASSERT_EQ( found.insertions, stats[ 1 ].insertions );
+
+    ASSERT_THROW( mRepo->read_diff_stats( { git_oid{} }, 2 ), std::runtime_error );
+}
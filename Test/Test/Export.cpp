@@ -0,0 +1,232 @@
+#include <cstring>
+#include <climits>
+#include <iterator>
+
+#include "gtest/gtest.h"
+
+#include "GitExport.h"
+#include "details/TextFormat.h"
+#include "Common/RepoFixture.h"
+
+using namespace git_handler;
+
+namespace
+{
+
+std::string iso_time( const int64_t time, const int offset )
+{
+    char buffer[ details::iso_time_length ];
+    return { buffer, details::format_iso_time( time, offset, buffer ) };
+}
+
+std::string int_str( const int64_t value )
+{
+    char buffer[ details::max_int_length + 1 ];
+    return { buffer, details::format_int( value, buffer ) };
+}
+
+uint64_t read_uint( const std::string& data, size_t& pos, const size_t size )
+{
+    uint64_t value{ 0 };
+    for( size_t byte_num = 0; byte_num < size; ++byte_num )
+    {
+        value |= uint64_t{ static_cast< unsigned char >( data[ pos + byte_num ] ) } << ( 8 * byte_num );
+    }
+
+    pos += size;
+    return value;
+}
+
+std::string read_sized( const std::string& data, size_t& pos )
+{
+    const size_t size{ read_uint( data, pos, 4 ) };
+    pos += size;
+    return data.substr( pos - size, size );
+}
+
+}
+
+TEST( TextFormatTest, Formatters )
+{
+    ASSERT_EQ( int_str( 0 ), "0" );
+    ASSERT_EQ( int_str( -42 ), "-42" );
+    ASSERT_EQ( int_str( INT64_MIN ), "-9223372036854775808" );
+    ASSERT_EQ( int_str( INT64_MAX ), "9223372036854775807" );
+
+    ASSERT_EQ( iso_time( 1500000000, 0 ), "2017-07-14T02:40:00+00:00" );
+    ASSERT_EQ( iso_time( 1500000000, -330 ), "2017-07-13T21:10:00-05:30" );
+    ASSERT_EQ( iso_time( 951825600, 0 ), "2000-02-29T12:00:00+00:00" );
+    ASSERT_EQ( iso_time( -1, 0 ), "1969-12-31T23:59:59+00:00" );
+
+    char escaped[ details::max_json_escape_length ];
+    ASSERT_EQ( std::string( escaped, details::escape_json_char( '"', escaped ) ), "\\\"" );
+    ASSERT_EQ( std::string( escaped, details::escape_json_char( '\n', escaped ) ), "\\n" );
+    ASSERT_EQ( std::string( escaped, details::escape_json_char( 0x01, escaped ) ), "\\u0001" );
+    ASSERT_EQ( std::string( escaped, details::escape_json_char( 0xc3, escaped ) ), "\\u00c3" );
+
+    // valid UTF-8 is kept, invalid bytes are escaped one by one
+    auto json = []( const std::string& text )
+                {
+                    std::string result( text.size() * details::max_json_escape_length + details::max_json_escape_length, '\0' );
+                    const char* in{ text.data() };
+                    char* end{ details::escape_json( in, text.data() + text.size(), &result[ 0 ], &result[ 0 ] + result.size() ) };
+                    result.resize( end - result.data() );
+                    return result;
+                };
+
+    ASSERT_EQ( json( "caf\xc3\xa9 \xe2\x9c\x93 \xf0\x9f\x98\x80" ), "caf\xc3\xa9 \xe2\x9c\x93 \xf0\x9f\x98\x80" );
+    ASSERT_EQ( json( "caf\xe9" ), "caf\\u00e9" );
+    // overlong, surrogate, above U+10FFFF, truncated
+    ASSERT_EQ( json( "\xc0\xaf" ), "\\u00c0\\u00af" );
+    ASSERT_EQ( json( "\xed\xa0\x80" ), "\\u00ed\\u00a0\\u0080" );
+    ASSERT_EQ( json( "\xf4\x90\x80\x80" ), "\\u00f4\\u0090\\u0080\\u0080" );
+    ASSERT_EQ( json( "\xe2\x9c" ), "\\u00e2\\u009c" );
+}
+
+class ExportTest : public test::repo_fixture
+{
+protected:
+    virtual void SetUp()
+    {
+        test::repo_shape shape;
+        shape.commits = 300;
+        shape.branches = 3;
+        shape.merge_density = 0.3;
+
+        generate( shape );
+        mRepo->get_branches( mBranches );
+    }
+
+protected:
+    base::repo_wrapper::branches mBranches;
+};
+
+TEST_F( ExportTest, JsonLines )
+{
+    const auto& master = *mBranches.at( test::repo_generator::master_ref );
+
+    std::string output;
+    base::buffer_sink sink{ output };
+
+    {
+        // a small buffer, so that the messages don't fit in it
+        base::commit_exporter exporter{ sink, base::export_format::json_lines, 16 };
+        exporter.write( master );
+        ASSERT_EQ( exporter.commits_count(), master.commits().size() );
+    }
+
+    ASSERT_EQ( static_cast< size_t >( std::count( output.begin(), output.end(), '\n' ) ), master.commits().size() );
+
+    // newest first, the storage itself is sorted oldest first
+    const std::string first_line{ output.substr( 0, output.find( '\n' ) ) };
+    const std::string last_line{ output.substr( output.rfind( '\n', output.size() - 2 ) + 1 ) };
+
+    auto expect_line = []( const std::string& line, const base::commit_storage::entry& entry )
+                       {
+                           char id[ GIT_OID_HEXSZ + 1 ];
+                           git_oid_tostr( id, sizeof( id ), &entry.id );
+
+                           std::string message;
+                           for( const char c : entry.commit->message() )
+                           {
+                               message += c == '\n' ? std::string{ "\\n" } : std::string( 1, c );
+                           }
+
+                           const auto time = entry.commit->time();
+
+                           ASSERT_EQ( line.find( "{\"ref\":\"refs/heads/master\",\"id\":\"" + std::string{ id } + "\"" ), 0u );
+                           ASSERT_NE( line.find( "\"time\":" + std::to_string( time.time ) + ",\"offset\":0,\"date\":\"" + iso_time( time.time, 0 ) + "\"" ),
+                                      std::string::npos );
+                           ASSERT_NE( line.find( "\"author\":\"" + entry.commit->author() + "\"" ), std::string::npos );
+                           ASSERT_NE( line.find( "\"message\":\"" + message + "\"}" ), std::string::npos );
+                       };
+
+    const auto& newest = *std::prev( master.commits().end() );
+    const auto& oldest = *master.commits().begin();
+    ASSERT_GE( newest.time, oldest.time );
+
+    expect_line( first_line, newest );
+    expect_line( last_line, oldest );
+}
+
+TEST_F( ExportTest, Binary )
+{
+    std::string output;
+    base::buffer_sink sink{ output };
+
+    size_t commits_count{ 0 };
+
+    {
+        base::commit_exporter exporter{ sink, base::export_format::binary };
+        exporter.write( mBranches );
+        exporter.flush();
+        commits_count = exporter.commits_count();
+    }
+
+    ASSERT_EQ( output.compare( 0, 8, base::commit_exporter::binary_magic, 8 ), 0 );
+
+    size_t pos{ 8 };
+    size_t records{ 0 };
+
+    for( const auto& branch : mBranches )
+    {
+        const auto& commits = branch.second->commits();
+        for( auto entry = commits.end(); entry != commits.begin(); )
+        {
+            const auto& commit = *--entry;
+            const size_t record_end{ read_uint( output, pos, 4 ) + pos };
+
+            ASSERT_EQ( std::memcmp( output.data() + pos, commit.id.id, GIT_OID_RAWSZ ), 0 );
+            pos += GIT_OID_RAWSZ;
+
+            ASSERT_EQ( static_cast< int64_t >( read_uint( output, pos, 8 ) ), commit.commit->time().time );
+            ASSERT_EQ( read_uint( output, pos, 2 ), 0u );
+
+            const auto parents = commit.commit->parents();
+            ASSERT_EQ( read_uint( output, pos, 2 ), parents.size() );
+
+            for( const auto& parent : parents )
+            {
+                ASSERT_EQ( std::memcmp( output.data() + pos, parent.id, GIT_OID_RAWSZ ), 0 );
+                pos += GIT_OID_RAWSZ;
+            }
+
+            ASSERT_EQ( read_sized( output, pos ), branch.second->ref_name() );
+            ASSERT_EQ( read_sized( output, pos ), commit.commit->author() );
+            ASSERT_EQ( read_sized( output, pos ), commit.commit->author() + "@example.com" );
+            ASSERT_EQ( read_sized( output, pos ), commit.commit->message() );
+            ASSERT_EQ( pos, record_end );
+
+            ++records;
+        }
+    }
+
+    ASSERT_EQ( records, commits_count );
+    ASSERT_EQ( pos, output.size() );
+}
+
+TEST_F( ExportTest, NonUtf8Messages )
+{
+    // a Latin-1 message, as written by tools that set the encoding header
+    mSource->add_commit( test::repo_generator::master_ref, 2000000000, 2000000000, "Caf\xe9 cr\xe8me\n" );
+
+    auto branch = mRepo->get_branch( test::repo_generator::master_ref );
+
+    std::string output;
+    base::buffer_sink sink{ output };
+
+    {
+        base::commit_exporter exporter{ sink, base::export_format::json_lines };
+        exporter.write( *branch );
+    }
+
+    ASSERT_NE( output.find( "\"message\":\"Caf\\u00e9 cr\\u00e8me\\n\"" ), std::string::npos );
+
+    // the whole output is valid UTF-8
+    for( const char* in = output.data(); in != output.data() + output.size(); )
+    {
+        const size_t length{ details::utf8_sequence_length( in, output.data() + output.size() ) };
+        ASSERT_NE( length, 0u );
+        in += length;
+    }
+}
@@ -0,0 +1,141 @@
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "GitHandler.h"
+#include "Common/RepoGenerator.h"
+
+using namespace git_handler;
+
+TEST( IdentityTableTest, Interns )
+{
+    base::identity_table identities;
+
+    const auto jane = identities.intern( "Jane Doe", "jane@example.com" );
+    const auto john = identities.intern( "John Roe", "john@example.com" );
+    // the same name with another email is another identity
+    const auto other_jane = identities.intern( "Jane Doe", "doe@example.com" );
+
+    ASSERT_EQ( identities.size(), 3u );
+    ASSERT_EQ( identities.intern( std::string{ "Jane Doe" }, std::string{ "jane@example.com" } ), jane );
+    ASSERT_NE( jane, john );
+    ASSERT_NE( jane, other_jane );
+
+    ASSERT_EQ( identities.find( "John Roe", "john@example.com" ), john );
+    ASSERT_EQ( identities.find( "John Roe", "roe@example.com" ), base::identity_table::no_identity );
+    ASSERT_EQ( identities.name( other_jane ), "Jane Doe" );
+    ASSERT_EQ( identities.email( other_jane ), "doe@example.com" );
+
+    // views stay valid while the table grows
+    const auto name = identities.name( jane );
+    for( int identity = 0; identity < 1000; ++identity )
+    {
+        identities.intern( "author " + std::to_string( identity ), "author@example.com" );
+    }
+
+    ASSERT_EQ( name, "Jane Doe" );
+
+    // concurrent interning agrees on the ids
+    std::vector< std::vector< base::identity_table::identity_id > > ids( 4 );
+    std::vector< std::thread > threads;
+    for( size_t thread_num = 0; thread_num < ids.size(); ++thread_num )
+    {
+        threads.emplace_back( [ &, thread_num ]()
+                              {
+                                  for( int identity = 0; identity < 500; ++identity )
+                                  {
+                                      ids[ thread_num ].push_back( identities.intern( "concurrent " + std::to_string( identity ), "" ) );
+                                  }
+                              } );
+    }
+
+    for( auto& thread : threads )
+    {
+        thread.join();
+    }
+
+    for( const auto& thread_ids : ids )
+    {
+        ASSERT_EQ( thread_ids, ids.front() );
+    }
+
+    ASSERT_EQ( identities.size(), 1003u + 500u );
+}
+
+TEST( IdentityTableTest, SharedByHandlerRepos )
+{
+    test::temp_path dir;
+    test::repo_shape shape;
+    shape.commits = 200;
+    shape.authors = 6;
+
+    test::repo_generator first{ dir.sub( "first.git" ), shape };
+    shape.seed = 7;
+    test::repo_generator second{ dir.sub( "second.git" ), shape };
+
+    git_handler::git_handler handler;
+    for( const auto& source : { &first, &second } )
+    {
+        auto repo = std::make_unique< base::repo_wrapper >();
+        repo->open_local( source->path() );
+        ASSERT_TRUE( handler.add_repo( std::move( repo ), "", "" ) );
+    }
+
+    std::vector< base::commit_headers > headers;
+    for( const auto& repo : handler.get_repos() )
+    {
+        const auto snapshot = repo.second->snapshot_refs();
+        auto tip = snapshot.find( test::repo_generator::master_ref );
+        ASSERT_TRUE( tip != nullptr );
+        headers.push_back( repo.second->read_history_headers( tip->tip ) );
+    }
+
+    // both repos draw from the same authors, so they share the ids
+    ASSERT_EQ( headers.size(), 2u );
+    ASSERT_LE( handler.get_identities()->size(), shape.authors );
+
+    for( const auto& repo_headers : headers )
+    {
+        ASSERT_EQ( repo_headers.identities(), handler.get_identities() );
+
+        for( const auto& header : repo_headers )
+        {
+            ASSERT_EQ( handler.get_identities()->find( repo_headers.author_name( header ), repo_headers.author_email( header ) ), header.author );
+        }
+    }
+}
+
+TEST( IdentityTableTest, CommitAuthorIds )
+{
+    test::temp_path dir;
+    test::repo_shape shape;
+    shape.commits = 200;
+    shape.branches = 2;
+    shape.authors = 5;
+
+    test::repo_generator source{ dir.sub( "source.git" ), shape };
+
+    for( const bool lazy : { false, true } )
+    {
+        base::repo_wrapper repo;
+        repo.open_local( source.path() );
+        repo.set_lazy_commits( lazy );
+
+        base::repo_wrapper::branches branches;
+        repo.get_branches( branches, false, 2 );
+        ASSERT_FALSE( branches.empty() );
+
+        for( const auto& branch : branches )
+        {
+            for( const auto& commit : branch.second->commits() )
+            {
+                const auto author = commit.commit->author_id();
+                ASSERT_NE( author, base::identity_table::no_identity );
+                ASSERT_EQ( repo.identities()->name( author ), commit.commit->author_view() );
+                ASSERT_EQ( repo.identities()->email( author ), commit.commit->author_email_view() );
+            }
+        }
+
+        ASSERT_LE( repo.identities()->size(), shape.authors );
+    }
+}
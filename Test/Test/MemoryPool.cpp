@@ -0,0 +1,106 @@
+#include <thread>
+#include <cstring>
+
+#include "gtest/gtest.h"
+
+#include "details/MemoryPool.h"
+
+TEST( MemoryPoolTest, ReturnsEmptySlabs )
+{
+    // small slabs, so that a few thousand blocks span many of them
+    details::memory_pool pool{ 4096, 1 };
+
+    std::vector< void* > blocks;
+    for( size_t block_num = 0; block_num < 10000; ++block_num )
+    {
+        blocks.push_back( pool.allocate( 48 ) );
+        std::memset( blocks.back(), int( block_num ), 48 );
+    }
+
+    ASSERT_GT( pool.slabs_count(), 100u );
+
+    // blocks are reused before new slabs are made
+    pool.deallocate( blocks[ 5000 ], 48 );
+    ASSERT_EQ( pool.allocate( 40 ), blocks[ 5000 ] );
+
+    for( auto block : blocks )
+    {
+        pool.deallocate( block, 48 );
+    }
+
+    // only the last slab of the size class is kept, until the pool is trimmed
+    ASSERT_EQ( pool.slabs_count(), 1u );
+    pool.trim();
+    ASSERT_EQ( pool.slabs_count(), 0u );
+
+    // and the next allocation makes a new one
+    pool.deallocate( pool.allocate( 48 ), 48 );
+    ASSERT_EQ( pool.slabs_count(), 1u );
+}
+
+TEST( MemoryPoolTest, ArenasFollowWorkers )
+{
+    details::memory_pool pool;
+    ASSERT_EQ( pool.arenas_count(), 1u );
+
+    pool.reserve_arenas( 3 );
+    ASSERT_EQ( pool.arenas_count(), 3u );
+
+    // arenas are only ever added
+    pool.reserve_arenas( 2 );
+    ASSERT_EQ( pool.arenas_count(), 3u );
+
+    pool.reserve_arenas( 1000 );
+    ASSERT_EQ( pool.arenas_count(), size_t{ details::memory_pool::max_arenas } );
+}
+
+TEST( MemoryPoolTest, ConcurrentThreads )
+{
+    details::memory_pool pool{ 4096, 2 };
+
+    // blocks allocated by one thread are freed by another one
+    std::vector< std::vector< uint64_t* > > blocks( 4 );
+    std::vector< std::thread > threads;
+
+    for( size_t thread_num = 0; thread_num < blocks.size(); ++thread_num )
+    {
+        threads.emplace_back( [ &, thread_num ]()
+                              {
+                                  for( uint64_t block_num = 0; block_num < 20000; ++block_num )
+                                  {
+                                      auto block = static_cast< uint64_t* >( pool.allocate( sizeof( uint64_t ) * 3 ) );
+                                      block[ 0 ] = block[ 2 ] = thread_num * 100000 + block_num;
+                                      blocks[ thread_num ].push_back( block );
+                                  }
+                              } );
+    }
+
+    for( auto& thread : threads )
+    {
+        thread.join();
+    }
+
+    threads.clear();
+
+    for( size_t thread_num = 0; thread_num < blocks.size(); ++thread_num )
+    {
+        threads.emplace_back( [ &, thread_num ]()
+                              {
+                                  const auto& owned = blocks[ ( thread_num + 1 ) % blocks.size() ];
+                                  for( size_t block_num = 0; block_num < owned.size(); ++block_num )
+                                  {
+                                      const uint64_t expected{ ( ( thread_num + 1 ) % blocks.size() ) * 100000 + block_num };
+                                      EXPECT_EQ( owned[ block_num ][ 0 ], expected );
+                                      EXPECT_EQ( owned[ block_num ][ 2 ], expected );
+                                      pool.deallocate( owned[ block_num ], sizeof( uint64_t ) * 3 );
+                                  }
+                              } );
+    }
+
+    for( auto& thread : threads )
+    {
+        thread.join();
+    }
+
+    ASSERT_LE( pool.slabs_count(), 2u );
+}
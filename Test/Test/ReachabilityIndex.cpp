@@ -0,0 +1,112 @@
+#include <random>
+
+#include "gtest/gtest.h"
+
+#include "GitBaseClasses.h"
+#include "Common/RepoFixture.h"
+
+using namespace git_handler;
+using test::make_id;
+
+class ReachabilityIndexTest : public test::repo_fixture{};
+
+TEST_F( ReachabilityIndexTest, Generations )
+{
+    //    1 - 2 - 4
+    //     \     /
+    //       3 -
+    base::reachability_index index;
+    base::reachability_index::batch commits;
+
+    // children may come before their parents
+    commits.add( make_id( 4 ), { make_id( 2 ), make_id( 3 ) } );
+    commits.add( make_id( 2 ), { make_id( 1 ) } );
+    commits.add( make_id( 3 ), { make_id( 1 ) } );
+    commits.add( make_id( 1 ), {} );
+    index.add( commits );
+
+    ASSERT_EQ( index.size(), 4u );
+    ASSERT_EQ( index.generation( make_id( 1 ) ), 1u );
+    ASSERT_EQ( index.generation( make_id( 2 ) ), 2u );
+    ASSERT_EQ( index.generation( make_id( 4 ) ), 3u );
+
+    ASSERT_TRUE( index.is_ancestor( make_id( 1 ), make_id( 4 ) ) );
+    ASSERT_TRUE( index.is_ancestor( make_id( 3 ), make_id( 4 ) ) );
+    ASSERT_TRUE( index.is_ancestor( make_id( 4 ), make_id( 4 ) ) );
+    ASSERT_FALSE( index.is_ancestor( make_id( 2 ), make_id( 3 ) ) );
+    ASSERT_FALSE( index.is_ancestor( make_id( 4 ), make_id( 1 ) ) );
+
+    index.set_tip( "refs/heads/master", make_id( 4 ) );
+    index.set_tip( "refs/heads/side", make_id( 3 ) );
+
+    ASSERT_EQ( index.branches_containing( make_id( 1 ) ),
+               ( std::vector< std::string >{ "refs/heads/master", "refs/heads/side" } ) );
+    ASSERT_EQ( index.branches_containing( make_id( 2 ) ), std::vector< std::string >{ "refs/heads/master" } );
+    ASSERT_FALSE( index.branch_contains( "refs/heads/side", make_id( 2 ) ) );
+
+    // an incomplete history is rejected and leaves the index as it was
+    base::reachability_index::batch orphan;
+    orphan.add( make_id( 6 ), { make_id( 5 ) } );
+    ASSERT_THROW( index.add( orphan ), std::logic_error );
+    ASSERT_EQ( index.size(), 4u );
+    ASSERT_FALSE( index.contains( make_id( 6 ) ) );
+}
+
+TEST_F( ReachabilityIndexTest, MatchesLibgit2 )
+{
+    test::repo_shape shape;
+    shape.commits = 400;
+    shape.branches = 5;
+    shape.merge_density = 0.3;
+
+    generate( shape );
+    mRepo->set_reachability_index( true );
+
+    base::repo_wrapper::branches branches;
+    mRepo->get_branches( branches, false, 2 );
+
+    // extending the histories goes through the incremental path
+    mSource->add_commits( 100 );
+    mRepo->get_branches( branches, false, 2 );
+
+    const auto index = mRepo->reachability();
+    ASSERT_TRUE( index != nullptr );
+
+    std::vector< git_oid > ids;
+    for( const auto& commit : branches.at( test::repo_generator::master_ref )->commits() )
+    {
+        ids.push_back( commit.id );
+    }
+
+    git_repository* raw_repo{ nullptr };
+    ASSERT_EQ( git_repository_open( &raw_repo, mSource->path().c_str() ), 0 );
+    auto git_repo = item::make_item< base::git_item_repo >( raw_repo );
+
+    std::mt19937 random{ 7 };
+    std::uniform_int_distribution< size_t > pick{ 0, ids.size() - 1 };
+
+    for( int query = 0; query < 500; ++query )
+    {
+        const auto& ancestor = ids[ pick( random ) ];
+        const auto& descendant = ids[ pick( random ) ];
+
+        const bool expected = git_oid_equal( &ancestor, &descendant ) ||
+                              git_graph_descendant_of( git_repo->get(), &descendant, &ancestor ) == 1;
+
+        ASSERT_EQ( index->is_ancestor( ancestor, descendant ), expected );
+    }
+
+    for( size_t id_num = 0; id_num < ids.size(); id_num += 10 )
+    {
+        std::vector< std::string > expected;
+        for( const auto& branch : branches )
+        {
+            if( branch.second->commits().contains( ids[ id_num ] ) )
+            {
+                expected.push_back( branch.second->ref_name() );
+            }
+        }
+
+        ASSERT_EQ( index->branches_containing( ids[ id_num ] ), expected );
+    }
+}
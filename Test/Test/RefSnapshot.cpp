@@ -0,0 +1,82 @@
+#include <algorithm>
+
+#include "gtest/gtest.h"
+
+#include "GitBaseClasses.h"
+#include "Common/RepoFixture.h"
+
+using namespace git_handler;
+using test::make_id;
+
+class RefSnapshotTest : public test::repo_fixture{};
+
+TEST_F( RefSnapshotTest, Diff )
+{
+    const base::ref_snapshot previous{ { { "refs/heads/b", make_id( 2 ) },
+                                         { "refs/heads/a", make_id( 1 ) },
+                                         { "refs/heads/c", make_id( 3 ) } } };
+
+    const base::ref_snapshot current{ { { "refs/heads/a", make_id( 1 ) },
+                                        { "refs/heads/c", make_id( 4 ) },
+                                        { "refs/heads/d", make_id( 5 ) } } };
+
+    ASSERT_EQ( previous.begin()->name, "refs/heads/a" );
+    ASSERT_TRUE( current.find( "refs/heads/b" ) == nullptr );
+    ASSERT_TRUE( current.find( "refs/heads/d" ) != nullptr );
+
+    const auto changes = current.diff( previous );
+    ASSERT_EQ( changes.size(), 3u );
+
+    const git_oid zero_id{};
+
+    // removed, moved and added, in name order
+    ASSERT_EQ( changes[ 0 ].name, "refs/heads/b" );
+    ASSERT_TRUE( git_oid_equal( &changes[ 0 ].new_tip, &zero_id ) );
+    ASSERT_EQ( changes[ 1 ].name, "refs/heads/c" );
+    ASSERT_EQ( changes[ 1 ].old_tip.id[ 0 ], 3 );
+    ASSERT_EQ( changes[ 1 ].new_tip.id[ 0 ], 4 );
+    ASSERT_EQ( changes[ 2 ].name, "refs/heads/d" );
+    ASSERT_TRUE( git_oid_equal( &changes[ 2 ].old_tip, &zero_id ) );
+
+    const auto copy = current;
+    ASSERT_TRUE( current.diff( copy ).empty() );
+
+    ASSERT_THROW( ( base::ref_snapshot{ { { "refs/heads/a", make_id( 1 ) }, { "refs/heads/a", make_id( 2 ) } } } ),
+                  std::logic_error );
+}
+
+TEST_F( RefSnapshotTest, ReadsOnlyBranches )
+{
+    test::repo_shape shape;
+    shape.commits = 100;
+    shape.branches = 3;
+
+    generate( shape );
+    mSource->add_refs( "refs/tags/tag_", 50 );
+    mSource->add_refs( "refs/pull/", 50 );
+
+    const auto previous = mRepo->snapshot_refs();
+    ASSERT_EQ( previous.size(), mSource->ref_names().size() );
+
+    for( const auto& name : mSource->ref_names() )
+    {
+        const auto ref = previous.find( name );
+        ASSERT_TRUE( ref != nullptr );
+
+        const git_oid tip = mSource->tip( name );
+        ASSERT_TRUE( git_oid_equal( &ref->tip, &tip ) );
+    }
+
+    base::repo_wrapper::branches branches;
+    mRepo->get_branches( branches );
+    ASSERT_EQ( branches.size(), previous.size() );
+
+    mSource->add_commits( 10 );
+    mSource->add_refs( "refs/heads/new_", 1 );
+
+    const auto changes = mRepo->snapshot_refs().diff( previous );
+    ASSERT_FALSE( changes.empty() );
+    ASSERT_TRUE( std::any_of( changes.begin(), changes.end(),
+                              []( const base::ref_snapshot::ref_change& change ){ return change.name == "refs/heads/new_0"; } ) );
+    ASSERT_TRUE( mRepo->snapshot_refs( true ).empty() );
+}
@@ -0,0 +1,157 @@
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "GitHandler.h"
+#include "Common/RepoGenerator.h"
+
+using namespace git_handler;
+
+namespace
+{
+
+using clock = base::fetch_scheduler::clock;
+
+std::vector< std::string > acquire_all( base::fetch_scheduler& scheduler, const clock::time_point now )
+{
+    std::vector< std::string > paths;
+    std::string path;
+
+    scheduler.start_round( now );
+    while( scheduler.acquire( path ) )
+    {
+        paths.push_back( path );
+        scheduler.complete( path, base::fetch_outcome::unchanged, now );
+    }
+
+    return paths;
+}
+
+}
+
+TEST( SchedulerTest, RemoteHost )
+{
+    ASSERT_EQ( base::fetch_scheduler::remote_host( "https://user@github.com:443/a/b.git" ), "github.com" );
+    ASSERT_EQ( base::fetch_scheduler::remote_host( "ssh://git@[::1]:22/a.git" ), "::1" );
+    ASSERT_EQ( base::fetch_scheduler::remote_host( "git@gitlab.com:a/b.git" ), "gitlab.com" );
+    ASSERT_EQ( base::fetch_scheduler::remote_host( "file:///tmp/a.git" ), "" );
+    ASSERT_EQ( base::fetch_scheduler::remote_host( "/tmp/a.git" ), "" );
+    ASSERT_EQ( base::fetch_scheduler::remote_host( "C:/repos/a.git" ), "" );
+    ASSERT_EQ( base::fetch_scheduler::remote_host( "d:\\repos\\a.git" ), "" );
+    ASSERT_EQ( base::fetch_scheduler::remote_host( "repos\\a:b" ), "" );
+}
+
+TEST( SchedulerTest, AdaptsIntervals )
+{
+    base::schedule_options options;
+    options.min_interval = std::chrono::seconds{ 10 };
+    options.initial_interval = std::chrono::seconds{ 100 };
+    options.max_interval = std::chrono::seconds{ 1000 };
+    options.backoff = 2.0;
+    options.speedup = 0.5;
+    options.failure_backoff = 3.0;
+
+    base::fetch_scheduler scheduler{ options };
+    scheduler.add( "busy", {} );
+    scheduler.add( "idle", {} );
+    scheduler.add( "broken", {} );
+
+    const auto now = clock::now();
+    scheduler.start_round( now );
+
+    std::string path;
+    std::map< std::string, base::fetch_outcome > outcomes{ { "busy", base::fetch_outcome::changed },
+                                                           { "idle", base::fetch_outcome::unchanged },
+                                                           { "broken", base::fetch_outcome::failed } };
+    while( scheduler.acquire( path ) )
+    {
+        scheduler.complete( path, outcomes.at( path ), now );
+    }
+
+    ASSERT_EQ( scheduler.state( "busy" ).interval, std::chrono::seconds{ 50 } );
+    ASSERT_EQ( scheduler.state( "idle" ).interval, std::chrono::seconds{ 200 } );
+
+    // failures keep the interval but delay the retries more and more
+    const auto broken = scheduler.state( "broken" );
+    ASSERT_EQ( broken.interval, std::chrono::seconds{ 100 } );
+    ASSERT_EQ( broken.failures, 1u );
+    ASSERT_EQ( broken.next_fetch - now, std::chrono::seconds{ 300 } );
+
+    // only the busy repo is due after its shortened interval
+    ASSERT_EQ( acquire_all( scheduler, now + std::chrono::seconds{ 60 } ), std::vector< std::string >{ "busy" } );
+    ASSERT_TRUE( acquire_all( scheduler, now + std::chrono::seconds{ 60 } ).empty() );
+}
+
+TEST( SchedulerTest, PriorityAndCaps )
+{
+    base::schedule_options options;
+    options.max_concurrent = 3;
+    options.max_per_host = 1;
+
+    base::fetch_scheduler scheduler{ options };
+    scheduler.add( "a1", { "a.com" } );
+    scheduler.add( "a2", { "a.com" } );
+    scheduler.add( "b1", { "b.com" } );
+    scheduler.add( "local1", {} );
+    scheduler.add( "local2", {} );
+    scheduler.set_priority( "local2", 10 );
+
+    scheduler.start_round( clock::now() );
+
+    // the highest priority goes first, then a single repo per host within the global cap
+    std::vector< std::string > running( 3 );
+    for( auto& path : running )
+    {
+        ASSERT_TRUE( scheduler.acquire( path ) );
+    }
+
+    ASSERT_EQ( running, ( std::vector< std::string >{ "local2", "a1", "b1" } ) );
+
+    // a blocked worker waits for a running fetch to complete
+    std::string next;
+    std::thread worker{ [ & ](){ scheduler.acquire( next ); } };
+
+    std::this_thread::sleep_for( std::chrono::milliseconds{ 20 } );
+    ASSERT_TRUE( next.empty() );
+
+    scheduler.complete( "a1", base::fetch_outcome::unchanged, clock::now() );
+    worker.join();
+
+    ASSERT_EQ( next, "a2" );
+}
+
+TEST( SchedulerTest, UpdateScheduled )
+{
+    test::temp_path dir;
+    test::repo_shape shape;
+    shape.commits = 50;
+
+    test::repo_generator source{ dir.sub( "source.git" ), shape };
+
+    git_handler::git_handler handler;
+    for( const auto name : { "first", "second" } )
+    {
+        auto repo = std::make_unique< base::repo_wrapper >();
+        repo->clone( source.url(), dir.sub( name ) );
+        ASSERT_TRUE( handler.add_repo( std::move( repo ), "", "" ) );
+    }
+
+    // new repos are due right away, afterwards they wait for their interval
+    auto results = handler.update_scheduled( 2 );
+    ASSERT_EQ( results.size(), 2u );
+
+    for( const auto& result : results )
+    {
+        ASSERT_TRUE( result.second.ok ) << result.second.error;
+        ASSERT_FALSE( result.second.changed );
+    }
+
+    ASSERT_TRUE( handler.update_scheduled( 2 ).empty() );
+    ASSERT_EQ( handler.update().size(), 2u );
+
+    // no workers runs the round on a single one instead of skipping it
+    auto repo = std::make_unique< base::repo_wrapper >();
+    repo->clone( source.url(), dir.sub( "third" ) );
+    ASSERT_TRUE( handler.add_repo( std::move( repo ), "", "" ) );
+    ASSERT_EQ( handler.update_scheduled( 0 ).size(), 1u );
+}
@@ -1,13 +0,0 @@
-#ifndef TESTARGS_H
-#define TESTARGS_H
-
-#include <string>
-
-struct TestArgs
-{
-  std::string localRepoPath;
-  std::string remoteRepoUrl;
-  std::string remoteRepoLocalPath;
-};
-
-#endif